@@ -0,0 +1,94 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include "clock.h"
+
+// DIVM and DIVS for each speed: SMCLK stays at CLOCK_SMCLK_HZ in both
+#if CLOCK_SMCLK_DIV == 8
+#define CLOCK_DIV_FAST  (DIVM__1 | DIVS__8)
+#define CLOCK_DIV_SLOW  (DIVM__8 | DIVS__1)
+#elif CLOCK_SMCLK_DIV == 4
+#define CLOCK_DIV_FAST  (DIVM__1 | DIVS__4)
+#define CLOCK_DIV_SLOW  (DIVM__4 | DIVS__1)
+#else
+#error "CLOCK_SMCLK_DIV must be 4 or 8"
+#endif
+
+//----------------------------------------------------------------------
+// Begin Clock Initialization
+//----------------------------------------------------------------------
+// Call first in main: the FRAM wait states must be set before MCLK goes
+// above 8 MHz.
+void clock_init(void)
+{
+    WDTCTL = WDTPW | WDTHOLD;               // Stop watchdog timer
+
+    FRCTL0 = FRCTLPW | CLOCK_NWAITS;
+
+    __bis_SR_register(SCG0);                // FLL off while it is set up
+    CSCTL3 = SELREF__REFOCLK;               // FLL reference = REFO
+    CSCTL0 = 0;                             // Clear DCO and MOD
+    CSCTL1 = (CSCTL1 & ~DCORSEL_7) | CLOCK_DCORSEL; // DCO range
+    CSCTL2 = FLLD_0 + (CLOCK_MCLK_HZ / CLOCK_REFO_HZ - 1);  // DCOCLKDIV = (N + 1) * REFO
+    __delay_cycles(3);
+    __bic_SR_register(SCG0);                // FLL on
+    while (CSCTL7 & (FLLUNLOCK0 | FLLUNLOCK1)) {
+    }
+
+    CSCTL4 = SELMS__DCOCLKDIV | SELA__REFOCLK;
+    CSCTL5 = (CSCTL5 & ~(DIVM_7 | DIVS_3)) | CLOCK_DIV_FAST;
+}
+//--End Clock Initialization--------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Set Speed
+//----------------------------------------------------------------------
+// One write moves the divider between MCLK and SMCLK, so SMCLK never
+// glitches to another rate.
+void clock_set_speed(clock_speed_t speed)
+{
+    CSCTL5 = (CSCTL5 & ~(DIVM_7 | DIVS_3)) | (speed == CLOCK_SLOW ? CLOCK_DIV_SLOW : CLOCK_DIV_FAST);
+}
+
+// Read back from the divider, so it is right whoever set it
+clock_speed_t clock_speed(void)
+{
+    return (CSCTL5 & DIVM_7) == DIVM__1 ? CLOCK_FAST : CLOCK_SLOW;
+}
+//--End Set Speed-------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin UART Divider
+//----------------------------------------------------------------------
+// eUSCI_A UART divider for `baud` from SMCLK, per the user's guide
+// "Baud-Rate Settings" procedure: oversampling when N >= 16, and UCBRSx
+// from the fractional part of N via the guide's table (fractions in
+// 1/10000).
+static const unsigned int brs_fraction[] = {
+       0,  529,  715,  835, 1001, 1252, 1430, 1670, 2147, 2224, 2503, 3000,
+    3335, 3575, 3753, 4003, 4286, 4378, 5002, 5715, 6003, 6254, 6432, 6667,
+    7001, 7147, 7503, 7861, 8004, 8333, 8464, 8572, 8751, 9004, 9170, 9288
+};
+static const unsigned char brs_value[] = {
+    0x00, 0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x11, 0x21, 0x22, 0x44, 0x25,
+    0x49, 0x4A, 0x52, 0x92, 0x53, 0x55, 0xAA, 0x6B, 0xAD, 0xB5, 0xB6, 0xD6,
+    0xB7, 0xBB, 0xDD, 0xED, 0xEE, 0xBF, 0xDF, 0xEF, 0xF7, 0xFB, 0xFD, 0xFE
+};
+
+void clock_uart_divider(unsigned long baud, unsigned int *brw, unsigned int *mctlw)
+{
+    unsigned int n = CLOCK_SMCLK_HZ / baud;
+    unsigned int fraction = (CLOCK_SMCLK_HZ % baud) * 10000UL / baud;
+    unsigned char i = 0;
+
+    while (i + 1 < sizeof(brs_fraction) / sizeof(brs_fraction[0]) && brs_fraction[i + 1] <= fraction) {
+        i++;
+    }
+    if (n >= 16) {
+        *brw = n / 16;
+        *mctlw = ((unsigned int)brs_value[i] << 8) | ((n % 16) << 4) | UCOS16;
+    } else {
+        *brw = n;
+        *mctlw = (unsigned int)brs_value[i] << 8;
+    }
+}
+//--End UART Divider----------------------------------------------------
@@ -0,0 +1,56 @@
+/**
+ * @file
+ * @brief Clock system setup and the timing constants derived from it.
+ *
+ * MCLK runs from the FLL-locked DCO (REFO reference) at CLOCK_MCLK_HZ:
+ * 24 MHz on the FR2355 controller, 16 MHz on the FR2310 slaves. SMCLK is
+ * MCLK / CLOCK_SMCLK_DIV and ACLK is REFO. Every delay and peripheral
+ * divider in the firmwares comes from the macros below, so changing a
+ * frequency here retimes all of them.
+ *
+ * clock_set_speed(CLOCK_SLOW) moves the SMCLK divider onto MCLK instead,
+ * so the CPU runs at CLOCK_SMCLK_HZ while SMCLK, and every timer, baud
+ * rate and I2C clock built on it, keeps its rate. __delay_cycles() counts
+ * assume CLOCK_FAST and only get longer when slow, which is safe for the
+ * minimum waits they implement.
+ */
+#ifndef CLOCK_H
+#define CLOCK_H
+
+#include <msp430.h>
+
+#if defined(__MSP430FR2355__)
+#define CLOCK_MCLK_HZ       24000000UL
+#define CLOCK_DCORSEL       DCORSEL_7   // DCO range up to 24 MHz
+#define CLOCK_NWAITS        NWAITS_2    // FRAM wait states above 16 MHz
+#else // MSP430FR2310
+#define CLOCK_MCLK_HZ       16000000UL
+#define CLOCK_DCORSEL       DCORSEL_5   // DCO range up to 16 MHz
+#define CLOCK_NWAITS        NWAITS_1    // FRAM wait state above 8 MHz
+#endif
+
+#define CLOCK_SMCLK_DIV     8
+#define CLOCK_SMCLK_HZ      (CLOCK_MCLK_HZ / CLOCK_SMCLK_DIV)
+#define CLOCK_ACLK_HZ       32768UL
+#define CLOCK_REFO_HZ       32768UL
+
+// MCLK cycles for __delay_cycles(), rounded up
+#define CLOCK_CYCLES_US(us) ((unsigned long)(us) * (CLOCK_MCLK_HZ / 1000000UL))
+#define CLOCK_CYCLES_NS(ns) (((unsigned long)(ns) * (CLOCK_MCLK_HZ / 1000000UL) + 999) / 1000)
+
+// SMCLK ticks, for timers sourced from SMCLK
+#define CLOCK_SMCLK_MHZ     (CLOCK_SMCLK_HZ / 1000000UL)
+#define CLOCK_SMCLK_US(us)  ((unsigned int)((us) * CLOCK_SMCLK_MHZ))
+
+typedef enum
+{
+    CLOCK_FAST,                     // MCLK = CLOCK_MCLK_HZ
+    CLOCK_SLOW                      // MCLK = CLOCK_SMCLK_HZ
+} clock_speed_t;
+
+void clock_init(void);
+void clock_set_speed(clock_speed_t speed);
+clock_speed_t clock_speed(void);
+void clock_uart_divider(unsigned long baud, unsigned int *brw, unsigned int *mctlw);
+
+#endif // CLOCK_H
@@ -0,0 +1,77 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include "event.h"
+#include "ring.h"
+
+// Producers (ISRs) only advance head, main only advances tail
+RING_CHECK_SIZE(event, EVENT_QUEUE_SIZE);
+static event_t queue[EVENT_QUEUE_SIZE];
+static volatile unsigned char head, tail;
+#ifdef EVENT_STATS
+volatile unsigned char event_high_water;
+volatile unsigned int event_dropped;
+#endif
+
+//------------------------------------------------------------------------------
+// Begin Post
+//------------------------------------------------------------------------------
+// Copy up to EVENT_DATA_MAX bytes of data into a new event. Returns false if
+// the queue is full and the event was dropped.
+bool event_post(unsigned char type, const void *data, unsigned char length)
+{
+    event_t *event;
+    const unsigned char *src = data;
+    unsigned char depth = RING_USED(head, tail);
+    unsigned char i;
+
+    if (depth >= EVENT_QUEUE_SIZE) {
+#ifdef EVENT_STATS
+        event_dropped++;
+#endif
+        return false;
+    }
+    event = &queue[RING_SLOT(head, EVENT_QUEUE_SIZE)];
+    event->type = type;
+    for (i = 0; i < length && i < EVENT_DATA_MAX; i++) {
+        event->data[i] = src[i];
+    }
+    head++;                             // Publish after the slot is written
+#ifdef EVENT_STATS
+    if (++depth > event_high_water) {
+        event_high_water = depth;
+    }
+#endif
+    return true;
+}
+//--End Post--------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Get
+//------------------------------------------------------------------------------
+// Take the oldest event. Returns false when none is pending.
+bool event_get(event_t *event)
+{
+    if (tail == head) {
+        return false;
+    }
+    *event = queue[RING_SLOT(tail, EVENT_QUEUE_SIZE)];
+    tail++;
+    return true;
+}
+//--End Get---------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Sleep
+//------------------------------------------------------------------------------
+// LPM0 until an ISR posts and wakes main. The check and the sleep happen with
+// interrupts off, so an event posted in between cannot be missed.
+void event_sleep(void)
+{
+    __disable_interrupt();
+    if (tail == head) {
+        __bis_SR_register(LPM0_bits | GIE);
+    } else {
+        __enable_interrupt();
+    }
+}
+//--End Sleep-------------------------------------------------------------------
@@ -0,0 +1,48 @@
+/**
+ * @file
+ * @brief Run-to-completion event queue for the slave firmwares.
+ *
+ * Interrupt handlers only capture what happened and post an event; main
+ * takes events one at a time, runs each handler to completion, and sleeps
+ * in LPM0 when the queue is empty. Application state is then only ever
+ * touched from main, so ISRs and handlers never race on it.
+ *
+ * Post only from ISRs (they do not nest) or with interrupts disabled.
+ *
+ * Define EVENT_STATS (like TRACE_ENABLE) to count queue depth and drops
+ * while sizing EVENT_QUEUE_SIZE; otherwise the counters compile away.
+ */
+#ifndef EVENT_H
+#define EVENT_H
+
+#include <stdbool.h>
+
+#define EVENT_QUEUE_SIZE    8       // Pending events, power of two
+#define EVENT_DATA_MAX      6       // Enough for an i2c_frame_t
+
+// Event types. EVENT_APP and up are free for each firmware to define.
+#define EVENT_FRAME         0x01    // data: i2c_frame_t from the controller
+#define EVENT_APP           0x10
+
+// Use inside the ISR that posted: wakes main from event_sleep()
+#define EVENT_WAKE_ON_EXIT()    __bic_SR_register_on_exit(LPM3_bits)
+
+typedef struct
+{
+    unsigned char type;
+    unsigned char data[EVENT_DATA_MAX];
+} event_t;
+
+bool event_post(unsigned char type, const void *data, unsigned char length);
+bool event_get(event_t *event);
+void event_sleep(void);
+
+#ifdef EVENT_STATS
+/** Deepest the queue has been since reset, for sizing EVENT_QUEUE_SIZE */
+extern volatile unsigned char event_high_water;
+
+/** Events lost to a full queue */
+extern volatile unsigned int event_dropped;
+#endif
+
+#endif // EVENT_H
@@ -0,0 +1,33 @@
+/**
+ * @file
+ * @brief Port setup shared by all three firmwares.
+ *
+ * Macros over the device headers' PxOUT/PxDIR/PxSELx registers, so they
+ * compile to the same one or two bit operations as writing the registers
+ * by hand, with no code or RAM of their own. `port` is the port number,
+ * `pins` a mask of BITn.
+ */
+#ifndef GPIO_H
+#define GPIO_H
+
+#include <msp430.h>
+
+// Release the pins from their power-on high-impedance state. Idempotent,
+// so each driver that needs its pins may call it.
+#define GPIO_UNLOCK()               (PM5CTL0 &= ~LOCKLPM5)
+
+// Drive `pins` low as outputs
+#define GPIO_OUTPUT_LOW(port, pins)                     \
+    do {                                                \
+        P##port##OUT &= ~(pins);                        \
+        P##port##DIR |= (pins);                         \
+    } while (0)
+
+// Hand `pins` to their primary peripheral function (eUSCI, timer output)
+#define GPIO_PRIMARY(port, pins)                        \
+    do {                                                \
+        P##port##SEL1 &= ~(pins);                       \
+        P##port##SEL0 |= (pins);                        \
+    } while (0)
+
+#endif // GPIO_H
@@ -0,0 +1,38 @@
+/**
+ * @file
+ * @brief Check reporting and a repeatable random source for the host
+ *        tests and benchmarks.
+ *
+ * report() prints one line per check and counts the ones that fail; a
+ * test's main returns `failures != 0`. Define HOST_TEST_SEED before
+ * including this to get rand_below(), the same LCG in every test, so
+ * each test keeps its own repeatable sequence.
+ */
+#ifndef HOST_TEST_H
+#define HOST_TEST_H
+
+#include <stdio.h>
+
+static int failures;                    // Checks that have failed
+
+// Returns 1 if the check failed, for tests that also keep their own count
+static inline int report(const char *name, int ok)
+{
+    printf("%-52s %s\n", name, ok ? "ok" : "FAIL");
+    if (!ok) {
+        failures++;
+    }
+    return !ok;
+}
+
+#ifdef HOST_TEST_SEED
+static unsigned long rng = HOST_TEST_SEED;
+
+static inline unsigned int rand_below(unsigned int n)
+{
+    rng = rng * 1103515245UL + 12345UL;
+    return (unsigned int)((rng >> 16) % n);
+}
+#endif
+
+#endif // HOST_TEST_H
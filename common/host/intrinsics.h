@@ -0,0 +1,27 @@
+/**
+ * @file
+ * @brief Host stand-in for the TI compiler intrinsics.
+ *
+ * The status register is modelled as a variable so code that saves and
+ * restores GIE behaves, and __delay_cycles() adds to a cycle counter a test
+ * can read to see how long firmware would have spun.
+ */
+#ifndef HOST_INTRINSICS_H
+#define HOST_INTRINSICS_H
+
+extern unsigned int host_sr;                // Modelled status register
+extern unsigned long host_delay_cycles;     // Sum of all __delay_cycles()
+
+#define __even_in_range(x, y)   (x)
+#define __delay_cycles(n)       (host_delay_cycles += (n))
+#define __no_operation()        ((void)0)
+#define __enable_interrupt()    (host_sr |= GIE)
+#define _enable_interrupt()     (host_sr |= GIE)
+#define __disable_interrupt()   (host_sr &= ~GIE)
+#define __get_SR_register()     (host_sr)
+#define __bis_SR_register(x)    (host_sr |= (x) & GIE)
+#define __bic_SR_register(x)    (host_sr &= ~(x))
+#define __bic_SR_register_on_exit(x) ((void)(x))
+#define __bis_SR_register_on_exit(x) ((void)(x))
+
+#endif // HOST_INTRINSICS_H
@@ -0,0 +1,127 @@
+/**
+ * @file
+ * @brief Host stand-in for the TI device headers.
+ *
+ * Lets firmware modules build with the host compiler so their logic can be
+ * tested and benchmarked without a board. Peripheral registers become plain
+ * variables (see msp430_regs.def) that a test can preload or inspect, and a
+ * test "fires" an interrupt by setting the IV register and calling the ISR
+ * function directly. Only the bits the firmware actually uses are defined.
+ *
+ * Build with `-I common/host` ahead of the project include paths and link
+ * common/host/msp430_host.c.
+ */
+#ifndef HOST_MSP430_H
+#define HOST_MSP430_H
+
+#define HOST_REG(name) extern volatile unsigned int name;
+#include "msp430_regs.def"
+#undef HOST_REG
+
+// Interrupt keyword and vector pragmas have no meaning on the host
+#define __interrupt
+
+#define BIT0 0x0001
+#define BIT1 0x0002
+#define BIT2 0x0004
+#define BIT3 0x0008
+#define BIT4 0x0010
+#define BIT5 0x0020
+#define BIT6 0x0040
+#define BIT7 0x0080
+
+#define WDTPW    0x5A00
+#define WDTHOLD  0x0080
+#define LOCKLPM5 0x0001
+
+// FRAM write protection, reset cause
+#define FRWPPW          0xA500
+#define PFWP            0x0001
+#define DFWP            0x0002
+#define SYSRSTIV_NONE   0x0000
+#define SYSRSTIV_BOR    0x0002
+
+#define GIE       0x0008
+#define CPUOFF    0x0010
+#define OSCOFF    0x0020
+#define SCG0      0x0040
+#define SCG1      0x0080
+#define LPM0_bits (CPUOFF)
+#define LPM3_bits (SCG1 | SCG0 | CPUOFF)
+
+// Timer_B
+#define TBCLR           0x0004
+#define TBIFG           0x0001
+#define TBIE            0x0002
+#define TBSSEL__ACLK    0x0100
+#define TBSSEL__SMCLK   0x0200
+#define MC__STOP        0x0000
+#define MC__UP          0x0010
+#define MC__CONTINUOUS  0x0020
+#define CCIFG           0x0001
+#define CCIE            0x0010
+#define OUTMOD_0        0x0000
+#define OUTMOD_7        0x00E0
+#define CLLD_1          0x0200
+#define TB3IV_TBIFG     0x000E
+
+// ADC
+#define ADCSC           0x0001
+#define ADCENC          0x0002
+#define ADCON           0x0010
+#define ADCSHT_2        0x0200
+#define ADCCONSEQ_2     0x0004
+#define ADCSHP          0x0200
+#define ADCSHS_1        0x0400
+#define ADCRES_2        0x0020
+#define ADCINCH_4       0x0004
+#define ADCSREF_0       0x0000
+#define ADCIFG0         0x0001
+#define ADCIE0          0x0001
+#define ADCIV_ADCIFG    0x000C
+
+// eUSCI_B I2C
+#define UCSWRST   0x0001
+#define UCTXSTT   0x0002
+#define UCTXSTP   0x0004
+#define UCTXNACK  0x0008
+#define UCTR      0x0010
+#define UCTXACK   0x0020
+#define UCSSEL_3  0x00C0
+#define UCMODE_3  0x0600
+#define UCMST     0x0800
+#define UCASTP_2  0x0008
+#define UCOAEN    0x0400
+
+#define UCRXIE0   0x0001
+#define UCTXIE0   0x0002
+#define UCSTTIE   0x0004
+#define UCSTPIE   0x0008
+#define UCNACKIE  0x0020
+#define UCRXIE    UCRXIE0
+#define UCRXIFG0  0x0001
+#define UCTXIFG0  0x0002
+#define UCSTTIFG  0x0004
+#define UCSTPIFG  0x0008
+#define UCNACKIFG 0x0020
+
+// eUSCI_A UART
+#define UCSSEL__SMCLK   0x0080
+#define UCTXIE          0x0002
+#define UCTXIFG         0x0002
+#define UCBUSY          0x0001
+
+#define USCI_NONE           0x00
+#define USCI_UART_UCTXIFG       0x04
+#define USCI_UART_UCTXCPTIFG    0x08
+#define USCI_I2C_UCALIFG    0x02
+#define USCI_I2C_UCNACKIFG  0x04
+#define USCI_I2C_UCSTTIFG   0x06
+#define USCI_I2C_UCSTPIFG   0x08
+#define USCI_I2C_UCRXIFG0   0x16
+#define USCI_I2C_UCTXIFG0   0x18
+#define USCI_I2C_UCBCNTIFG  0x1A
+#define USCI_I2C_UCCLTOIFG  0x1C
+#define USCI_I2C_UCBIT9IFG  0x1E
+
+#endif // HOST_MSP430_H
@@ -0,0 +1,13 @@
+/**
+ * @file
+ * @brief Storage for the host register and intrinsic models.
+ */
+#include <msp430.h>
+#include "intrinsics.h"
+
+#define HOST_REG(name) volatile unsigned int name;
+#include "msp430_regs.def"
+#undef HOST_REG
+
+unsigned int host_sr;
+unsigned long host_delay_cycles;
@@ -0,0 +1,2 @@
+// Host stand-in: every device maps onto the same register model
+#include <msp430.h>
@@ -0,0 +1,100 @@
+#include "i2c_frame.h"
+
+//------------------------------------------------------------------------------
+// Begin CRC-8
+//------------------------------------------------------------------------------
+// Nibble-wide table: two lookups per byte keeps the slave RX ISR short
+// without spending 256 bytes of FR2310 FRAM on a full table.
+static const unsigned char crc8_nibble[16] = {
+    0x00, 0x07, 0x0E, 0x09, 0x1C, 0x1B, 0x12, 0x15,
+    0x38, 0x3F, 0x36, 0x31, 0x24, 0x23, 0x2A, 0x2D
+};
+
+unsigned char crc8_update(unsigned char crc, unsigned char byte)
+{
+    crc ^= byte;
+    crc = (unsigned char)(crc << 4) ^ crc8_nibble[crc >> 4];
+    crc = (unsigned char)(crc << 4) ^ crc8_nibble[crc >> 4];
+    return crc;
+}
+//--End CRC-8-------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Frame Encode
+//------------------------------------------------------------------------------
+// Build a frame in buf (at least FRAME_MAX_SIZE bytes). Returns the number of
+// bytes to send, or 0 if the payload is too long.
+unsigned char i2c_frame_encode(unsigned char *buf, unsigned char opcode, const unsigned char *payload,
+                               unsigned char length)
+{
+    unsigned char i;
+    unsigned char crc;
+
+    if (length > FRAME_MAX_PAYLOAD)
+    {
+        return 0;
+    }
+    buf[0] = opcode;
+    buf[1] = length;
+    crc = crc8_update(crc8_update(0, opcode), length);
+    for (i = 0; i < length; i++)
+    {
+        buf[2 + i] = payload[i];
+        crc = crc8_update(crc, payload[i]);
+    }
+    buf[2 + length] = crc;
+    return length + FRAME_OVERHEAD;
+}
+//--End Frame Encode------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Frame Parser
+//------------------------------------------------------------------------------
+// Call on every START so a frame cut short by the bus never bleeds into the
+// next transaction.
+void i2c_frame_reset(i2c_frame_parser_t *parser)
+{
+    parser->index = 0;
+    parser->crc = 0;
+}
+
+// Feed one received byte. Returns true when it completes a frame with a good
+// CRC; parser->frame then holds it until the next byte arrives.
+bool i2c_frame_feed(i2c_frame_parser_t *parser, unsigned char byte)
+{
+    unsigned char index = parser->index;
+
+    if (index == 0)
+    {
+        parser->frame.opcode = byte;
+    }
+    else if (index == 1)
+    {
+        if (byte > FRAME_MAX_PAYLOAD)
+        {
+            parser->errors++;
+            i2c_frame_reset(parser);
+            return false;
+        }
+        parser->frame.length = byte;
+    }
+    else if (index - 2 < parser->frame.length)
+    {
+        parser->frame.payload[index - 2] = byte;
+    }
+    else
+    {
+        // CRC byte closes the frame either way
+        bool good = (parser->crc == byte);
+        if (!good)
+        {
+            parser->errors++;
+        }
+        i2c_frame_reset(parser);
+        return good;
+    }
+    parser->crc = crc8_update(parser->crc, byte);
+    parser->index = index + 1;
+    return false;
+}
+//--End Frame Parser------------------------------------------------------------
@@ -0,0 +1,61 @@
+/**
+ * @file
+ * @brief Framed command protocol shared by the controller and the slaves.
+ *
+ * Every I2C transaction carries one frame:
+ *
+ *     opcode | length | payload[length] | crc8
+ *
+ * The CRC-8 (polynomial 0x07, init 0x00) covers opcode, length and payload.
+ * Multi-byte payload values are little-endian.
+ */
+#ifndef I2C_FRAME_H
+#define I2C_FRAME_H
+
+#include <stdbool.h>
+
+#define FRAME_MAX_PAYLOAD   4
+#define FRAME_OVERHEAD      3       // opcode, length, crc8
+#define FRAME_MAX_SIZE      (FRAME_MAX_PAYLOAD + FRAME_OVERHEAD)
+
+// Opcodes and their payloads
+#define FRAME_OP_KEY         0x01   // char key, raw keypad press
+#define FRAME_OP_SET_WINDOW  0x02   // uint16 window size, samples, uint8 filter (TEMP_FILTER_*)
+#define FRAME_OP_TEMPERATURE 0x03   // int16 averaged temperature in 0.1 deg, char unit 'C'/'F'
+#define FRAME_OP_SET_PATTERN 0x04   // uint8 LED pattern number, 0-7
+#define FRAME_OP_UNLOCK      0x05   // none
+#define FRAME_OP_LOCK        0x06   // none
+#define FRAME_OP_TRACE_DUMP  0x07   // none, send the ISR trace (TRACE_ENABLE builds)
+
+typedef struct
+{
+    unsigned char opcode;
+    unsigned char length;
+    unsigned char payload[FRAME_MAX_PAYLOAD];
+} i2c_frame_t;
+
+/**
+ * Byte-at-a-time frame receiver, fed from the slave RX interrupt.
+ */
+typedef struct
+{
+    /** Bytes of the current frame received so far */
+    unsigned char index;
+
+    /** Running CRC of the current frame */
+    unsigned char crc;
+
+    /** Frame being assembled; valid once i2c_frame_feed() returns true */
+    i2c_frame_t frame;
+
+    /** Frames thrown away for a bad length or CRC */
+    unsigned int errors;
+} i2c_frame_parser_t;
+
+unsigned char crc8_update(unsigned char crc, unsigned char byte);
+unsigned char i2c_frame_encode(unsigned char *buf, unsigned char opcode, const unsigned char *payload,
+                               unsigned char length);
+void i2c_frame_reset(i2c_frame_parser_t *parser);
+bool i2c_frame_feed(i2c_frame_parser_t *parser, unsigned char byte);
+
+#endif // I2C_FRAME_H
@@ -0,0 +1,58 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include "i2c_slave.h"
+#include "event.h"
+#include "gpio.h"
+#include "trace.h"
+
+i2c_frame_parser_t i2c_slave_rx;
+
+//------------------------------------------------------------------------------
+// Begin I2C Slave Initialization
+//------------------------------------------------------------------------------
+// Answer at `address` and enable interrupts. Call last in a slave's init,
+// once main is ready for EVENT_FRAME.
+void i2c_slave_init(unsigned char address)
+{
+    GPIO_PRIMARY(1, BIT2 | BIT3);       // P1.2 SDA, P1.3 SCL
+
+    UCB0CTLW0 |= UCSWRST;               // Put eUSCI_B0 into software reset
+    UCB0CTLW0 |= UCMODE_3;              // Select I2C slave mode
+    UCB0I2COA0 = address | UCOAEN;      // Set and enable first own address
+    UCB0CTLW0 |= UCTXACK;               // Send ACKs
+
+    GPIO_UNLOCK();
+
+    UCB0CTLW0 &= ~UCSWRST;              // Pull eUSCI_B0 out of software reset
+    UCB0IE |= UCSTTIE | UCRXIE;         // Enable Start and RX interrupts
+
+    __enable_interrupt();
+}
+//--End I2C Slave Initialization------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Interrupt Service Routine
+//------------------------------------------------------------------------------
+#pragma vector = USCI_B0_VECTOR
+__interrupt void USCI_B0_ISR(void)
+{
+    TRACE_ENTER(TRACE_I2C_SLAVE);
+    switch (__even_in_range(UCB0IV, USCI_I2C_UCTXIFG0))
+    {
+        case USCI_I2C_UCSTTIFG:         // START: a new frame begins
+            i2c_frame_reset(&i2c_slave_rx);
+            break;
+        case USCI_I2C_UCRXIFG0:         // Receive Interrupt
+            if (i2c_frame_feed(&i2c_slave_rx, UCB0RXBUF))
+            {
+                event_post(EVENT_FRAME, &i2c_slave_rx.frame, sizeof(i2c_slave_rx.frame));
+                EVENT_WAKE_ON_EXIT();
+            }
+            break;
+        default:
+            break;
+    }
+    TRACE_EXIT(TRACE_I2C_SLAVE);
+}
+//--End Interrupt Service Routine-----------------------------------------------
@@ -0,0 +1,21 @@
+/**
+ * @file
+ * @brief eUSCI_B0 I2C slave receiving framed commands, for the FR2310
+ *        slaves.
+ *
+ * The receive ISR feeds each byte to the i2c_frame parser and posts a
+ * whole, CRC-checked frame to main as EVENT_FRAME (common/event.h), so a
+ * slave only has to act on the event. SDA is P1.2, SCL P1.3. The
+ * controller is the bus master and leaves this file out of its build.
+ */
+#ifndef I2C_SLAVE_H
+#define I2C_SLAVE_H
+
+#include "i2c_frame.h"
+
+void i2c_slave_init(unsigned char address);
+
+/** Frame being received, for tests and benchmarks that feed the ISR */
+extern i2c_frame_parser_t i2c_slave_rx;
+
+#endif // I2C_SLAVE_H
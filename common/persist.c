@@ -0,0 +1,140 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include <stddef.h>
+#include "persist.h"
+#include "i2c_frame.h"
+
+typedef struct
+{
+    unsigned short sequence;        // Higher is newer, wraps at 16 bits
+    unsigned char version;          // Firmware's layout version, never 0
+    unsigned char size;
+    unsigned char data[PERSIST_MAX];
+    unsigned char crc;              // crc8 over everything above
+} persist_slot_t;
+
+//----------------------------------------------------------------------
+// Record Slots
+//----------------------------------------------------------------------
+// In program FRAM and left alone by the C startup. All zeros reads as
+// version 0, i.e. empty.
+#pragma PERSISTENT(slots)
+static persist_slot_t slots[2] = { { 0 } };
+
+// Only this module writes the slots, so once a load or save has found
+// the newest it is tracked here, keeping the CRCs off the save path.
+#define PERSIST_UNCHECKED   -2
+static signed char newest_slot = PERSIST_UNCHECKED;
+//--End Record Slots----------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Slot Checks
+//----------------------------------------------------------------------
+static unsigned char persist_crc(const persist_slot_t *slot)
+{
+    const unsigned char *byte = (const unsigned char *)slot;
+    unsigned char crc = 0;
+    unsigned char i;
+
+    for (i = 0; i < (unsigned char)offsetof(persist_slot_t, crc); i++) {
+        crc = crc8_update(crc, byte[i]);
+    }
+    return crc;
+}
+
+static bool persist_valid(const persist_slot_t *slot, unsigned char size, unsigned char version)
+{
+    return slot->version == version && slot->size == size && slot->crc == persist_crc(slot);
+}
+
+// Index of the newest valid slot, or -1 if neither is
+static signed char persist_newest(unsigned char size, unsigned char version)
+{
+    bool valid0 = persist_valid(&slots[0], size, version);
+    bool valid1 = persist_valid(&slots[1], size, version);
+
+    if (valid0 && valid1) {
+        return (signed short)(slots[1].sequence - slots[0].sequence) > 0 ? 1 : 0;
+    }
+    return valid0 ? 0 : valid1 ? 1 : -1;
+}
+//--End Slot Checks-----------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Load and Save
+//----------------------------------------------------------------------
+// Copy the newest record into `state`. Returns false, leaving `state`
+// alone, if there is none for this size and version.
+bool persist_load(void *state, unsigned char size, unsigned char version)
+{
+    signed char newest = persist_newest(size, version);
+    unsigned char *out = state;
+    unsigned char i;
+
+    if (newest < 0) {
+        return false;
+    }
+    for (i = 0; i < size; i++) {
+        out[i] = slots[newest].data[i];
+    }
+    newest_slot = newest;
+    return true;
+}
+
+// Write `state` to the older slot, unless the newest record already
+// holds it. Program FRAM is unlocked only for the write.
+void persist_save(const void *state, unsigned char size, unsigned char version)
+{
+    signed char newest = (newest_slot != PERSIST_UNCHECKED) ? newest_slot : persist_newest(size, version);
+    const unsigned char *in = state;
+    persist_slot_t *slot;
+    unsigned int protect;
+    unsigned char i;
+
+    if (size > PERSIST_MAX || version == 0) {
+        return;
+    }
+    if (newest >= 0) {
+        for (i = 0; i < size && slots[newest].data[i] == in[i]; i++) {
+        }
+        if (i == size) {
+            return;                     // Unchanged
+        }
+    }
+    slot = &slots[newest == 0 ? 1 : 0];
+
+    protect = SYSCFG0 & (PFWP | DFWP);
+    SYSCFG0 = FRWPPW | (protect & ~PFWP);
+    slot->version = 0;                  // Invalid until complete
+    slot->sequence = newest < 0 ? 0 : slots[newest].sequence + 1;
+    slot->size = size;
+    for (i = 0; i < PERSIST_MAX; i++) {
+        slot->data[i] = i < size ? in[i] : 0;
+    }
+    slot->version = version;
+    slot->crc = persist_crc(slot);
+    SYSCFG0 = FRWPPW | protect;
+    newest_slot = slot - slots;
+}
+//--End Load and Save---------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Reset Cause
+//----------------------------------------------------------------------
+// True unless this start followed a power-up or brownout, i.e. parts
+// powered with the MCU (the LCD) kept their state. Reads SYSRSTIV until
+// empty, so call once, early in main.
+bool persist_warm_start(void)
+{
+    unsigned int cause;
+    bool warm = true;
+
+    while ((cause = SYSRSTIV) != SYSRSTIV_NONE) {
+        if (cause == SYSRSTIV_BOR) {
+            warm = false;
+        }
+    }
+    return warm;
+}
+//--End Reset Cause-----------------------------------------------------
@@ -0,0 +1,30 @@
+/**
+ * @file
+ * @brief Firmware state kept in FRAM across resets and power loss.
+ *
+ * Each firmware keeps one state struct of up to PERSIST_MAX bytes. It is
+ * stored twice, in two slots that take turns, each with a sequence
+ * number, the firmware's layout version, the size and a crc8. A save
+ * writes the older slot, so a power cut during a write leaves the newer
+ * one intact; a load takes the newest slot whose version, size and CRC
+ * all check. Restoring is a copy out of FRAM, a few microseconds.
+ *
+ * persist_save() compares with the newest record first and writes
+ * nothing if the state has not changed, so the firmwares call it on a
+ * slow timer (PERSIST_PERIOD_MS) or after a user action rather than on
+ * every change. Pass the same size and version on every call, and bump
+ * the version whenever the struct changes.
+ */
+#ifndef PERSIST_H
+#define PERSIST_H
+
+#include <stdbool.h>
+
+#define PERSIST_MAX         32      // Bytes of state per firmware
+#define PERSIST_PERIOD_MS   5000    // Save interval for state that changes often
+
+bool persist_load(void *state, unsigned char size, unsigned char version);
+void persist_save(const void *state, unsigned char size, unsigned char version);
+bool persist_warm_start(void);
+
+#endif // PERSIST_H
@@ -0,0 +1,24 @@
+/**
+ * @file
+ * @brief Index arithmetic for the single-producer/single-consumer rings
+ *        used across the firmwares (event queue, I2C and UART queues).
+ *
+ * The producer only advances `head`, the consumer only `tail`. Both are
+ * unsigned char and run freely, wrapping at 256; the ring size must be a
+ * power of two no larger than 128, and indices are masked only when a
+ * slot is accessed. head == tail is empty, so all `size` slots are usable.
+ * Everything here is a macro and compiles to the same code as writing the
+ * arithmetic inline.
+ */
+#ifndef RING_H
+#define RING_H
+
+#define RING_USED(head, tail)           ((unsigned char)((head) - (tail)))
+#define RING_FREE(head, tail, size)     ((unsigned char)((size) - RING_USED(head, tail)))
+#define RING_SLOT(index, size)          ((unsigned char)(index) & ((size) - 1))
+
+// Compile-time check that `size` suits the macros above
+#define RING_CHECK_SIZE(name, size)     \
+    typedef char name##_ring_size_check[((size) & ((size) - 1)) == 0 && (size) <= 128 ? 1 : -1]
+
+#endif // RING_H
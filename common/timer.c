@@ -0,0 +1,241 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include "timer.h"
+#include "trace.h"
+
+#if defined(__MSP430FR2355__)
+#define TIMER_CTL       TB2CTL
+#define TIMER_R         TB2R
+#define TIMER_CCR       TB2CCR0
+#define TIMER_CCTL      TB2CCTL0
+#define TIMER_VECTOR    TIMER2_B0_VECTOR
+#define TIMER_TRACE     TRACE_TIMER2_B0
+#else // MSP430FR2310, LED bar
+#define TIMER_CTL       TB0CTL
+#define TIMER_R         TB0R
+#define TIMER_CCR       TB0CCR0
+#define TIMER_CCTL      TB0CCTL0
+#define TIMER_VECTOR    TIMER0_B0_VECTOR
+#define TIMER_TRACE     TRACE_TIMER0_B0
+#endif
+
+#define SLOT_TICKS      (1UL << TIMER_SLOT_SHIFT)
+#define SLOT(time)      ((unsigned char)((time) >> TIMER_SLOT_SHIFT) & (TIMER_SLOTS - 1))
+
+static soft_timer_t *wheel[TIMER_SLOTS];
+static unsigned long now;           // Timer time when TIMER_R read `count`
+static unsigned int count;
+static unsigned long swept;         // Wheel checked for due timers up to here
+
+//----------------------------------------------------------------------
+// Begin Timer Time
+//----------------------------------------------------------------------
+// Extend TIMER_R to 32 bits. Needs a call at least every 0xFFFF ticks,
+// which the TIMER_HORIZON compare guarantees. TIMER_R runs from ACLK,
+// asynchronously to MCLK, so read it until two reads agree. Interrupts
+// must be off.
+static unsigned int timer_read(void)
+{
+    unsigned int low, check;
+
+    do {
+        low = TIMER_R;
+        check = TIMER_R;
+    } while (low != check);
+    return low;
+}
+
+static unsigned long timer_update(void)
+{
+    unsigned int low = timer_read();
+
+    now += (unsigned int)(low - count);
+    count = low;
+    return now;
+}
+
+unsigned long timer_now(void)
+{
+    unsigned int sr = __get_SR_register();
+    unsigned long time;
+
+    __disable_interrupt();
+    time = timer_update();
+    __bis_SR_register(sr & GIE);
+    return time;
+}
+//--End Timer Time------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Wheel
+//----------------------------------------------------------------------
+static void timer_link(soft_timer_t *timer)
+{
+    soft_timer_t **bucket = &wheel[SLOT(timer->expiry)];
+
+    timer->next = *bucket;
+    *bucket = timer;
+    timer->armed = true;
+}
+
+static void timer_unlink(soft_timer_t *timer)
+{
+    soft_timer_t **link = &wheel[SLOT(timer->expiry)];
+
+    while (*link != timer) {
+        link = &(*link)->next;
+    }
+    *link = timer->next;
+    timer->armed = false;
+}
+
+// Set the compare to the nearest expiry, or TIMER_HORIZON ahead if that
+// is later. Buckets are searched from now onward: the first one holding
+// a timer due inside its own window has the nearest expiry, so only when
+// nothing is due within one turn of the wheel are all timers compared.
+static void timer_program(void)
+{
+    unsigned long step = TIMER_HORIZON;
+    unsigned long base = now & ~(SLOT_TICKS - 1);
+    soft_timer_t *timer;
+    unsigned char i;
+    bool found = false;
+    long left;
+
+    for (i = 0; i < TIMER_SLOTS && !found; i++, base += SLOT_TICKS) {
+        for (timer = wheel[SLOT(base)]; timer != 0; timer = timer->next) {
+            if ((long)(timer->expiry - base) < (long)SLOT_TICKS) {
+                found = true;
+                left = (long)(timer->expiry - now);
+                step = left < (long)step ? (left > 1 ? left : 1) : step;
+            }
+        }
+    }
+    for (i = 0; i < TIMER_SLOTS && !found; i++) {
+        for (timer = wheel[i]; timer != 0; timer = timer->next) {
+            left = (long)(timer->expiry - now);
+            step = left < (long)step ? (left > 1 ? left : 1) : step;
+        }
+    }
+
+    TIMER_CCR = count + (unsigned int)step;
+    if ((unsigned int)(timer_read() - count) >= (unsigned int)step) {
+        TIMER_CCTL |= CCIFG;        // Passed while this ran: interrupt now
+    }
+}
+//--End Wheel-----------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Timer Initialization
+//----------------------------------------------------------------------
+// Starts the timer free-running on ACLK. On the controller, call before
+// power_init(), which adds the TB2 overflow interrupt.
+void timer_init(void)
+{
+    unsigned char i;
+
+    for (i = 0; i < TIMER_SLOTS; i++) {
+        wheel[i] = 0;
+    }
+    now = swept = 0;
+    count = 0;
+    TIMER_CTL = TBSSEL__ACLK | MC__CONTINUOUS | TBCLR;
+    TIMER_CCR = TIMER_HORIZON;
+    TIMER_CCTL = CCIE;
+}
+//--End Timer Initialization--------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Start and Stop
+//----------------------------------------------------------------------
+// Call `callback` `delay` ticks from now, then every `period` ticks
+// (0 for once). Restarts the timer if it was already armed. A delay of 0
+// is due on the next tick, so a timer started from its own callback is
+// never due in the pass that called it.
+void timer_start(soft_timer_t *timer, unsigned long delay, unsigned long period, timer_callback_t callback)
+{
+    unsigned int sr = __get_SR_register();
+
+    __disable_interrupt();
+    if (timer->armed) {
+        timer_unlink(timer);
+    }
+    timer->period = period;
+    timer->callback = callback;
+    timer->expiry = timer_update() + (delay != 0 ? delay : 1);
+    timer_link(timer);
+    timer_program();
+    __bis_SR_register(sr & GIE);
+}
+
+// Restart a periodic timer with a new period, first call one period on
+void timer_set_period(soft_timer_t *timer, unsigned long period)
+{
+    timer_start(timer, period, period, timer->callback);
+}
+
+// No effect on a timer that is not armed. The compare is left as it is;
+// at worst it wakes once to find nothing due.
+void timer_stop(soft_timer_t *timer)
+{
+    unsigned int sr = __get_SR_register();
+
+    __disable_interrupt();
+    if (timer->armed) {
+        timer_unlink(timer);
+    }
+    __bis_SR_register(sr & GIE);
+}
+//--End Start and Stop--------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Interrupt Service Routine
+//----------------------------------------------------------------------
+// Check the buckets for the time since the last interrupt, at most one
+// turn of the wheel, and call each due timer once. A periodic timer is
+// re-armed from its expiry, not from now, so it does not drift; one that
+// fell more than a period behind is re-armed for the next tick instead.
+// Nothing armed during a pass is due in it, so the pass always ends.
+#pragma vector = TIMER_VECTOR
+__interrupt void ISR_TIMER_WHEEL(void)
+{
+    soft_timer_t *timer;
+    unsigned long buckets;
+    unsigned char i, slot;
+    bool wake = false;
+
+    TRACE_ENTER(TIMER_TRACE);
+    TIMER_CCTL &= ~CCIFG;
+    timer_update();
+    buckets = (now >> TIMER_SLOT_SHIFT) - (swept >> TIMER_SLOT_SHIFT);
+    if (buckets > TIMER_SLOTS - 1) {
+        buckets = TIMER_SLOTS - 1;
+    }
+    for (i = 0; i <= buckets; i++) {
+        slot = (SLOT(swept) + i) & (TIMER_SLOTS - 1);
+        do {
+            // Search again after every call: callbacks may change the wheel
+            for (timer = wheel[slot]; timer != 0 && (long)(timer->expiry - now) > 0; timer = timer->next) {
+            }
+            if (timer != 0) {
+                timer_unlink(timer);
+                if (timer->period != 0) {
+                    timer->expiry += timer->period;
+                    if ((long)(timer->expiry - now) <= 0) {
+                        timer->expiry = now + 1;
+                    }
+                    timer_link(timer);
+                }
+                wake |= timer->callback();
+            }
+        } while (timer != 0);
+    }
+    swept = now;
+    timer_program();
+    if (wake) {
+        __bic_SR_register_on_exit(LPM3_bits);
+    }
+    TRACE_EXIT(TIMER_TRACE);
+}
+//--End Interrupt Service Routine---------------------------------------
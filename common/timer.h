@@ -0,0 +1,59 @@
+/**
+ * @file
+ * @brief Software timers on one compare channel of a free-running ACLK
+ *        timer, for one-shot and periodic callbacks.
+ *
+ * The hardware timer counts continuously and its CCR0 is always set to
+ * the nearest deadline, so there is no fixed tick: the CPU sleeps (LPM3
+ * is fine, ACLK keeps running) until a timer is actually due. Only when
+ * nothing is due for TIMER_HORIZON ticks does it wake once to extend the
+ * 16-bit count into the 32-bit time used for expiries.
+ *
+ * Armed timers sit in a hashed wheel of TIMER_SLOTS buckets keyed by
+ * their expiry, so the interrupt only walks the buckets for the time
+ * that has passed instead of every timer.
+ *
+ * Callbacks run in the timer interrupt: keep them short, post events for
+ * anything longer, and return true to wake main from LPM on exit. They
+ * may start, stop or re-period any timer, themselves included. Times
+ * are in ACLK ticks; a delay of 0 calls back on the next tick, and a
+ * periodic timer that falls behind is called once, on the next tick,
+ * rather than once for every period it missed.
+ *
+ *   Controller (FR2355): TB2 CCR0, TB2 overflow stays with power.c
+ *   LED bar (FR2310):    TB0 CCR0
+ * The LCD slave does not use this module: its TB0 runs from SMCLK for
+ * the display queue.
+ */
+#ifndef TIMER_H
+#define TIMER_H
+
+#include <stdbool.h>
+#include "clock.h"
+
+#define TIMER_HZ            CLOCK_ACLK_HZ
+#define TIMER_MS(ms)        ((unsigned long)(ms) * TIMER_HZ / 1000)
+
+#define TIMER_SLOTS         8       // Wheel buckets, power of two
+#define TIMER_SLOT_SHIFT    8       // 256 ticks (7.8 ms) per bucket
+#define TIMER_HORIZON       0x4000  // Longest compare step, ticks (0.5 s)
+
+// Return true if the callback left work for main
+typedef bool (*timer_callback_t)(void);
+
+typedef struct soft_timer
+{
+    struct soft_timer *next;        // Bucket chain
+    unsigned long expiry;           // Timer time of the next call
+    unsigned long period;           // Ticks between calls, 0 = one-shot
+    timer_callback_t callback;
+    bool armed;
+} soft_timer_t;
+
+void timer_init(void);
+void timer_start(soft_timer_t *timer, unsigned long delay, unsigned long period, timer_callback_t callback);
+void timer_set_period(soft_timer_t *timer, unsigned long period);
+void timer_stop(soft_timer_t *timer);
+unsigned long timer_now(void);
+
+#endif // TIMER_H
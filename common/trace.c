@@ -0,0 +1,125 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include "i2c_frame.h"
+#include "trace.h"
+#include "clock.h"
+
+#ifdef TRACE_ENABLE
+
+// Dump UART, 115200 8N1 from SMCLK. The controller's UCA0 TXD
+// (P1.7) drives the RGB LED, so it uses UCA1 on P4.3, which telemetry
+// (controller/src/telemetry.c) takes back after the dump. The slaves borrow
+// P1.7 (LCD D7, LED bar bit 7) for the length of a dump only.
+#if defined(__MSP430FR2355__)
+#define UART_CTLW0  UCA1CTLW0
+#define UART_BRW    UCA1BRW
+#define UART_MCTLW  UCA1MCTLW
+#define UART_IFG    UCA1IFG
+#define UART_STATW  UCA1STATW
+#define UART_TXBUF  UCA1TXBUF
+#define UART_SEL0   P4SEL0
+#define UART_PIN    BIT3
+#else
+#define UART_CTLW0  UCA0CTLW0
+#define UART_BRW    UCA0BRW
+#define UART_MCTLW  UCA0MCTLW
+#define UART_IFG    UCA0IFG
+#define UART_STATW  UCA0STATW
+#define UART_TXBUF  UCA0TXBUF
+#define UART_SEL0   P1SEL0
+#define UART_PIN    BIT7
+#endif
+
+#define TRACE_BAUD  115200UL
+#define TRACE_VALID 0x7ACE              // trace_buf has been initialised
+
+//----------------------------------------------------------------------
+// Trace Ring
+//----------------------------------------------------------------------
+// In FRAM and left alone by the C startup, so a dump after a reset still
+// shows what led up to it.
+#pragma PERSISTENT(trace_buf)
+unsigned int trace_buf[TRACE_SIZE] = { 0 };
+#pragma PERSISTENT(trace_head)
+unsigned char trace_head = 0;
+#pragma PERSISTENT(trace_valid)
+static unsigned int trace_valid = 0;
+//--End Trace Ring------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Trace Initialization
+//----------------------------------------------------------------------
+// Start the time base and mark the boot in the ring. Program FRAM stays
+// writable from here on, which a trace build accepts.
+void trace_init(void)
+{
+    unsigned int i;
+
+    SYSCFG0 = FRWPPW | DFWP;            // Clear PFWP: trace_buf is in program FRAM
+    if (trace_valid != TRACE_VALID) {
+        for (i = 0; i < TRACE_SIZE; i++) {
+            trace_buf[i] = TRACE_EMPTY;
+        }
+        trace_head = 0;
+        trace_valid = TRACE_VALID;
+    }
+
+    RTCMOD = 0x0FFF;                    // 12-bit stamps
+    RTCCTL = RTCSS__SMCLK | RTCPS__1 | RTCSR;   // SMCLK ticks, counter cleared
+    TRACE_POINT(TRACE_CODE(TRACE_MARK, 0));
+}
+//--End Trace Initialization--------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Trace Dump
+//----------------------------------------------------------------------
+static void uart_put(unsigned char byte)
+{
+    while (!(UART_IFG & UCTXIFG)) {
+    }
+    UART_TXBUF = byte;
+}
+
+// Send the whole ring, oldest entry first, with interrupts held off so
+// it does not change underneath (about 45 ms). `source` tags the dump,
+// e.g. 'C', 'L' or 'B'. The UART is released again afterwards.
+void trace_dump(unsigned char source)
+{
+    unsigned int sr = __get_SR_register();
+    unsigned char i = trace_head;
+    unsigned char crc = 0;
+    unsigned int brw, mctlw;
+
+    clock_uart_divider(TRACE_BAUD, &brw, &mctlw);
+    __disable_interrupt();
+    UART_CTLW0 = UCSWRST | UCSSEL__SMCLK;
+    UART_BRW = brw;
+    UART_MCTLW = mctlw;
+    UART_SEL0 |= UART_PIN;
+    UART_CTLW0 &= ~UCSWRST;
+
+    uart_put('T');
+    uart_put('R');
+    uart_put(source);
+    uart_put(CLOCK_SMCLK_MHZ);
+    uart_put(TRACE_SIZE & 0xFF);
+    uart_put(TRACE_SIZE >> 8);
+    do {
+        unsigned int entry = trace_buf[i];
+
+        uart_put(entry & 0xFF);
+        uart_put(entry >> 8);
+        crc = crc8_update(crc, entry & 0xFF);
+        crc = crc8_update(crc, entry >> 8);
+    } while (++i != trace_head);
+    uart_put(crc);
+
+    while (UART_STATW & UCBUSY) {
+    }
+    UART_CTLW0 |= UCSWRST;
+    UART_SEL0 &= ~UART_PIN;             // Pin back to GPIO
+    __bis_SR_register(sr & GIE);
+}
+//--End Trace Dump------------------------------------------------------
+
+#endif // TRACE_ENABLE
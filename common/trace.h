@@ -0,0 +1,67 @@
+/**
+ * @file
+ * @brief ISR entry/exit timestamp trace, compiled in with TRACE_ENABLE.
+ *
+ * Each trace point stores one word in a ring in FRAM: the point code in
+ * the top four bits and a 12-bit timestamp in SMCLK ticks below it. The
+ * stamp comes from the RTC counter run from SMCLK with RTCMOD = 0x0FFF,
+ * so it wraps every 4096 ticks and never needs masking; the RTC is unused
+ * on all three boards, so no Timer_B is taken.
+ *
+ * The ring survives a reset and is only read by trace_dump(), which sends
+ * it over UART for tools/trace_decode.c:
+ *
+ *   'T' 'R' source mhz count_lo count_hi entry_lo entry_hi ... crc8
+ *
+ * with `mhz` the stamp ticks per microsecond, the entries oldest first
+ * and crc8 (common/i2c_frame.h) over the entries. Without TRACE_ENABLE
+ * every macro and call compiles to nothing.
+ */
+#ifndef TRACE_H
+#define TRACE_H
+
+// Traced interrupt vectors. Every ISR in the three firmwares has one.
+// The code has room for seven, so the controller reuses the IDs of the
+// slave-only vectors; tools/trace_decode.c names them by the dump's
+// source.
+#define TRACE_I2C_MASTER    0       // EUSCI_B1, controller
+#define TRACE_I2C_SLAVE     1       // USCI_B0, slaves
+#define TRACE_TIMER0_B0     2       // LCD queue, LED bar timer wheel
+#define TRACE_TIMER1_B0     3       // LED bar BCM
+#define TRACE_TIMER2_B0     4       // Controller timer wheel
+#define TRACE_ADC           5       // Controller temperature samples
+#define TRACE_TIMER3_B1     6       // Controller RGB fades
+#define TRACE_MARK          7       // Enter = boot, exit = empty slot
+#define TRACE_UART_A1       1       // Controller telemetry UART
+#define TRACE_TIMER2_B1     2       // Controller TB2 overflow, POWER_ACCOUNTING
+
+#define TRACE_SIZE          256     // Entries; trace_head wraps on its own
+#define TRACE_CODE(id, exit)    (((id) << 1 | (exit)) << 12)
+#define TRACE_EMPTY         0xFFFF  // TRACE_CODE(TRACE_MARK, 1) | 0x0FFF
+
+#ifdef TRACE_ENABLE
+
+#define TRACE_CLOCK         RTCCNT
+
+extern unsigned int trace_buf[TRACE_SIZE];
+extern unsigned char trace_head;
+
+// About 17 cycles: read RTCCNT, add the code, one indexed store, bump the
+// byte index. ISRs do not nest, so no locking.
+#define TRACE_POINT(code)   (trace_buf[trace_head++] = TRACE_CLOCK + (code))
+#define TRACE_ENTER(id)     TRACE_POINT(TRACE_CODE(id, 0))
+#define TRACE_EXIT(id)      TRACE_POINT(TRACE_CODE(id, 1))
+
+void trace_init(void);
+void trace_dump(unsigned char source);
+
+#else
+
+#define TRACE_ENTER(id)     ((void)0)
+#define TRACE_EXIT(id)      ((void)0)
+#define trace_init()        ((void)0)
+#define trace_dump(source)  ((void)0)
+
+#endif // TRACE_ENABLE
+
+#endif // TRACE_H
@@ -10,223 +10,245 @@
 //----------------------------------------------------------------------
 #include <msp430.h>
 #include <stdbool.h>
-#include <stdio.h>
 #include "intrinsics.h"
-#include "C:\Users\gabri\Documents\Spring2025\EELE465\project04\project4-gabby-iker\controller\src\master_i2c.h"
-#include "C:\Users\gabri\Documents\Spring2025\EELE465\project04\project4-gabby-iker\controller\src\rgb_led.h"
-#include "C:\Users\gabri\Documents\Spring2025\EELE465\project04\project4-gabby-iker\controller\src\heartbeat.h"
+#include "i2c_frame.h"
+#include "keypad.h"
+#include "power.h"
+#include "temperature.h"
+#include "lm19.h"
+#include "trace.h"
+#include "clock.h"
+#include "timer.h"
+#include "persist.h"
+#include "telemetry.h"
+#include "temp_log.h"
+#include "log.h"
+#include "master_i2c.h"
+#include "rgb_led.h"
+#include "heartbeat.h"
+#include "fsm.h"
 //--End Headers---------------------------------------------------------
 
 //----------------------------------------------------------------------
 // Definitions
 //----------------------------------------------------------------------
-#define PROWDIR     P6DIR  // FORMERLY P1
-#define PROWREN     P6REN
-#define PROWIN      P6IN
-#define PROWOUT     P6OUT
-#define PCOLDIR     P5DIR   // FORMERLY P5
-#define PCOLOUT     P5OUT
-#define RS BIT2  // P1.2 -> RS (Register Select)
-#define EN BIT3  // P1.3 -> Enable
-#define D4 BIT4  // P1.4 -> Data bit 4
-#define D5 BIT5  // P1.5 -> Data bit 5
-#define D6 BIT6  // P1.6 -> Data bit 6
-#define D7 BIT7  // P1.7 -> Data bit 7
-#define COL 4
-#define ROW 4
-#define TABLE_SIZE 4
+#define LED_BAR_ADDR 0x068
+#define LCD_ADDR     0x048
+#define STATE_VERSION 2     // Bump when controller_state_t changes
 //--End Definitions-----------------------------------------------------
 
 //----------------------------------------------------------------------
 // Variables
 //----------------------------------------------------------------------
-char real_code[] = {'3','9','4','D'};
+char temp_unit = 'C';       // 'C' or 'F', toggled with '#'
 
-char keypad[ROW][COL] = {
-    {'1', '2', '3', 'A'},
-    {'4', '5', '6', 'B'},
-    {'7', '8', '9', 'C'},
-    {'*', '0', '#', 'D'}
-};
+// Kept in FRAM across resets. The lock state is deliberately not: a
+// reset always comes back locked.
+typedef struct
+{
+    temperature_history_t history;
+    char temp_unit;
+} controller_state_t;
 
-int lockState = 3;
+static soft_timer_t persist_timer;
+static volatile bool persist_due;   // Set by persist_timer, cleared by main
 //--End Variables-------------------------------------------------------
 
 //----------------------------------------------------------------------
-// Begin Debounce
+// Begin Persisted State
 //----------------------------------------------------------------------
-void debounce() {
-    volatile unsigned int i;
-    for (i = 20000; i > 0; i--) {}
+// Runs in the timer interrupt every PERSIST_PERIOD_MS
+static bool persist_tick(void)
+{
+    persist_due = true;
+    power_wake_pending = true;
+    return true;
 }
-//--End Debounce--------------------------------------------------------
 
-//----------------------------------------------------------------------
-// Begin Initializing Keypad Ports
-//----------------------------------------------------------------------
-void keypad_init() 
+// Pick up where the last run left off: unit, window, filter and its
+// output, so the first reading goes out after one sample, not a full
+// window.
+void state_restore(void)
 {
-    // Set rows as inputs (with pull-up)
-    PROWDIR &= ~0x0F;   // P1.0, P1.1, P1.2, P1.3 as inputs
-    PROWREN |= 0x0F;    // Activate pull-up
-    PROWOUT |= 0x0F;    // Activar pull-up in rows
-    
-    // Set columns as outputs
-    PCOLDIR |= BIT0 | BIT1 | BIT2 | BIT3; // Set P5.0, P5.1, P5.2 y P5.3 as outputs:
-    PCOLOUT &= ~(BIT0 | BIT1 | BIT2 | BIT3);  // Set down the pins P5.0, P5.1, P5.2 y P5.3:
+    controller_state_t state;
+
+    if (persist_load(&state, sizeof(state), STATE_VERSION)) {
+        temperature_set_history(&state.history);
+        temp_unit = (state.temp_unit == 'F') ? 'F' : 'C';
+    }
+    timer_start(&persist_timer, TIMER_MS(PERSIST_PERIOD_MS), TIMER_MS(PERSIST_PERIOD_MS), persist_tick);
 }
-//--End Initialize Keypad-----------------------------------------------
+
+// Write the state to FRAM if it has changed. Called when persist_timer
+// has run out and on lock, so samples arriving every 0.5 s do not each
+// cost an FRAM write.
+void state_save(void)
+{
+    controller_state_t state;
+
+    persist_due = false;
+    temperature_get_history(&state.history);
+    state.temp_unit = temp_unit;
+    persist_save(&state, sizeof(state), STATE_VERSION);
+}
+//--End Persisted State-------------------------------------------------
 
 //----------------------------------------------------------------------
-// Begin Unlocking Routine
+// Begin Send Temperature
 //----------------------------------------------------------------------
-char keypad_unlocking(void)
+// Once per ADC sample taken, add it to the FRAM log, stream a telemetry
+// record, and while unlocked (`to_lcd`) send the filtered value to the LCD
+// in the chosen unit. Nothing goes to the LCD until the window has filled.
+void send_temperature(bool to_lcd)
 {
-    int row, col;
-
-    // Go through 4 columns
-    for (col = 0; col < 4; col++) {
-        // Put column down (active)
-        PCOLOUT &= ~(1 << col);   // P2.0, P2.1, P2.2, P2.4
-         __delay_cycles(1000);  // Little stop to stabilize the signal
-
-        // Go through 4 rows
-        for (row = 0; row < 4; row++) {
-            if ((PROWIN & (1 << row)) == 0) {  // We detect that the row is low
-                debounce();  // Wait to filter the bouncing
-                if ((PROWIN & (1 << row)) == 0) {  // Confirm that the key is pressed
-                    rgb_led_continue(0);                // Set LED to yellow
-                    char key = keypad[row][col];
-                    // Wait until the key is released to avoid multiple readings 
-                    while ((PROWIN & (1 << row)) == 0);
-                    // Deactivate the column before returning
-                    PCOLOUT |= (1 << col);                    
-                    return key;
-                }
-            }
-        }
-        // Put the column high (desactivated)
-        PCOLOUT |= (1 << col);
+    unsigned int code_q4;
+    int centi, tenths;
+    unsigned char payload[3];
+    bool full;
+
+    temp_log_add(temperature_last_sample());
+    full = temperature_average(&code_q4);
+    centi = full ? lm19_centi_celsius(code_q4) : 0;
+    telemetry_send(timer_now(), temperature_last_sample(), full ? code_q4 : TELEMETRY_NO_AVERAGE, centi);
+    if (!full || !to_lcd) {
+        return;
     }
-
-    return 0; // No key pressed
+    if (temp_unit == 'F') {
+        centi = lm19_centi_fahrenheit(centi);
+    }
+    tenths = lm19_tenths(centi);
+    payload[0] = tenths & 0xFF;
+    payload[1] = (tenths >> 8) & 0xFF;
+    payload[2] = temp_unit;
+    master_i2c_send_frame(LCD_ADDR, FRAME_OP_TEMPERATURE, payload, 3);
 }
-//--End Unlocking-------------------------------------------------------
+//--End Send Temperature------------------------------------------------
 
 //----------------------------------------------------------------------
-// Begin Unlocked Routine
+// Begin FSM Outputs
 //----------------------------------------------------------------------
-char keypad_unlocked(void)
+// What each transition of the lock state machine (fsm.c) does. A setting
+// goes to the slaves as one "set window" / "set pattern" transaction
+// instead of the keystrokes it took to enter it.
+void fsm_output(fsm_output_t output, const fsm_t *machine)
 {
-    char key_unlocked = '\0';
-
-    // Continuously poll until 'D' is pressed
-    while (key_unlocked != 'D') {
-        int row, col;
-
-        for (col = 0; col < 4; col++) {
-            // Activate column
-            PCOLOUT &= ~(1 << col);
-            __delay_cycles(1000);
-
-            // Check all rows
-            for (row = 0; row < 4; row++) {
-                if ((PROWIN & (1 << row)) == 0) {
-                    debounce();
-                    if ((PROWIN & (1 << row)) == 0) {
-                        key_unlocked = keypad[row][col];
-                        if (key_unlocked != 'D') {
-                            master_i2c_send(key_unlocked, 0x068);   // led slave
-                            master_i2c_send(key_unlocked, 0x048);   // lcd slave
-                        }
-                        // Wait for key release
-                        while ((PROWIN & (1 << row)) == 0);
-                        PCOLOUT |= (1 << col);
-
-                        if (key_unlocked == 'D') {
-                            rgb_led_continue(3);  // Set LED to red when 'D' is pressed
-                            master_i2c_send('D', 0x068);            // led slave
-                            master_i2c_send('D', 0x048);            // lcd slave
-                            return key_unlocked;
-                        }
-                    }
-                }
-            }
-            // Deactivate column
-            PCOLOUT |= (1 << col);
+    unsigned char payload[3];
+
+    switch (output)
+    {
+    case FSM_OUT_CODE_KEY:
+        rgb_led_continue(0);                // Set LED to yellow
+        break;
+    case FSM_OUT_UNLOCK:
+        log_put(LOG_CODE_CORRECT, 0);
+        rgb_led_continue(1);                // Set LED to blue
+        clock_set_speed(CLOCK_FAST);
+        master_i2c_send_frame(LCD_ADDR, FRAME_OP_UNLOCK, 0, 0);
+        break;
+    case FSM_OUT_WRONG_CODE:
+        log_put(LOG_CODE_INCORRECT, machine->failed);
+        rgb_led_continue(3);                // Set LED to red
+        break;
+    case FSM_OUT_LOCK:
+        rgb_led_continue(3);
+        master_i2c_send_frame(LED_BAR_ADDR, FRAME_OP_LOCK, 0, 0);
+        master_i2c_send_frame(LCD_ADDR, FRAME_OP_LOCK, 0, 0);
+        state_save();
+        log_put(LOG_LOCKED, 0);
+        clock_set_speed(CLOCK_SLOW);        // Locked: only key entry to handle
+        break;
+    case FSM_OUT_ECHO_KEY:                  // Prompt, digit or next filter
+        payload[0] = machine->key;
+        master_i2c_send_frame(LCD_ADDR, FRAME_OP_KEY, payload, 1);
+        break;
+    case FSM_OUT_SET_WINDOW:
+        payload[0] = machine->window & 0xFF;
+        payload[1] = machine->window >> 8;
+        payload[2] = machine->filter;
+        master_i2c_send_frame(LCD_ADDR, FRAME_OP_SET_WINDOW, payload, 3);
+        temperature_set_window(machine->window, machine->filter);
+        break;
+    case FSM_OUT_SET_PATTERN:
+        payload[0] = machine->key - '0';
+        master_i2c_send_frame(LED_BAR_ADDR, FRAME_OP_SET_PATTERN, payload, 1);
+        master_i2c_send_frame(LCD_ADDR, FRAME_OP_SET_PATTERN, payload, 1);
+        break;
+    case FSM_OUT_TOGGLE_UNIT:
+        temp_unit = (temp_unit == 'C') ? 'F' : 'C';     // Shown from the next sample
+        break;
+    case FSM_OUT_EXPORT_LOG:
+        if (!temp_log_export())             // Stream the log over the UART
+        {
+            log_put(LOG_EXPORT_BUSY, 0);
         }
+        break;
+    case FSM_OUT_TRACE_DUMP:
+#ifdef TRACE_ENABLE                         // Dump all three ISR traces
+        master_i2c_send_frame(LED_BAR_ADDR, FRAME_OP_TRACE_DUMP, 0, 0);
+        master_i2c_send_frame(LCD_ADDR, FRAME_OP_TRACE_DUMP, 0, 0);
+        trace_dump('C');
+        telemetry_init();                   // Shares the dump UART
+#endif
+        break;
+    case FSM_OUT_SAMPLE:
+        send_temperature(fsm_unlocked());
+        break;
+    case FSM_OUT_PERSIST:
+        state_save();
+        break;
+    default:
+        break;
     }
-    return key_unlocked;
 }
-//--End Unlocked--------------------------------------------------------
+//--End FSM Outputs-----------------------------------------------------
 
 //----------------------------------------------------------------------
 // Begin Main
 //----------------------------------------------------------------------
 
 int main(void)
-{   
-    int counter, i, equal;
-    char introduced_password[TABLE_SIZE], key; 
+{
+    keypad_event_t event;
 
+    clock_init();
+    trace_init();
+    timer_init();
     keypad_init();
     heartbeat_init();
     rgb_led_init();
     master_i2c_init();
-      
+    power_init();
+    temperature_init();
+    telemetry_init();
+    temp_log_init();
+    state_restore();
+    fsm_init(temperature_window(), temperature_filter());
+    log_put(LOG_START, 0);
+    clock_set_speed(CLOCK_SLOW);        // Locked: only key entry to handle
+
+    // One event per pass, each handled in bounded time, so a key, a
+    // sample and the persist timer never wait on each other for long
     while(true)
     {
-        counter = 0;
-        key = 0;
-
-        while (counter < TABLE_SIZE)
+        if (keypad_get_event(&event))
         {
-            key = keypad_unlocking();
-            if(key!=0)
+            if (event.pressed)
             {
-                introduced_password [counter] = key;
-                counter++;
-            }        
-        }
-
-        //Compare the introduced code with the real code   
-        equal = 1;   
-        for (i = 0; i < TABLE_SIZE; i++) {
-            if (introduced_password[i] != real_code[i]) 
-            {
-                equal = 0;
-                break;
+                fsm_handle(fsm_key_event(event.key), event.key);
             }
         }
-
-        // Verify the code
-        if (equal==1) 
+        else if (temperature_take_sample())
         {
-            printf("Correct Code!\n");
-            counter = 0;
-            rgb_led_continue(1);            // Set LED to blue
-            for (i = 0; i < TABLE_SIZE; i++) 
-            {
-                introduced_password[i] = 0;        
-            }
-            master_i2c_send('Z', 0x048);            // lcd slave
-            keypad_unlocked();  // This now handles polling until 'D' is pressed
-
-
-        } 
-        else 
+            fsm_handle(FSM_SAMPLE, 0);
+        }
+        else if (persist_due)
         {
-            printf("Incorrect code. Try again.\n");
-            counter = 0;  // Reinitiate counter to try again
-            rgb_led_continue(3);            // Set LED to red
-            master_i2c_send('\0', 0x068);
-            master_i2c_send('\0', 0x048);
-            //led_patterns('\0');
-            for (i = 0; i < TABLE_SIZE; i++) 
-            {
-                introduced_password[i] = 0;        
-            }
-        }    
+            fsm_handle(FSM_PERSIST, 0);
+        }
+        else
+        {
+            power_sleep();      // Until a key, a sample or the persist timer
+        }
     }
     return 0;
 }
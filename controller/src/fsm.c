@@ -0,0 +1,231 @@
+#include <stdbool.h>
+#include "fsm.h"
+#include "temperature.h"
+
+// A handler does the work of one transition and returns the state to go
+// to, normally `next` from the table
+typedef fsm_state_t (*fsm_handler_t)(fsm_state_t next);
+
+typedef struct
+{
+    fsm_handler_t handler;
+    fsm_state_t next;
+} fsm_transition_t;
+
+static const char code[FSM_CODE_LENGTH] = FSM_CODE;
+
+fsm_t fsm;
+
+//----------------------------------------------------------------------
+// Begin Handlers
+//----------------------------------------------------------------------
+// Every key counts toward the code, 'D' included. The fourth decides.
+static fsm_state_t code_key(fsm_state_t next)
+{
+    unsigned char i;
+    bool equal = true;
+
+    fsm.code[fsm.code_count++] = fsm.key;
+    fsm_output(FSM_OUT_CODE_KEY, &fsm);
+    if (fsm.code_count < FSM_CODE_LENGTH) {
+        return next;
+    }
+    fsm.code_count = 0;
+    for (i = 0; i < FSM_CODE_LENGTH; i++) {
+        equal = equal && fsm.code[i] == code[i];
+        fsm.code[i] = 0;
+    }
+    if (equal) {
+        fsm.failed = 0;
+        fsm_output(FSM_OUT_UNLOCK, &fsm);
+        return FSM_UNLOCKED;
+    }
+    fsm.failed++;
+    fsm_output(FSM_OUT_WRONG_CODE, &fsm);
+    return FSM_LOCKED;
+}
+
+// 'A', 'B' or 'C': the LCD shows the prompt, entry starts afresh
+static fsm_state_t prompt(fsm_state_t next)
+{
+    fsm.window_entry = 0;
+    fsm.filter_entry = fsm.filter;
+    fsm_output(FSM_OUT_ECHO_KEY, &fsm);
+    return next;
+}
+
+static fsm_state_t lock(fsm_state_t next)
+{
+    fsm_output(FSM_OUT_LOCK, &fsm);
+    return next;
+}
+
+// Of the digits, only '0' means anything unlocked
+static fsm_state_t export_log(fsm_state_t next)
+{
+    if (fsm.key == '0') {
+        fsm_output(FSM_OUT_EXPORT_LOG, &fsm);
+    }
+    return next;
+}
+
+// A digit that would take the window past TEMP_WINDOW_MAX is dropped
+static fsm_state_t window_digit(fsm_state_t next)
+{
+    unsigned int window = fsm.window_entry * 10 + (fsm.key - '0');
+
+    if (window <= TEMP_WINDOW_MAX) {
+        fsm.window_entry = window;
+        fsm_output(FSM_OUT_ECHO_KEY, &fsm);
+    }
+    return next;
+}
+
+static fsm_state_t window_filter(fsm_state_t next)
+{
+    fsm.filter_entry = (fsm.filter_entry + 1) % TEMP_FILTER_COUNT;
+    fsm_output(FSM_OUT_ECHO_KEY, &fsm);     // LCD shows the next filter
+    return next;
+}
+
+// '#' alone keeps the window and applies the filter
+static fsm_state_t window_apply(fsm_state_t next)
+{
+    if (fsm.window_entry != 0) {
+        fsm.window = fsm.window_entry;
+    }
+    fsm.filter = fsm.filter_entry;
+    fsm_output(FSM_OUT_SET_WINDOW, &fsm);
+    return next;
+}
+
+// '8' and '9' are not patterns and leave entry open
+static fsm_state_t pattern_digit(fsm_state_t next)
+{
+    if (fsm.key > '7') {
+        return fsm.state;
+    }
+    fsm_output(FSM_OUT_SET_PATTERN, &fsm);
+    return next;
+}
+
+static fsm_state_t toggle_unit(fsm_state_t next)
+{
+    fsm_output(FSM_OUT_TOGGLE_UNIT, &fsm);
+    return next;
+}
+
+static fsm_state_t trace_dump(fsm_state_t next)
+{
+    fsm_output(FSM_OUT_TRACE_DUMP, &fsm);
+    return next;
+}
+
+static fsm_state_t sample(fsm_state_t next)
+{
+    fsm_output(FSM_OUT_SAMPLE, &fsm);
+    return next;
+}
+
+static fsm_state_t persist(fsm_state_t next)
+{
+    fsm_output(FSM_OUT_PERSIST, &fsm);
+    return next;
+}
+//--End Handlers--------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Transition Table
+//----------------------------------------------------------------------
+#define LOCKED_ROW(state)                                                           \
+    { { code_key, FSM_UNLOCKING }, { code_key, FSM_UNLOCKING },                     \
+      { code_key, FSM_UNLOCKING }, { code_key, FSM_UNLOCKING },                     \
+      { code_key, FSM_UNLOCKING }, { code_key, FSM_UNLOCKING },                     \
+      { code_key, FSM_UNLOCKING }, { sample, state }, { persist, state } }
+
+static const fsm_transition_t table[FSM_STATES][FSM_EVENTS] = {
+    // DIGIT, A, B, C, D, *, #, SAMPLE, PERSIST
+    [FSM_LOCKED] = LOCKED_ROW(FSM_LOCKED),
+    [FSM_UNLOCKING] = LOCKED_ROW(FSM_UNLOCKING),
+    [FSM_UNLOCKED] = {
+        { export_log, FSM_UNLOCKED },
+        { prompt, FSM_UNLOCKED },
+        { prompt, FSM_WINDOW_ENTRY },
+        { prompt, FSM_PATTERN_ENTRY },
+        { lock, FSM_LOCKED },
+        { trace_dump, FSM_UNLOCKED },
+        { toggle_unit, FSM_UNLOCKED },
+        { sample, FSM_UNLOCKED },
+        { persist, FSM_UNLOCKED } },
+    [FSM_WINDOW_ENTRY] = {
+        { window_digit, FSM_WINDOW_ENTRY },
+        { prompt, FSM_UNLOCKED },
+        { prompt, FSM_WINDOW_ENTRY },
+        { prompt, FSM_PATTERN_ENTRY },
+        { lock, FSM_LOCKED },
+        { window_filter, FSM_WINDOW_ENTRY },
+        { window_apply, FSM_UNLOCKED },
+        { sample, FSM_WINDOW_ENTRY },
+        { persist, FSM_WINDOW_ENTRY } },
+    [FSM_PATTERN_ENTRY] = {
+        { pattern_digit, FSM_UNLOCKED },
+        { prompt, FSM_UNLOCKED },
+        { prompt, FSM_WINDOW_ENTRY },
+        { prompt, FSM_PATTERN_ENTRY },
+        { lock, FSM_LOCKED },
+        { trace_dump, FSM_PATTERN_ENTRY },
+        { toggle_unit, FSM_PATTERN_ENTRY },
+        { sample, FSM_PATTERN_ENTRY },
+        { persist, FSM_PATTERN_ENTRY } },
+};
+//--End Transition Table------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin FSM
+//----------------------------------------------------------------------
+// Start locked with the window and filter temperature.c is using
+void fsm_init(unsigned int window, unsigned char filter)
+{
+    unsigned char i;
+
+    fsm.state = FSM_LOCKED;
+    fsm.code_count = 0;
+    for (i = 0; i < FSM_CODE_LENGTH; i++) {
+        fsm.code[i] = 0;
+    }
+    fsm.failed = 0;
+    fsm.window = window;
+    fsm.filter = filter;
+    fsm.window_entry = 0;
+    fsm.filter_entry = filter;
+}
+
+fsm_event_t fsm_key_event(char key)
+{
+    switch (key) {
+    case 'A': return FSM_KEY_A;
+    case 'B': return FSM_KEY_B;
+    case 'C': return FSM_KEY_C;
+    case 'D': return FSM_KEY_D;
+    case '*': return FSM_KEY_STAR;
+    case '#': return FSM_KEY_HASH;
+    default:  return FSM_KEY_DIGIT;
+    }
+}
+
+// One table lookup and one handler, which runs in bounded time (the code
+// compare is the longest, FSM_CODE_LENGTH steps)
+void fsm_handle(fsm_event_t event, char key)
+{
+    const fsm_transition_t *transition = &table[fsm.state][event];
+
+    fsm.key = key;
+    fsm.state = transition->handler(transition->next);
+}
+
+// Samples go to the LCD only in these states
+bool fsm_unlocked(void)
+{
+    return fsm.state >= FSM_UNLOCKED;
+}
+//--End FSM-------------------------------------------------------------
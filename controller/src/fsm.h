@@ -0,0 +1,81 @@
+#include <stdbool.h>
+
+// The controller's user interface as a transition table: locked, part
+// way through the code, unlocked, and entering a window or a pattern.
+// Main feeds it one event at a time, keys from the keypad FIFO, ADC
+// samples and the persist timer, and each is handled in a fixed number
+// of steps. The machine does no I/O itself: it calls fsm_output(),
+// which main implements (and a host test records), for each effect.
+//
+// The code is any four keys. Entering it turns the LED yellow on each
+// key, then unlocks (blue) or counts a failure (red) on the fourth.
+// Unlocked, 'A', 'B' and 'C' open the modes as before: 'B' takes up to
+// three digits for the window, '*' steps the filter and '#' applies;
+// 'C' takes a pattern digit 0-7. '#' elsewhere toggles the unit, '0'
+// exports the temperature log, '*' asks for an ISR trace dump and 'D'
+// locks.
+#define FSM_CODE            "394D"
+#define FSM_CODE_LENGTH     4
+
+typedef enum
+{
+    FSM_LOCKED,                     // No code keys yet
+    FSM_UNLOCKING,                  // Some of the code entered
+    FSM_UNLOCKED,
+    FSM_WINDOW_ENTRY,               // After 'B'
+    FSM_PATTERN_ENTRY,              // After 'C'
+    FSM_STATES
+} fsm_state_t;
+
+typedef enum
+{
+    FSM_KEY_DIGIT,
+    FSM_KEY_A,
+    FSM_KEY_B,
+    FSM_KEY_C,
+    FSM_KEY_D,
+    FSM_KEY_STAR,
+    FSM_KEY_HASH,
+    FSM_SAMPLE,                     // An ADC sample was taken
+    FSM_PERSIST,                    // The persist timer ran out
+    FSM_EVENTS
+} fsm_event_t;
+
+typedef enum
+{
+    FSM_OUT_CODE_KEY,               // A code key went in
+    FSM_OUT_UNLOCK,                 // The code was right
+    FSM_OUT_WRONG_CODE,             // The code was wrong: `failed` in a row
+    FSM_OUT_LOCK,
+    FSM_OUT_ECHO_KEY,               // Show `key` on the LCD
+    FSM_OUT_SET_WINDOW,             // Apply `window` and `filter`
+    FSM_OUT_SET_PATTERN,            // Pattern `key` - '0'
+    FSM_OUT_TOGGLE_UNIT,
+    FSM_OUT_EXPORT_LOG,
+    FSM_OUT_TRACE_DUMP,
+    FSM_OUT_SAMPLE,                 // Send the sample, to the LCD if unlocked
+    FSM_OUT_PERSIST,                // Save the state to FRAM
+    FSM_OUTPUTS
+} fsm_output_t;
+
+typedef struct
+{
+    fsm_state_t state;
+    char key;                       // Key of the event being handled
+    char code[FSM_CODE_LENGTH];     // Code keys so far
+    unsigned char code_count;
+    unsigned int failed;            // Wrong codes in a row
+    unsigned int window;            // Applied window and filter
+    unsigned char filter;
+    unsigned int window_entry;      // Digits typed after 'B', 0 = none
+    unsigned char filter_entry;     // Filter chosen after 'B'
+} fsm_t;
+
+void fsm_init(unsigned int window, unsigned char filter);
+fsm_event_t fsm_key_event(char key);
+void fsm_handle(fsm_event_t event, char key);
+bool fsm_unlocked(void);
+extern fsm_t fsm;
+
+// Provided by the application
+void fsm_output(fsm_output_t output, const fsm_t *machine);
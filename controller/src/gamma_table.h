@@ -0,0 +1,32 @@
+/*
+ * Colour component to RGB PWM compare value, generated by
+ * tools/gamma_table_gen.c. Do not edit; rerun the generator instead.
+ *
+ * Entry i is 1023 * (i / 255)^2.2, rounded.
+ */
+#define GAMMA_TABLE_MAX   1023
+
+static const unsigned int gamma_table[256] = {
+       0,    0,    0,    0,    0,    0,    0,    0,    1,    1,    1,    1,
+       1,    1,    2,    2,    2,    3,    3,    3,    4,    4,    5,    5,
+       6,    6,    7,    7,    8,    9,    9,   10,   11,   11,   12,   13,
+      14,   15,   16,   16,   17,   18,   19,   20,   21,   23,   24,   25,
+      26,   27,   28,   30,   31,   32,   34,   35,   36,   38,   39,   41,
+      42,   44,   46,   47,   49,   51,   52,   54,   56,   58,   60,   61,
+      63,   65,   67,   69,   71,   73,   76,   78,   80,   82,   84,   87,
+      89,   91,   94,   96,   98,  101,  103,  106,  109,  111,  114,  117,
+     119,  122,  125,  128,  130,  133,  136,  139,  142,  145,  148,  151,
+     155,  158,  161,  164,  167,  171,  174,  177,  181,  184,  188,  191,
+     195,  198,  202,  206,  209,  213,  217,  221,  225,  228,  232,  236,
+     240,  244,  248,  252,  257,  261,  265,  269,  274,  278,  282,  287,
+     291,  295,  300,  304,  309,  314,  318,  323,  328,  333,  337,  342,
+     347,  352,  357,  362,  367,  372,  377,  382,  387,  393,  398,  403,
+     408,  414,  419,  425,  430,  436,  441,  447,  452,  458,  464,  470,
+     475,  481,  487,  493,  499,  505,  511,  517,  523,  529,  535,  542,
+     548,  554,  561,  567,  573,  580,  586,  593,  599,  606,  613,  619,
+     626,  633,  640,  647,  653,  660,  667,  674,  681,  689,  696,  703,
+     710,  717,  725,  732,  739,  747,  754,  762,  769,  777,  784,  792,
+     800,  807,  815,  823,  831,  839,  847,  855,  863,  871,  879,  887,
+     895,  903,  912,  920,  928,  937,  945,  954,  962,  971,  979,  988,
+     997, 1005, 1014, 1023
+};
@@ -3,34 +3,26 @@
 #include <msp430.h>
 #include <stdbool.h>
 #include "heartbeat.h"
+#include "timer.h"
+#include "gpio.h"
 
+static soft_timer_t blink_timer;
+
+static bool heartbeat_blink(void)
+{
+    P6OUT ^= BIT6;
+    return false;
+}
+
+// A periodic software timer, so the heartbeat needs no timer or watchdog
+// of its own. Call after timer_init().
 void heartbeat_init()
 {
-    // Stop watchdog timer
-    WDTCTL = WDTPW | WDTHOLD;               // Stop watchdog timer
-    
     // Setup Ports
     P6DIR |= BIT6;              // Config P1.0 as output
     P6OUT &= ~BIT6;             // Clear 1.0 to start
-    PM5CTL0 &= ~LOCKLPM5;       // Turn on GPIO
+    GPIO_UNLOCK();
 
-    // Setup Timer
-    TB0CTL |= TBCLR;            // Clear timers and dividers
-    TB0CTL |= TBSSEL__ACLK;     // Source = ACLK
-    TB0CTL |= MC__UP;           // Mode = UP
-    TB0CCR0 = 32768;            // CCR0 = 32768 (1s overflow)
-    // 8192 = 0.25 seconds
-
-    // Setup Timer Compare IRQ
-    TB0CCTL0 &= ~CCIFG;         //Clear CCR0 Flag
-    TB0CCTL0 |= CCIE;           // Enable TB0 CCR0 Overflow IRQ
+    timer_start(&blink_timer, TIMER_HZ, TIMER_HZ, heartbeat_blink);    // 1 s
     __enable_interrupt();       // Enable Maskable IRQ
 }
-
-//-- Interrupt Service Routines ------------------
-#pragma vector = TIMER0_B0_VECTOR
-__interrupt void ISR_TB0_CCR0(void)
-{
-    P6OUT ^= BIT6;
-    TB0CCTL0 &= ~CCIFG;
-}
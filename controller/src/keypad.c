@@ -1,11 +1,11 @@
 #include <msp430.h>
-#include "msp430fr2355.h"
 #include "intrinsics.h"
 #include <stdbool.h>
-#include <stdio.h>
-#include "rgb_led.h"
-//#include "led_bar.h"
-#include "heartbeat.h"
+#include "keypad.h"
+#include "power.h"
+#include "clock.h"
+#include "timer.h"
+#include "ring.h"
 
 //KEYPAD I/O DECLARATION
 #define PROWDIR     P6DIR  // FORMERLY P1
@@ -14,188 +14,174 @@
 #define PROWOUT     P6OUT
 #define PCOLDIR     P5DIR   // FORMERLY P5
 #define PCOLOUT     P5OUT
+#define ROW_MASK    0x0F
+#define COL_MASK    0x0F
 
 //CONSTANTS DECLARATION
 #define COL 4
 #define ROW 4
-#define TABLE_SIZE 4
+#define KEYS (COL * ROW)
 
 //END CONSTANTS DECLARATION
 
-void debounce() {
-    volatile unsigned int i;
-    for (i = 20000; i > 0; i--) {}
-}
-
-char real_code[] = {'3','9','4','D'};
-
-char keypad[ROW][COL] = {
-    {'1', '2', '3', 'A'},
-    {'4', '5', '6', 'B'},
-    {'7', '8', '9', 'C'},
-    {'*', '0', '#', 'D'}
+// Legends by snapshot bit: bit (col * 4 + row) is set while that key is down
+const char keypad_keys[KEYS] = {
+    '1', '4', '7', '*',
+    '2', '5', '8', '0',
+    '3', '6', '9', '#',
+    'A', 'B', 'C', 'D'
 };
 
-int lockState = 3;
-
-// Function ton initialaize the ports
-void keypad_init() 
+static unsigned char integrator[KEYS];  // Per-key count of agreeing scans
+static unsigned int stable;             // Debounced state, 1 = pressed
+static unsigned int settling;           // Keys whose integrator is off its rail
+static bool idle;                       // No key down: check rows only, slowly
+static soft_timer_t scan_timer;
+static bool keypad_scan(void);
+
+// Single-producer (scan ISR) / single-consumer (main) event FIFO. The ISR
+// only advances fifo_head, main only advances fifo_tail (common/ring.h).
+RING_CHECK_SIZE(keypad_fifo, KEYPAD_FIFO_SIZE);
+static keypad_event_t fifo[KEYPAD_FIFO_SIZE];
+static volatile unsigned char fifo_head, fifo_tail;
+volatile unsigned int keypad_dropped_events;
+
+//----------------------------------------------------------------------
+// Begin Initializing Keypad Ports and Scan Timer
+//----------------------------------------------------------------------
+void keypad_init(void)
 {
     // Set rows as inputs (with pull-up)
-    PROWDIR &= ~0x0F;   // P1.0, P1.1, P1.2, P1.3 as inputs
-    PROWREN |= 0x0F;    // Activate pull-up
-    P1OUT |= 0x0F;    // Activar pull-up in rows
-    
+    PROWDIR &= ~ROW_MASK;   // P6.0, P6.1, P6.2, P6.3 as inputs
+    PROWREN |= ROW_MASK;    // Activate pull-up
+    PROWOUT |= ROW_MASK;    // Activar pull-up in rows
+
     // Set columns as outputs
-    PCOLDIR |= BIT0 | BIT1 | BIT2 | BIT3; // Set P5.0, P5.1, P5.2 y P5.3 as outputs:
-    PCOLOUT &= ~(BIT0 | BIT1 | BIT2 | BIT3);  // Set down the pins P5.0, P5.1, P5.2 y P5.3:
-}
+    PCOLDIR |= COL_MASK;    // Set P5.0, P5.1, P5.2 y P5.3 as outputs:
+    PCOLOUT &= ~COL_MASK;   // Set down the pins P5.0, P5.1, P5.2 y P5.3:
 
-char keypad_unlocking(void)
+    // Scan tick on the timer service, slow until a key goes down
+    idle = true;
+    timer_start(&scan_timer, KEYPAD_IDLE_TICK, KEYPAD_IDLE_TICK, keypad_scan);
+}
+//--End Initialize Keypad-----------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Read Matrix
+//----------------------------------------------------------------------
+// Drive one column low at a time and collect the rows it pulls down into
+// a 16-bit snapshot. Leaves all columns low so any press shows on a row.
+unsigned int keypad_read_matrix(void)
 {
-    int row, col;
-
-    // Go through 4 columns
-    for (col = 0; col < 4; col++) {
-        // Put column down (active)
-        PCOLOUT &= ~(1 << col);   // P2.0, P2.1, P2.2, P2.4
-         __delay_cycles(1000);  // Little stop to stabilize the signal
-
-        // Go through 4 rows
-        for (row = 0; row < 4; row++) {
-            if ((PROWIN & (1 << row)) == 0) {  // We detect that the row is low
-                debounce();  // Wait to filter the bouncing
-                if ((PROWIN & (1 << row)) == 0) {  // Confirm that the key is pressed
-                    continue_rgb_led(0);                // Set LED to yellow
-                    char key = keypad[row][col];
-                    // Wait until the key is released to avoid multiple readings 
-                    while ((PROWIN & (1 << row)) == 0);
-                    // Deactivate the column before returning
-                    PCOLOUT |= (1 << col);                    
-                    return key;
-                }
-            }
-        }
-        // Put the column high (desactivated)
-        PCOLOUT |= (1 << col);
+    unsigned int snapshot = 0;
+    unsigned char col;
+
+    for (col = 0; col < COL; col++) {
+        PCOLOUT = (PCOLOUT | COL_MASK) & ~(1 << col);
+        __delay_cycles(CLOCK_CYCLES_US(5)); // Let the row lines settle
+        snapshot |= (unsigned int)(~PROWIN & ROW_MASK) << (col * ROW);
     }
+    PCOLOUT &= ~COL_MASK;
+    return snapshot;
+}
+//--End Read Matrix-----------------------------------------------------
 
-    return 0; // No key pressed
+//----------------------------------------------------------------------
+// Begin Event FIFO
+//----------------------------------------------------------------------
+static void keypad_push(unsigned char index, bool pressed)
+{
+    keypad_event_t *event;
+
+    if (RING_FREE(fifo_head, fifo_tail, KEYPAD_FIFO_SIZE) == 0) {
+        keypad_dropped_events++;
+        return;
+    }
+    event = &fifo[RING_SLOT(fifo_head, KEYPAD_FIFO_SIZE)];
+    event->key = keypad_keys[index];
+    event->pressed = pressed;
+    fifo_head++;                    // Publish after the slot is written
 }
 
-char keypad_unlocked(void)
+// Take the oldest press/release event. Returns false when none is pending.
+bool keypad_get_event(keypad_event_t *event)
+{
+    if (fifo_tail == fifo_head) {
+        return false;
+    }
+    *event = fifo[RING_SLOT(fifo_tail, KEYPAD_FIFO_SIZE)];
+    fifo_tail++;
+    return true;
+}
+//--End Event FIFO------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Debounce
+//----------------------------------------------------------------------
+// Integrating debounce, one counter per key: each scan moves the counter
+// one step toward the raw reading, and the debounced state only flips
+// when the counter reaches a rail. A press is reported KEYPAD_DEBOUNCE
+// scans after contact settles; isolated glitches never reach a rail.
+// Returns true if an event was queued.
+bool keypad_debounce(unsigned int snapshot)
 {
-    char key_unlocked = '\0';
-
-    // Continuously poll until 'D' is pressed
-    while (key_unlocked != 'D') {
-        int row, col;
-
-        for (col = 0; col < 4; col++) {
-            // Activate column
-            PCOLOUT &= ~(1 << col);
-            __delay_cycles(1000);
-
-            // Check all rows
-            for (row = 0; row < 4; row++) {
-                if ((PROWIN & (1 << row)) == 0) {
-                    debounce();
-                    if ((PROWIN & (1 << row)) == 0) {
-                        key_unlocked = keypad[row][col];
-                        if (key_unlocked != 'D') {
-                            //set_led_bar(key_unlocked);
-                        }
-                        // Wait for key release
-                        while ((PROWIN & (1 << row)) == 0);
-                        PCOLOUT |= (1 << col);
-
-                        if (key_unlocked == 'D') {
-                            continue_rgb_led(3);  // Set LED to red when 'D' is pressed
-                            //set_led_bar('D');
-                            return key_unlocked;
-                        }
-                    }
-                }
+    unsigned int busy = (snapshot ^ stable) | settling;
+    unsigned int bit = 1;
+    unsigned char i;
+    unsigned char queued = fifo_head;
+
+    if (busy == 0) {
+        return false;               // Nothing moving, the usual case
+    }
+    for (i = 0; i < KEYS; i++, bit <<= 1) {
+        if (!(busy & bit)) {
+            continue;
+        }
+        if (snapshot & bit) {
+            if (integrator[i] < KEYPAD_DEBOUNCE && ++integrator[i] == KEYPAD_DEBOUNCE && !(stable & bit)) {
+                stable |= bit;
+                keypad_push(i, true);
             }
-            // Deactivate column
-            PCOLOUT |= (1 << col);
+        } else if (integrator[i] > 0 && --integrator[i] == 0 && (stable & bit)) {
+            stable &= ~bit;
+            keypad_push(i, false);
+        }
+        if (integrator[i] == 0 || integrator[i] == KEYPAD_DEBOUNCE) {
+            settling &= ~bit;
+        } else {
+            settling |= bit;
         }
     }
-
-    return key_unlocked;
+    return fifo_head != queued;
 }
-
-
-
-int keypad_main(void)
+//--End Debounce--------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Scan Timer
+//----------------------------------------------------------------------
+// Called from the timer interrupt. While no key is down all columns stay
+// low, so one read of the rows shows whether anything was pressed; the
+// full scan and debounce only run, at the faster tick, from then until
+// every key is released.
+static bool keypad_scan(void)
 {
-    // Stop watchdog timer
-    WDTCTL = WDTPW | WDTHOLD; // Stop watchdog timer
-    
-    // Disable the GPIO power-on default high-impedance mdoe to activate
-    // previously configure port settings
-    PM5CTL0 &= ~LOCKLPM5;
-    
-    int counter, i, equal;
-    char introduced_password[TABLE_SIZE], key, save_digit, key_unlocked; 
-
-    keypad_init();
-    init_heartbeat();
-    init_rgb_led();
-    //init_led_bar();
-      
-    while(true)
-    {   
-
-     counter = 0;
-     key = 0;
-    
-     printf("Introduce the code\n");
-
-     while (counter < TABLE_SIZE)
-     {
-        key = keypad_unlocking();
-        if(key!=0)
-        {
-            introduced_password [counter] = key;
-            counter++;
-        }        
-     }
-
-     //Compare the introduced code with the real code   
-     equal = 1;   
-     for (i = 0; i < TABLE_SIZE; i++) {
-        if (introduced_password[i] != real_code[i]) 
-        {
-            equal = 0;
-            break;
+    bool queued;
+
+    if (idle) {
+        if ((PROWIN & ROW_MASK) == ROW_MASK) {
+            return false;
         }
+        idle = false;
+        timer_set_period(&scan_timer, KEYPAD_TICK);
     }
-
-        // Verify the code
-        if (equal==1) 
-        {
-            printf("Correct Code!\n");
-            counter = 0;
-            continue_rgb_led(1);            // Set LED to blue
-            for (i = 0; i < TABLE_SIZE; i++) 
-            {
-                introduced_password[i] = 0;        
-            }
-            keypad_unlocked();  // This now handles polling until 'D' is pressed
-
-
-        } 
-        else 
-        {
-            printf("Incorrect code. Try again.\n");
-            counter = 0;  // Reinitiate counter to try again
-            continue_rgb_led(3);            // Set LED to red
-            //led_patterns('\0');
-            for (i = 0; i < TABLE_SIZE; i++) 
-            {
-                introduced_password[i] = 0;        
-            }
-        }    
+    queued = keypad_debounce(keypad_read_matrix());
+    if (queued) {
+        power_wake_pending = true;  // The timer interrupt leaves LPM on exit
+    }
+    if (stable == 0 && settling == 0) {
+        idle = true;
+        timer_set_period(&scan_timer, KEYPAD_IDLE_TICK);
     }
+    return queued;
 }
+//--End Scan Timer------------------------------------------------------
@@ -1,4 +1,19 @@
+#include <stdbool.h>
+
+#define KEYPAD_TICK          64     // Scan period in ACLK counts (~2 ms)
+#define KEYPAD_IDLE_TICK     1024   // Idle check period with no key down (~31 ms)
+#define KEYPAD_DEBOUNCE      5      // Consecutive agreeing scans to accept a change
+#define KEYPAD_FIFO_SIZE     16     // Pending events, power of two
+
+typedef struct
+{
+    char key;                       // Legend from the keypad table, e.g. '5'
+    bool pressed;                   // true on press, false on release
+} keypad_event_t;
+
 void keypad_init(void);
-char keypad_unlocking(void);
-char keypad_unlocked(void);
-int  keypad_main(void);
+bool keypad_get_event(keypad_event_t *event);
+unsigned int keypad_read_matrix(void);
+bool keypad_debounce(unsigned int snapshot);
+
+extern volatile unsigned int keypad_dropped_events; // Events lost to a full FIFO
@@ -0,0 +1,43 @@
+#include "lm19.h"
+#include "lm19_table.h"
+
+//----------------------------------------------------------------------
+// Begin Celsius
+//----------------------------------------------------------------------
+// Temperature at an averaged ADC code in Q4 (1/16 LSB). The table covers
+// the whole code range in steps of 128 codes, so the top bits pick the
+// segment and the rest interpolate along it; the LM19 curve is close
+// enough to straight over a segment to stay within 0.01 degC.
+int lm19_centi_celsius(unsigned int code_q4)
+{
+    unsigned int i = code_q4 >> LM19_TABLE_SHIFT;
+    unsigned int frac = code_q4 & ((1U << LM19_TABLE_SHIFT) - 1);
+    int delta = lm19_table[i + 1] - lm19_table[i];
+
+    return lm19_table[i] + (int)(((long)delta * frac + (1L << (LM19_TABLE_SHIFT - 1))) >> LM19_TABLE_SHIFT);
+}
+//--End Celsius---------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Fahrenheit
+//----------------------------------------------------------------------
+// F = C * 9/5 + 32, with 117965/65536 standing in for 9/5.
+int lm19_centi_fahrenheit(int centi_celsius)
+{
+    return (int)(((long)centi_celsius * 117965L + 32768L) >> 16) + 3200;
+}
+//--End Fahrenheit------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Tenths
+//----------------------------------------------------------------------
+// Round hundredths to the nearest tenth, halves away from zero.
+// 52429/2^19 is 1/10 rounded up, which is exact for every int input.
+int lm19_tenths(int centi)
+{
+    unsigned long magnitude = centi < 0 ? -(long)centi : centi;
+    int tenths = (int)((magnitude * 52429UL + (1UL << 18)) >> 19);
+
+    return centi < 0 ? -tenths : tenths;
+}
+//--End Tenths----------------------------------------------------------
@@ -0,0 +1,5 @@
+// LM19 conversions in integer math. Temperatures are in hundredths of a
+// degree ("centi") until lm19_tenths() rounds them for display.
+int lm19_centi_celsius(unsigned int code_q4);
+int lm19_centi_fahrenheit(int centi_celsius);
+int lm19_tenths(int centi);
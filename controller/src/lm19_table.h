@@ -0,0 +1,17 @@
+/*
+ * LM19 ADC code to temperature, generated by tools/lm19_table_gen.c.
+ * Do not edit; rerun the generator instead.
+ *
+ * Entry i is the temperature in 0.01 degC at a Q4 (1/16 LSB) ADC code
+ * of i << LM19_TABLE_SHIFT, 12-bit ADC against a 3.3 V reference.
+ */
+#define LM19_TABLE_SHIFT  11
+#define LM19_TABLE_SIZE   33
+
+static const int lm19_table[LM19_TABLE_SIZE] = {
+     15407,  14592,  13774,  12951,  12125,  11294,  10458,   9618,
+      8774,   7925,   7072,   6213,   5350,   4482,   3609,   2731,
+      1848,    960,     66,   -833,  -1737,  -2648,  -3563,  -4485,
+     -5413,  -6347,  -7287,  -8233,  -9186, -10145, -11111, -12084,
+    -13064
+};
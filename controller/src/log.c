@@ -0,0 +1,86 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include "log.h"
+#include "i2c_frame.h"
+#include "ring.h"
+
+typedef struct
+{
+    unsigned char id;
+    unsigned char seq;
+    unsigned int arg;
+} log_entry_t;
+
+//----------------------------------------------------------------------
+// Log Ring
+//----------------------------------------------------------------------
+// Any context writes, with interrupts off for the few instructions it
+// takes; only the UART interrupt reads (common/ring.h).
+RING_CHECK_SIZE(log, LOG_RING_SIZE);
+static log_entry_t ring[LOG_RING_SIZE];
+static volatile unsigned char log_head, log_tail;
+static unsigned char sequence;
+
+volatile unsigned int log_dropped;
+//--End Log Ring--------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Log Put
+//----------------------------------------------------------------------
+// Queue a message for the UART, or count it dropped if the ring is full.
+// Formatting and the CRC are left to the interrupt that sends it.
+void log_put(log_id_t id, unsigned int arg)
+{
+    unsigned int sr = __get_SR_register();
+    log_entry_t *entry;
+
+    __disable_interrupt();
+    if (RING_FREE(log_head, log_tail, LOG_RING_SIZE) == 0) {
+        log_dropped++;
+    } else {
+        entry = &ring[RING_SLOT(log_head, LOG_RING_SIZE)];
+        entry->id = (unsigned char)id;
+        entry->seq = sequence;
+        entry->arg = arg;
+        log_head++;
+    }
+    sequence++;
+    __bis_SR_register(sr & GIE);
+    UCA1IE |= UCTXIE;                   // The telemetry UART drains it (telemetry.c)
+}
+//--End Log Put---------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Log Take
+//----------------------------------------------------------------------
+// Called from the telemetry UART interrupt: move the oldest message into
+// `frame` as its wire frame. Returns the frame's size, 0 if none is queued.
+unsigned char log_take(unsigned char *frame)
+{
+    const log_entry_t *entry;
+    unsigned char crc = 0, i;
+
+    if (log_tail == log_head) {
+        return 0;
+    }
+    entry = &ring[RING_SLOT(log_tail, LOG_RING_SIZE)];
+    frame[0] = 'T';
+    frame[1] = 'G';
+    frame[2] = entry->seq;
+    frame[3] = entry->id;
+    frame[4] = entry->arg & 0xFF;
+    frame[5] = entry->arg >> 8;
+    log_tail++;
+    for (i = 2; i < LOG_FRAME_SIZE - 1; i++) {
+        crc = crc8_update(crc, frame[i]);
+    }
+    frame[LOG_FRAME_SIZE - 1] = crc;
+    return LOG_FRAME_SIZE;
+}
+
+bool log_pending(void)
+{
+    return log_head != log_tail;
+}
+//--End Log Take--------------------------------------------------------
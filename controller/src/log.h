@@ -0,0 +1,29 @@
+#include <stdbool.h>
+#include "log_ids.h"
+
+// Deferred log: log_put() stores a message ID (log_ids.h) and one 16-bit
+// argument in a RAM ring in a few instructions, from main or an ISR, and
+// never waits; use it once telemetry_init() has set the UART up. The
+// telemetry UART interrupt drains the ring between telemetry records, one
+// frame per message, little-endian:
+//
+//   'T' 'G' seq(1) id(1) arg(2) crc8
+//
+// crc8 (common/i2c_frame.h) covers seq to arg. `seq` counts every message,
+// sent or not, so tools/log_decode.c can report those lost to a full ring.
+#define LOG_RING_SIZE   16      // Messages, power of two
+#define LOG_FRAME_SIZE  7
+
+#define LOG_ID(id, format)  id,
+typedef enum
+{
+    LOG_MESSAGES(LOG_ID)
+    LOG_IDS
+} log_id_t;
+#undef LOG_ID
+
+void log_put(log_id_t id, unsigned int arg);
+unsigned char log_take(unsigned char *frame);
+bool log_pending(void);
+
+extern volatile unsigned int log_dropped;   // Messages lost to a full ring
@@ -0,0 +1,11 @@
+// Every log message: its ID and the text tools/log_decode.c prints for
+// it, with the message's argument formatted by any printf conversion for
+// an unsigned int (%u, %d, %x, %c). The strings never reach the firmware,
+// only the IDs, which are positions in this list: add new messages at
+// the end, and decode with the list the firmware was built from.
+#define LOG_MESSAGES(X)                                                         \
+    X(LOG_START,            "controller started")                              \
+    X(LOG_CODE_CORRECT,     "correct code, unlocked")                          \
+    X(LOG_CODE_INCORRECT,   "incorrect code, try again (%u in a row)")         \
+    X(LOG_LOCKED,           "locked with D")                                   \
+    X(LOG_EXPORT_BUSY,      "temperature log export refused: one is running")
@@ -1,27 +1,62 @@
 #include "intrinsics.h"
 #include <msp430.h>
+#include <stdbool.h>
 #include "master_i2c.h"
+#include "trace.h"
+#include "i2c_frame.h"
+#include "clock.h"
+#include "gpio.h"
+#include "ring.h"
 
-char packet;    // Data to be sent using I2C
+// Fast mode (400 kHz) needs a bit clock divider of at least 4
+#define I2C_SCL_HZ  (CLOCK_SMCLK_HZ >= 4 * 400000UL ? 400000UL : 100000UL)
+
+//----------------------------------------------------------------------
+// Transmit Queue
+//----------------------------------------------------------------------
+// Messages are queued by the application and sent by EUSCI_B1_I2C_ISR,
+// so master_i2c_send() returns as soon as the bytes are copied. The
+// queue is single-producer (main) / single-consumer (ISR): main only
+// advances the heads, the ISR only advances the tails (common/ring.h).
+#define I2C_MSG_QUEUE_SIZE  8       // Queued transactions
+#define I2C_BYTE_QUEUE_SIZE 32      // Queued payload bytes, all messages
+
+RING_CHECK_SIZE(i2c_msg, I2C_MSG_QUEUE_SIZE);
+RING_CHECK_SIZE(i2c_byte, I2C_BYTE_QUEUE_SIZE);
+
+typedef struct
+{
+    unsigned char address;          // 7-bit slave address
+    unsigned char length;           // Payload bytes in byte_queue
+} i2c_msg_t;
+
+static i2c_msg_t msg_queue[I2C_MSG_QUEUE_SIZE];
+static unsigned char byte_queue[I2C_BYTE_QUEUE_SIZE];
+static volatile unsigned char msg_head, msg_tail;
+static volatile unsigned char byte_head, byte_tail;
+static unsigned char tx_remaining;  // Bytes left in the active message
+static bool tx_retired;             // Last byte sent, its ACK still to come
+static volatile bool i2c_active;    // A START has been issued, STOP pending
+
+volatile unsigned int master_i2c_nack_count;
+volatile unsigned int master_i2c_overflow_count;
+//--End Transmit Queue--------------------------------------------------
 
 //----------------------------------------------------------------------
 // Begin Master I2C Initialization
 //----------------------------------------------------------------------
 void master_i2c_init(void)
 {
-    WDTCTL = WDTPW | WDTHOLD;               // Stop watchdog timer
-    
     UCB1CTLW0 |= UCSWRST;                   // Put eUSCI_B0 into software reset
 
-    UCB1CTLW0 |= UCSSEL_3;                  // Choose BRCLK=SMCLK=1MHz
-    UCB1BRW = 10;                           // Divide BRCLK by 10 for SCL=100kHz
+    UCB1CTLW0 |= UCSSEL_3;                  // Choose BRCLK=SMCLK
+    UCB1BRW = (CLOCK_SMCLK_HZ + I2C_SCL_HZ - 1) / I2C_SCL_HZ;  // SCL at or below I2C_SCL_HZ
 
     UCB1CTLW0 |= UCMODE_3;                  // Put into I2C mode
     UCB1CTLW0 |= UCMST;                     // Put into master mode
     UCB1CTLW0 |= UCTR;                      // Put into Tx mode
-
-    UCB1CTLW1 |= UCASTP_2;                  // Auto STOP when UCB0TBCNT reached
-    UCB1TBCNT = 1;                          // # of Bytes in Packet
+                                            // STOP is issued by the ISR, so the
+                                            // byte counter is not used
 
     P4SEL1 &= ~BIT6;                        // We want P1.2 = SDA
     P4SEL0 |= BIT6;
@@ -31,42 +66,151 @@ void master_i2c_init(void)
     P6OUT &= ~BIT6;                         // Clear P1.0 output latch for a defined power-on state
     P6DIR |= BIT6;                          // Set P1.0 to output direction
 
-    PM5CTL0 &= ~LOCKLPM5;                   // Disable the GPIO power-on default high-impedance mode
-                                            // to activate previously configured port settings
+    GPIO_UNLOCK();                          // Activate the port settings above
     UCB1CTLW0 &= ~UCSWRST;                  // Take eUSCI_B0 out of SW reset
-    UCB1IE |= UCTXIE0;                      // Enable I2C Tx0 IRQ
+    UCB1IE |= UCTXIE0 | UCNACKIE | UCSTPIE; // Enable Tx0, NACK and STOP IRQs
     __enable_interrupt();                   // Enable Maskable IRQs
-    
+
 }
 //--End Master I2C Init-------------------------------------------------
 
 //----------------------------------------------------------------------
-// Begin Master I2C Packet
+// Begin Master I2C Start Next
 //----------------------------------------------------------------------
-void master_i2c_packet(char input, int address)
+// Issue a START for the message at the queue tail, or mark the bus idle.
+// Called from the ISR, or from main with interrupts disabled.
+static void master_i2c_start_next(void)
 {
-    packet = input;
+    if (msg_tail == msg_head) {
+        i2c_active = false;
+        return;
+    }
+    i2c_msg_t *msg = &msg_queue[RING_SLOT(msg_tail, I2C_MSG_QUEUE_SIZE)];
+    UCB1I2CSA = msg->address;
+    tx_remaining = msg->length;
+    i2c_active = true;
+    UCB1CTLW0 |= UCTR | UCTXSTT;            // Generate START condition
 }
-//--End I2C Packet------------------------------------------------------
+//--End Master I2C Start Next-------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Master I2C Write
+//----------------------------------------------------------------------
+// Queue a multi-byte message. Returns false, and sends nothing, when the
+// queue cannot hold the whole message.
+bool master_i2c_write(int address, const char *data, unsigned char length)
+{
+    unsigned int sr = __get_SR_register();
+    unsigned char i;
+    unsigned char head = byte_head;
+    unsigned char bytes_free = RING_FREE(head, byte_tail, I2C_BYTE_QUEUE_SIZE);
+
+    if (length == 0 || length > bytes_free || RING_FREE(msg_head, msg_tail, I2C_MSG_QUEUE_SIZE) == 0) {
+        master_i2c_overflow_count++;
+        return false;
+    }
+
+    for (i = 0; i < length; i++) {
+        byte_queue[RING_SLOT(head + i, I2C_BYTE_QUEUE_SIZE)] = data[i];
+    }
+    msg_queue[RING_SLOT(msg_head, I2C_MSG_QUEUE_SIZE)].address = address;
+    msg_queue[RING_SLOT(msg_head, I2C_MSG_QUEUE_SIZE)].length = length;
+    byte_head = head + length;
+    msg_head++;                             // Publish the message to the ISR
+
+    // Kick the bus if it is idle; otherwise the STOP IRQ picks this up.
+    // Leaves GIE as the caller had it.
+    __disable_interrupt();
+    if (!i2c_active) {
+        master_i2c_start_next();
+    }
+    __bis_SR_register(sr & GIE);
+    return true;
+}
+//--End Master I2C Write------------------------------------------------
 
 //----------------------------------------------------------------------
 // Begin Master I2C Send
 //----------------------------------------------------------------------
 void master_i2c_send(char input, int address)
 {
-    UCB1I2CSA = address;
-    packet = input;
-    UCB1CTLW0 |= UCTXSTT;               // Generate START condition
-    __delay_cycles(50000);              // delay loop
+    master_i2c_write(address, &input, 1);
 }
 //--End Master I2C Send-------------------------------------------------
 
+//----------------------------------------------------------------------
+// Begin Master I2C Send Frame
+//----------------------------------------------------------------------
+// Wrap a command in the common/i2c_frame.h format and queue it as one
+// transaction.
+bool master_i2c_send_frame(int address, unsigned char opcode, const unsigned char *payload,
+                           unsigned char length)
+{
+    unsigned char frame[FRAME_MAX_SIZE];
+    unsigned char size = i2c_frame_encode(frame, opcode, payload, length);
+
+    return size != 0 && master_i2c_write(address, (const char *)frame, size);
+}
+//--End Master I2C Send Frame-------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Master I2C Busy
+//----------------------------------------------------------------------
+bool master_i2c_busy(void)
+{
+    return i2c_active;
+}
+//--End Master I2C Busy-------------------------------------------------
+
 //----------------------------------------------------------------------
 // Begin Interrupt Service Routine
 //----------------------------------------------------------------------
-// Send data from packet using I2C
+// Feed the active message to UCB1TXBUF. Back-to-back messages are
+// chained with a repeated START; the last one ends with a STOP, and a
+// message queued after that is started once the STOP has gone out.
+// A message leaves the queue when its last byte moves to the shift
+// register, before that byte is ACKed, so a NACK then must not drop it
+// again, nor the message chained after it.
 #pragma vector=EUSCI_B1_VECTOR
 __interrupt void EUSCI_B1_I2C_ISR(void){
-    UCB1TXBUF = packet;
+    TRACE_ENTER(TRACE_I2C_MASTER);
+    switch (__even_in_range(UCB1IV, USCI_I2C_UCBIT9IFG))
+    {
+        case USCI_I2C_UCNACKIFG:            // Slave did not ACK
+            master_i2c_nack_count++;
+            if (tx_retired) {               // The last byte: STOP or START already set
+                tx_retired = false;
+                break;
+            }
+            byte_tail += tx_remaining;      // Address or a byte before the last: drop it
+            tx_remaining = 0;
+            msg_tail++;
+            UCB1CTLW0 |= UCTXSTP;
+            break;
+        case USCI_I2C_UCSTPIFG:             // STOP sent, bus is free
+            tx_retired = false;
+            master_i2c_start_next();
+            break;
+        case USCI_I2C_UCTXIFG0:             // Ready for the next byte
+            tx_retired = false;             // Any earlier last byte was ACKed
+            if (tx_remaining) {
+                UCB1TXBUF = byte_queue[RING_SLOT(byte_tail, I2C_BYTE_QUEUE_SIZE)];
+                byte_tail++;
+                tx_remaining--;
+            } else {                        // Last byte is on the wire
+                tx_retired = true;
+                msg_tail++;
+                if (msg_tail != msg_head) {
+                    master_i2c_start_next();  // Repeated START, keep the bus
+                } else {
+                    UCB1CTLW0 |= UCTXSTP;
+                }
+                UCB1IFG &= ~UCTXIFG0;
+            }
+            break;
+        default:
+            break;
+    }
+    TRACE_EXIT(TRACE_I2C_MASTER);
 }
 //--End Interrupt Service Routine---------------------------------------
@@ -1,2 +1,11 @@
+#include <stdbool.h>
+
 void master_i2c_init(void);
 void master_i2c_send(char input, int address);
+bool master_i2c_write(int address, const char *data, unsigned char length);
+bool master_i2c_send_frame(int address, unsigned char opcode, const unsigned char *payload,
+                           unsigned char length);
+bool master_i2c_busy(void);
+
+extern volatile unsigned int master_i2c_nack_count;     // Messages dropped by a NACK
+extern volatile unsigned int master_i2c_overflow_count; // Messages refused, queue full
@@ -0,0 +1,154 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include "power.h"
+#include "master_i2c.h"
+#include "rgb_led.h"
+#include "telemetry.h"
+#include "trace.h"
+
+volatile bool power_wake_pending;   // An ISR queued work since main last slept
+
+#ifdef POWER_ACCOUNTING
+static volatile unsigned int power_overflows;   // TB2 wraps, high word of time
+static unsigned long active_ticks, slow_ticks, lpm0_ticks, lpm3_ticks;
+static unsigned long awake_since;
+#endif
+
+//----------------------------------------------------------------------
+// Begin Power Clock
+//----------------------------------------------------------------------
+#ifdef POWER_ACCOUNTING
+// 32-bit ACLK time from the free-running timer service (TB2). TB2R runs
+// asynchronously to MCLK, so read it until two reads agree.
+static unsigned long power_now(void)
+{
+    unsigned int high, low, check;
+
+    do {
+        high = power_overflows;
+        do {
+            low = TB2R;
+            check = TB2R;
+        } while (low != check);
+    } while (high != power_overflows);
+    return ((unsigned long)high << 16) | low;
+}
+#endif
+//--End Power Clock-----------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Power Initialization
+//----------------------------------------------------------------------
+// Call after timer_init(), which starts TB2.
+void power_init(void)
+{
+#ifdef POWER_ACCOUNTING
+    TB2CTL &= ~TBIFG;
+    TB2CTL |= TBIE;             // Count TB2 wraps for the time base
+    awake_since = power_now();
+#endif
+}
+//--End Power Initialization--------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Power Sleep
+//----------------------------------------------------------------------
+// Sleep until an ISR wakes main with POWER_WAKE_ON_EXIT(). Uses LPM3
+// (ACLK only) unless a peripheral still needs SMCLK, in which case
+// LPM0: the I2C master or the telemetry UART while it sends, the RGB PWM
+// while it is lit.
+// Returns immediately if work was posted since the last call.
+void power_sleep(void)
+{
+    unsigned int mode = (master_i2c_busy() || telemetry_busy() || rgb_led_lit()) ? LPM0_bits : LPM3_bits;
+#ifdef POWER_ACCOUNTING
+    unsigned long asleep_since = power_now();
+
+    active_ticks += asleep_since - awake_since;
+    if (clock_speed() == CLOCK_SLOW) {      // The speed as main goes to sleep
+        slow_ticks += asleep_since - awake_since;
+    }
+#endif
+
+    // Check and sleep with interrupts off, so a wake-up posted in between
+    // cannot be missed; entering LPM sets GIE in the same instruction.
+    __disable_interrupt();
+    if (!power_wake_pending) {
+        __bis_SR_register(mode | GIE);
+    } else {
+        __enable_interrupt();
+    }
+    power_wake_pending = false;
+
+#ifdef POWER_ACCOUNTING
+    awake_since = power_now();
+    if (mode == LPM3_bits) {
+        lpm3_ticks += awake_since - asleep_since;
+    } else {
+        lpm0_ticks += awake_since - asleep_since;
+    }
+#endif
+}
+//--End Power Sleep-----------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Power Statistics
+//----------------------------------------------------------------------
+void power_get_stats(power_stats_t *stats)
+{
+#ifdef POWER_ACCOUNTING
+    unsigned long active = active_ticks + (power_now() - awake_since);
+    unsigned long slow = slow_ticks;
+    unsigned long lpm0 = lpm0_ticks;
+    unsigned long lpm3 = lpm3_ticks;
+    unsigned long total;
+
+    stats->active_ticks = active;
+    stats->slow_ticks = slow;
+    stats->lpm0_ticks = lpm0;
+    stats->lpm3_ticks = lpm3;
+
+    // Scale down so the products below, up to total * POWER_ACTIVE_UA,
+    // fit in 32 bits
+    total = active + lpm0 + lpm3;
+    while (total > 0xFFFFFFFFUL / POWER_ACTIVE_UA) {
+        active >>= 1;
+        slow >>= 1;
+        lpm0 >>= 1;
+        lpm3 >>= 1;
+        total = active + lpm0 + lpm3;
+    }
+    if (total == 0) {
+        total = 1;
+    }
+    stats->duty_permille = active * 1000 / total;
+    stats->average_ua = ((active - slow) * POWER_ACTIVE_UA + slow * POWER_ACTIVE_SLOW_UA +
+                         lpm0 * POWER_LPM0_UA + lpm3 * POWER_LPM3_UA) / total;
+#else
+    stats->active_ticks = stats->slow_ticks = stats->lpm0_ticks = stats->lpm3_ticks = 0;
+    stats->duty_permille = 1000;
+    stats->average_ua = POWER_ACTIVE_UA;
+#endif
+}
+//--End Power Statistics------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Interrupt Service Routine
+//----------------------------------------------------------------------
+#ifdef POWER_ACCOUNTING
+#pragma vector = TIMER2_B1_VECTOR
+__interrupt void ISR_TB2_CCRn(void)
+{
+    TRACE_ENTER(TRACE_TIMER2_B1);
+    switch (__even_in_range(TB2IV, 14))
+    {
+        case 14:                        // Timer overflow
+            power_overflows++;
+            break;
+        default: break;
+    }
+    TRACE_EXIT(TRACE_TIMER2_B1);
+}
+#endif
+//--End Interrupt Service Routine---------------------------------------
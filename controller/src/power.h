@@ -0,0 +1,39 @@
+#include <stdbool.h>
+#include "clock.h"
+
+// Build with POWER_ACCOUNTING defined to track time awake vs. asleep.
+// Current figures are MSP430FR2355 datasheet typicals at 3 V with ACLK
+// from REFO, scaled to the MCLK of each clock_set_speed() setting. In
+// LPM0 the DCO and FLL keep running at CLOCK_MCLK_HZ whatever the speed;
+// that figure is an estimate from the 1 MHz typical, so measure it before
+// relying on the average.
+#define POWER_AM_UA_PER_MHZ     142     // AM, FRAM
+#define POWER_LPM0_UA_PER_MHZ   20      // LPM0, DCO + FLL, SMCLK for I2C and the RGB PWM
+#define POWER_ACTIVE_UA         (POWER_AM_UA_PER_MHZ * (CLOCK_MCLK_HZ / 1000000UL))
+#define POWER_ACTIVE_SLOW_UA    (POWER_AM_UA_PER_MHZ * CLOCK_SMCLK_HZ / 1000000UL)
+#define POWER_LPM0_UA           (POWER_LPM0_UA_PER_MHZ * (CLOCK_MCLK_HZ / 1000000UL))
+#define POWER_LPM3_UA           15      // LPM3, REFO + timers running
+
+extern volatile bool power_wake_pending;
+
+// Use inside an ISR that has produced work for main: makes the pending
+// or next power_sleep() return to main instead of staying asleep.
+#define POWER_WAKE_ON_EXIT()                        \
+    do {                                            \
+        power_wake_pending = true;                  \
+        __bic_SR_register_on_exit(LPM3_bits);       \
+    } while (0)
+
+typedef struct
+{
+    unsigned long active_ticks;     // ACLK ticks spent awake in main
+    unsigned long slow_ticks;       // Of those, at CLOCK_SLOW
+    unsigned long lpm0_ticks;       // ACLK ticks in LPM0
+    unsigned long lpm3_ticks;       // ACLK ticks in LPM3
+    unsigned int  duty_permille;    // Awake share of the total, 0-1000
+    unsigned int  average_ua;       // Estimated average supply current
+} power_stats_t;
+
+void power_init(void);
+void power_sleep(void);
+void power_get_stats(power_stats_t *stats);
@@ -2,127 +2,210 @@
 #include "msp430fr2355.h"
 #include "intrinsics.h"
 #include <stdbool.h>
-#include <stdio.h>
 #include "rgb_led.h"
+#include "gamma_table.h"
+#include "trace.h"
+#include "gpio.h"
+#ifdef RGB_IDLE_BLANK
+#include "timer.h"
+#endif
 
+#if GAMMA_TABLE_MAX != RGB_PWM_PERIOD - 1
+#error "gamma_table.h was generated for another RGB_PWM_PERIOD"
+#endif
 
-void rgb_pins_init()
-{       
-    P1DIR |= BIT5 | BIT6 | BIT7; // Set P1.5, P1.6 y P1.7 as an output 
-    P1OUT |= BIT5 | BIT6 | BIT7; // Initialize outputs as high
-}
+#if RGB_FADE_STEPS < 1 || RGB_FADE_STEPS > 255
+#error "RGB_FADE_STEPS must fit in an unsigned char"
+#endif
+
+#define RGB_CHANNELS    3           // Red, green, blue
+#define LEVEL_SHIFT     7           // Fade level: colour component in Q8.7
+
+//----------------------------------------------------------------------
+// Colour Table
+//----------------------------------------------------------------------
+// Colour codes per lock state, indexed by rgb_led_continue()'s argument.
+// gamma_table.h turns each component into a duty, so these read like
+// ordinary "#RRGGBB" colours.
+static const unsigned char colours[][RGB_CHANNELS] = {
+    { 0xC4, 0x92, 0x1D },           // 0: unlocking, yellow #C4921D
+    { 0x1D, 0xA2, 0xC4 },           // 1: unlocked, blue #1DA2C4
+    { 0xC4, 0x3E, 0x1D }            // 2: locked, red #C43E1D
+};
+#define COLOUR_LOCKED   2
 
-void interrupts_init()
+static int level[RGB_CHANNELS];     // Shown colour, Q8.7
+static int step[RGB_CHANNELS];      // Change per fade step, Q8.7
+static unsigned char target[RGB_CHANNELS];
+static volatile unsigned char steps_left;
+static unsigned char periods_left;  // PWM periods until the next step
+#ifdef RGB_IDLE_BLANK
+static soft_timer_t idle_timer;     // Fades to dark after RGB_IDLE_MS
+static bool rgb_idle(void);
+#endif
+//--End Colour Table----------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin RGB Output
+//----------------------------------------------------------------------
+// CLLD_1 latches a new duty at the start of the next period, so a change
+// never cuts a pulse short.
+static void rgb_output(void)
 {
-    // Setup Timer B3
-    TB3CTL |= TBCLR;        // Clear timer and dividers
-    TB3CTL |= TBSSEL__ACLK; // Source=ACLK
-    TB3CTL |= MC__UP;       // Mode=UP
-    
-    // Setup Timer Compare IRQ for CCR0 (Pull up)
-    TB3CCR0 = 255;         // CCR0=255
-    TB3CCTL0 |= CCIE;       //Enable TB3 CCR0 Overflow IRQ
-    TB3CCTL0 &= ~CCIFG;     // Clear CCR0 Flag
-
-    // Setup Timer Compare IRQ for CCR0 (Pull down RED)
-    TB3CCR1 = 225-196;         // CCR1=196
-    TB3CCTL1 |= CCIE;       //Enable TB3 CCR1 Overflow IRQ
-    TB3CCTL1 &= ~CCIFG;     // Clear CCR1 Flag
-
-    // Setup Timer Compare IRQ for CCR0 (Pull down GREEN)
-    TB3CCR2 = 225-62;          // CCR2=62
-    TB3CCTL2 |= CCIE;       //Enable TB3 CCR1 Overflow IRQ
-    TB3CCTL2 &= ~CCIFG;     // Clear CCR2 Flag
-
-    // Setup Timer Compare IRQ for CCR0 (Pull down BLUE)
-    TB3CCR3 = 225-29;          //CCR3=29
-    TB3CCTL3 |= CCIE;       //Enable TB3 CCR1 Overflow IRQ
-    TB3CCTL3 &= ~CCIFG;     // Clear CCR3 Flag
-
-    _enable_interrupt();    // Enable Maskable IRQs
+    TB3CCR5 = gamma_table[level[0] >> LEVEL_SHIFT];
+    TB0CCR1 = gamma_table[level[1] >> LEVEL_SHIFT];
+    TB0CCR2 = gamma_table[level[2] >> LEVEL_SHIFT];
 }
 
-void led_c43e1d(void)           // Red
+// Reset/set from the timers while lit; held low (OUTMOD_0, OUT = 0) when
+// dark, so the pins stay off with SMCLK stopped in LPM3
+static void rgb_outputs_on(bool on)
 {
-    TB3CCR1 = 220;             // CCR1=196 (Red)
-    TB3CCR2 = 1;              // CCR2=62  (Green)
-    TB3CCR3 = 1;              //CCR3=29   (Blue)
+    unsigned int mode = on ? OUTMOD_7 | CLLD_1 : OUTMOD_0;
 
+    TB3CCTL5 = mode;
+    TB0CCTL1 = mode;
+    TB0CCTL2 = mode;
 }
+//--End RGB Output------------------------------------------------------
 
-void led_c4921d(void)           // Yellow
+//----------------------------------------------------------------------
+// Begin RGB Initialization
+//----------------------------------------------------------------------
+// TB0 and TB3 both count up to RGB_PWM_PERIOD - 1 on SMCLK. TB3's
+// overflow interrupt paces fades and is only enabled while one runs.
+void rgb_led_init(void)
 {
-    TB3CCR1 = 220;             // CCR1=196 (Red)
-    TB3CCR2 = 160;             // CCR2=146 (Green)
-    TB3CCR3 = 5;              //CCR3=29   (Blue)
+    unsigned char i;
+
+    P6DIR |= BIT4;                  // P6.4 = TB3.5 (red)
+    P6SEL0 |= BIT4;
+    P1DIR |= BIT6 | BIT7;           // P1.6 = TB0.1 (green), P1.7 = TB0.2 (blue)
+    P1SEL1 |= BIT6 | BIT7;
+    P1SEL0 &= ~(BIT6 | BIT7);
+    GPIO_UNLOCK();
+
+    for (i = 0; i < RGB_CHANNELS; i++) {
+        target[i] = colours[COLOUR_LOCKED][i];
+        level[i] = target[i] << LEVEL_SHIFT;
+    }
+    rgb_output();
+
+    TB3CTL = TBSSEL__SMCLK | TBCLR;
+    TB3CCR0 = RGB_PWM_PERIOD - 1;
+    TB0CTL = TBSSEL__SMCLK | TBCLR;
+    TB0CCR0 = RGB_PWM_PERIOD - 1;
+    rgb_outputs_on(true);           // Reset/set: high for CCRn counts
+    TB0CTL |= MC__UP;               // Start both together
+    TB3CTL |= MC__UP;
+#ifdef RGB_IDLE_BLANK
+    timer_start(&idle_timer, TIMER_MS(RGB_IDLE_MS), 0, rgb_idle);
+#endif
 }
+//--End RGB Initialization----------------------------------------------
 
-void led_1da2c4(void)           // Blue
+//----------------------------------------------------------------------
+// Begin RGB Continue
+//----------------------------------------------------------------------
+// Start a cross-fade from the shown colour to `colour` over RGB_FADE_MS.
+// The per-step change is worked out once here; each step is then one add
+// per channel. Call with interrupts off.
+static void rgb_fade_to(const unsigned char *colour)
 {
-    TB3CCR1 = 29;              // CCR1=29  (Red)
-    TB3CCR2 = 162;             // CCR2=162 (Green)
-    TB3CCR3 = 196;             //CCR3=196  (Blue)
+    unsigned char i;
+
+    TB3CTL &= ~TBIE;                // Hold the fade while it is set up
+    for (i = 0; i < RGB_CHANNELS; i++) {
+        target[i] = colour[i];
+        step[i] = ((int)(target[i] << LEVEL_SHIFT) - level[i]) / (int)RGB_FADE_STEPS;
+    }
+    steps_left = RGB_FADE_STEPS;
+    periods_left = RGB_FADE_DIV;
+    TB3CTL &= ~TBIFG;
+    TB3CTL |= TBIE;
 }
 
-void rgb_led_init(void)
+#ifdef RGB_IDLE_BLANK
+// Runs in the timer interrupt RGB_IDLE_MS after the last colour
+static bool rgb_idle(void)
 {
-    WDTCTL = WDTPW | WDTHOLD;   // Stop watchdog timer
-    PM5CTL0 &= ~LOCKLPM5;       // Turn on GPIO
+    static const unsigned char dark[RGB_CHANNELS] = { 0, 0, 0 };
 
-    rgb_pins_init();
-    interrupts_init();
-    led_c43e1d();
+    rgb_fade_to(dark);
+    return false;
 }
+#endif
 
+// Cross-fade to the colour of `lockState` (0 unlocking, 1 unlocked,
+// anything else locked). With RGB_IDLE_BLANK, from dark if the LED had
+// gone idle, and show it for RGB_IDLE_MS.
 void rgb_led_continue(int lockState)
 {
-    switch (lockState) {
-        case 0:                 // Unlocking, set yellow
-            led_c4921d();
-            break;
-        case 1:                 // Unlocked, set blue
-            led_1da2c4();
-            break;
-        default:                 // Locked, set red
-            led_c43e1d();
-            break;
-    
-    }
+    const unsigned char *colour = colours[(lockState == 0 || lockState == 1) ? lockState : COLOUR_LOCKED];
+    unsigned int sr = __get_SR_register();
+
+    __disable_interrupt();
+    rgb_outputs_on(true);
+    rgb_fade_to(colour);
+    __bis_SR_register(sr & GIE);
+#ifdef RGB_IDLE_BLANK
+    timer_start(&idle_timer, TIMER_MS(RGB_IDLE_MS), 0, rgb_idle);
+#endif
 }
+//--End RGB Continue----------------------------------------------------
 
 //----------------------------------------------------------------------
-// Begin Interrupt Service Routine
+// Begin RGB Fading
 //----------------------------------------------------------------------
-#pragma vector = TIMER3_B0_VECTOR
-__interrupt void ISR_TB3_CCR0(void)
+bool rgb_led_fading(void)
+{
+    return steps_left != 0;
+}
+
+// True while any channel has a duty, i.e. the PWM needs SMCLK. None of
+// the lock-state colours is dark, so only an RGB_IDLE_BLANK build, once
+// its fade to dark ends and the outputs are held low, sees this go false.
+bool rgb_led_lit(void)
 {
-    P1OUT |= BIT5 | BIT6 | BIT7;
-    TB3CCTL0 &= ~CCIFG;
+    return rgb_led_fading() || (target[0] | target[1] | target[2]) != 0;
 }
+//--End RGB Fading------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Interrupt Service Routine
 //----------------------------------------------------------------------
-// CCR1, CCR2, CCR3, and overflow interrupt combined
+// TB3 overflow, only while fading: every RGB_FADE_DIV periods move each
+// channel one step; the last step lands exactly on the target.
 #pragma vector = TIMER3_B1_VECTOR
 __interrupt void ISR_TB3_CCRn(void)
 {
-    switch (__even_in_range(TB3IV, 14)) // Handle interrupts by priority
+    unsigned char i;
+
+    TRACE_ENTER(TRACE_TIMER3_B1);
+    switch (__even_in_range(TB3IV, TB3IV_TBIFG))
     {
-        case 0: break;                  // No interrupt
-        case 2:                         // CCR1 interrupt (RED)
-            P1OUT &= ~BIT5;             // RED off
-            TB3CCTL1 &= ~CCIFG;
-            break;
-        case 4:                         // CCR2 interrupt (GREEN)
-            P1OUT &= ~BIT6;             // GREEN off
-            TB3CCTL2 &= ~CCIFG;
-            break;
-        case 6:                         // CCR3 interrupt (BLUE)
-            P1OUT &= ~BIT7;             // BLUE off
-            TB3CCTL3 &= ~CCIFG;
-            break;
-        case 14:                        // Timer overflow
-            TB3CTL &= ~TBIFG;
+        case TB3IV_TBIFG:
+            if (--periods_left != 0) {
+                break;
+            }
+            periods_left = RGB_FADE_DIV;
+            if (--steps_left == 0) {
+                for (i = 0; i < RGB_CHANNELS; i++) {
+                    level[i] = target[i] << LEVEL_SHIFT;
+                }
+                TB3CTL &= ~TBIE;    // Fade done
+                if (!rgb_led_lit()) {
+                    rgb_outputs_on(false);
+                }
+            } else {
+                for (i = 0; i < RGB_CHANNELS; i++) {
+                    level[i] += step[i];
+                }
+            }
+            rgb_output();
             break;
         default: break;
     }
+    TRACE_EXIT(TRACE_TIMER3_B1);
 }
 //--End Interrupt Service Routine---------------------------------------
@@ -1,2 +1,21 @@
-void rgb_led_init();
+#include <stdbool.h>
+#include "clock.h"
+
+// Red P6.4 / TB3.5, green P1.6 / TB0.1, blue P1.7 / TB0.2, all in
+// reset/set mode from SMCLK, so the PWM runs without interrupts.
+#define RGB_PWM_PERIOD      1024    // 10-bit duty
+#define RGB_PWM_HZ          (CLOCK_SMCLK_HZ / RGB_PWM_PERIOD)  // 2.9 kHz at 3 MHz
+#define RGB_FADE_MS         400     // Cross-fade between lock states
+#define RGB_FADE_DIV        32      // PWM periods per fade step
+#define RGB_FADE_STEPS      (RGB_FADE_MS * RGB_PWM_HZ / (1000UL * RGB_FADE_DIV))
+
+// The PWM stops with SMCLK, so a lit LED keeps power_sleep() in LPM0 and
+// the lock state stays visible. Build with RGB_IDLE_BLANK defined to fade
+// each colour to dark after RGB_IDLE_MS, with the outputs driven low,
+// leaving LPM3 to main until the next colour.
+#define RGB_IDLE_MS         10000
+
+void rgb_led_init(void);
 void rgb_led_continue(int lockState);
+bool rgb_led_fading(void);
+bool rgb_led_lit(void);
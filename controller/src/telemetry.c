@@ -0,0 +1,197 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include "telemetry.h"
+#include "log.h"
+#include "i2c_frame.h"
+#include "clock.h"
+#include "ring.h"
+#include "trace.h"
+
+//----------------------------------------------------------------------
+// Transmit FIFO
+//----------------------------------------------------------------------
+// Main writes whole records, the UART interrupt sends them a byte at a
+// time. Single producer (main) / single consumer (ISR): main only
+// advances fifo_head, the ISR only fifo_tail (common/ring.h).
+RING_CHECK_SIZE(telemetry, TELEMETRY_FIFO_SIZE);
+static unsigned char fifo[TELEMETRY_FIFO_SIZE];
+static volatile unsigned char fifo_head, fifo_tail;
+static unsigned int sequence;
+
+// The bulk stream, if any. Between its frames (`stream_break`) the ISR
+// sends queued records before asking it for more.
+static telemetry_source_t volatile stream;
+static bool stream_break = true;
+
+// The log message being sent (log.h), taken from its ring when the FIFO
+// is empty
+static unsigned char log_frame[LOG_FRAME_SIZE];
+static unsigned char log_pos, log_size;
+static unsigned char record_pos;        // Bytes of the current record sent
+static bool log_turn;                   // A record went last: a message may go next
+
+volatile unsigned int telemetry_dropped;
+//--End Transmit FIFO---------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Telemetry Initialization
+//----------------------------------------------------------------------
+// Also takes the UART back after a trace dump, which shares it.
+void telemetry_init(void)
+{
+    unsigned int brw, mctlw;
+
+    clock_uart_divider(TELEMETRY_BAUD, &brw, &mctlw);
+    UCA1CTLW0 = UCSWRST | UCSSEL__SMCLK;
+    UCA1BRW = brw;
+    UCA1MCTLW = mctlw;
+    P4SEL0 |= BIT3;                     // UCA1TXD
+    UCA1CTLW0 &= ~UCSWRST;
+    if (fifo_head != fifo_tail || stream || log_pos < log_size || log_pending()) {
+        UCA1IE |= UCTXIE;               // Carry on with what was queued
+    }
+}
+//--End Telemetry Initialization----------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Telemetry Send
+//----------------------------------------------------------------------
+static void put16(unsigned char *record, unsigned int value)
+{
+    record[0] = value & 0xFF;
+    record[1] = value >> 8;
+}
+
+// Queue one record. Returns false, and counts the record as dropped,
+// when the FIFO cannot hold all of it; the caller never waits.
+bool telemetry_send(unsigned long time, unsigned int raw, unsigned int average_q4, int centi)
+{
+    unsigned char record[TELEMETRY_RECORD_SIZE];
+    unsigned char head = fifo_head;
+    unsigned char crc = 0;
+    unsigned char i;
+
+    record[0] = 'T';
+    record[1] = 'M';
+    put16(&record[2], sequence++);
+    put16(&record[4], (unsigned int)time);
+    put16(&record[6], (unsigned int)(time >> 16));
+    put16(&record[8], raw);
+    put16(&record[10], average_q4);
+    put16(&record[12], (unsigned int)centi);
+    for (i = 2; i < TELEMETRY_RECORD_SIZE - 1; i++) {
+        crc = crc8_update(crc, record[i]);
+    }
+    record[TELEMETRY_RECORD_SIZE - 1] = crc;
+
+    if (RING_FREE(head, fifo_tail, TELEMETRY_FIFO_SIZE) < TELEMETRY_RECORD_SIZE) {
+        telemetry_dropped++;
+        return false;
+    }
+    for (i = 0; i < TELEMETRY_RECORD_SIZE; i++) {
+        fifo[RING_SLOT(head + i, TELEMETRY_FIFO_SIZE)] = record[i];
+    }
+    fifo_head = head + TELEMETRY_RECORD_SIZE;  // Publish the record to the ISR
+    UCA1IE |= UCTXIE;                   // TXIFG is set while idle: starts at once
+    return true;
+}
+//--End Telemetry Send--------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Telemetry Stream
+//----------------------------------------------------------------------
+// Start sending from `source` as fast as the UART allows, after any
+// record already queued. Returns false if a stream is already running.
+bool telemetry_stream(telemetry_source_t source)
+{
+    if (stream) {
+        return false;
+    }
+    stream_break = true;
+    stream = source;
+    UCA1IE |= UCTXIE;
+    return true;
+}
+
+bool telemetry_streaming(void)
+{
+    return stream != 0;
+}
+//--End Telemetry Stream------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Telemetry Busy
+//----------------------------------------------------------------------
+// True while bytes are queued or on the wire, when SMCLK must keep
+// running for the UART.
+bool telemetry_busy(void)
+{
+    return fifo_head != fifo_tail || stream || log_pos < log_size || log_pending() || (UCA1STATW & UCBUSY);
+}
+//--End Telemetry Busy--------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Interrupt Service Routine
+//----------------------------------------------------------------------
+// A stream frame or log message, once begun, goes out whole; records are
+// whole in the FIFO, so they only meet at frame and record boundaries.
+// Records and log messages take turns, so neither starves the other, and
+// the stream has what they leave.
+static void telemetry_next_byte(void)
+{
+    int byte;
+
+    while (true) {
+        if (!stream_break) {
+            byte = stream();
+            if (byte >= 0) {
+                UCA1TXBUF = (unsigned char)byte;
+                return;
+            }
+            stream_break = true;
+            if (byte == TELEMETRY_SOURCE_END) {
+                stream = 0;
+            }
+        }
+        if (log_pos < log_size) {
+            UCA1TXBUF = log_frame[log_pos++];
+            return;
+        }
+        if (fifo_tail != fifo_head && (record_pos != 0 || !log_turn || !log_pending())) {
+            UCA1TXBUF = fifo[RING_SLOT(fifo_tail, TELEMETRY_FIFO_SIZE)];
+            fifo_tail++;
+            if (++record_pos == TELEMETRY_RECORD_SIZE) {
+                record_pos = 0;
+                log_turn = true;
+            }
+            return;
+        }
+        if ((log_size = log_take(log_frame)) != 0) {
+            log_pos = 0;
+            log_turn = false;
+            continue;
+        }
+        if (!stream) {
+            UCA1IE &= ~UCTXIE;          // Nothing left: idle until the next record
+            return;
+        }
+        stream_break = false;
+    }
+}
+
+#pragma vector = EUSCI_A1_VECTOR
+__interrupt void EUSCI_A1_UART_ISR(void)
+{
+    TRACE_ENTER(TRACE_UART_A1);
+    switch (__even_in_range(UCA1IV, USCI_UART_UCTXCPTIFG))
+    {
+        case USCI_UART_UCTXIFG:         // Ready for the next byte
+            telemetry_next_byte();
+            break;
+        default:
+            break;
+    }
+    TRACE_EXIT(TRACE_UART_A1);
+}
+//--End Interrupt Service Routine---------------------------------------
@@ -0,0 +1,36 @@
+#include <stdbool.h>
+
+// Temperature telemetry on UCA1 TXD (P4.3), 115200 8N1 from SMCLK, one
+// record per ADC sample, little-endian:
+//
+//   'T' 'M' seq(2) time(4) raw(2) average_q4(2) centi(2) crc8
+//
+// `time` is in ACLK ticks (32768 Hz), `raw` the ADC code of the sample,
+// `average_q4` the filter output in 1/16 LSB or TELEMETRY_NO_AVERAGE
+// while the window fills, and `centi` that output in hundredths of a
+// degC. crc8 (common/i2c_frame.h) covers seq to centi. `seq` counts every
+// record, sent or not, so the decoder (tools/telemetry_decode.c) sees the
+// gap a full FIFO leaves.
+#define TELEMETRY_BAUD          115200UL
+#define TELEMETRY_RECORD_SIZE   15
+#define TELEMETRY_FIFO_SIZE     64      // Bytes, power of two: 4 records
+#define TELEMETRY_NO_AVERAGE    0xFFFF
+
+// A bulk stream (e.g. the temperature log export) shares the UART with
+// the records: the source returns the next byte, TELEMETRY_SOURCE_BREAK
+// between its own frames, where queued records may go out first, and
+// TELEMETRY_SOURCE_END when done. It is called from the UART interrupt.
+//
+// Log messages (log.h) go out between records too.
+#define TELEMETRY_SOURCE_BREAK  -1
+#define TELEMETRY_SOURCE_END    -2
+
+typedef int (*telemetry_source_t)(void);
+
+void telemetry_init(void);
+bool telemetry_send(unsigned long time, unsigned int raw, unsigned int average_q4, int centi);
+bool telemetry_stream(telemetry_source_t source);
+bool telemetry_streaming(void);
+bool telemetry_busy(void);
+
+extern volatile unsigned int telemetry_dropped;     // Records lost to a full FIFO
@@ -0,0 +1,288 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include "temp_log.h"
+#include "telemetry.h"
+#include "i2c_frame.h"
+#include "lm19.h"
+
+#define TEMP_LOG_DATA   (TEMP_LOG_BLOCK_SIZE - 10)  // Bytes after the header
+#define VARINT_MAX      3                           // Bytes for a 17-bit zigzag
+
+typedef struct
+{
+    unsigned int sequence;          // Higher is newer, wraps at 16 bits
+    unsigned long time;             // Log clock at the first entry, s
+    int first;                      // First entry, centi-degC
+    unsigned char count;            // Entries, 0 = unused; written last
+    unsigned char flags;            // TEMP_LOG_RESTART
+    unsigned char data[TEMP_LOG_DATA];
+} temp_log_block_t;
+
+//----------------------------------------------------------------------
+// Log Blocks
+//----------------------------------------------------------------------
+// In program FRAM and left alone by the C startup; all zeros is empty.
+#pragma PERSISTENT(blocks)
+static temp_log_block_t blocks[TEMP_LOG_BLOCKS] = { { 0 } };
+
+static signed char newest = -1;     // Block being appended to, -1 if none
+static unsigned char used;          // Data bytes used in the newest block
+static int last;                    // Newest entry, centi-degC
+static bool restarted = true;       // The next entry starts a block
+static unsigned long clock_s = TEMP_LOG_ENTRY_S;    // Time of the next entry
+
+// Samples averaged toward the next entry
+static unsigned long sum;
+static unsigned char samples;
+
+// An entry waiting for the export to finish before it may reuse a block
+static bool pending;
+static int pending_value;
+static unsigned long pending_time;
+//--End Log Blocks------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Entry Encoding
+//----------------------------------------------------------------------
+// Store `delta` as a zigzag varint, low 7 bits first, top bit set on all
+// but the last byte. Returns the length.
+static unsigned char varint_encode(long delta, unsigned char *out)
+{
+    unsigned long value = (delta < 0) ? ((unsigned long)(-delta) << 1) - 1 : (unsigned long)delta << 1;
+    unsigned char length = 0;
+
+    while (value >= 0x80) {
+        out[length++] = (unsigned char)value | 0x80;
+        value >>= 7;
+    }
+    out[length++] = (unsigned char)value;
+    return length;
+}
+
+// Decode a block's entries to find the bytes they use and the last value
+static unsigned char temp_log_scan(const temp_log_block_t *block, unsigned char count, int *value)
+{
+    unsigned long zigzag;
+    unsigned char at = 0, shift, n;
+
+    *value = block->first;
+    for (n = 1; n < count && at < TEMP_LOG_DATA; n++) {
+        zigzag = 0;
+        shift = 0;
+        do {
+            zigzag |= (unsigned long)(block->data[at] & 0x7F) << shift;
+            shift += 7;
+        } while ((block->data[at++] & 0x80) && at < TEMP_LOG_DATA);
+        *value += (zigzag & 1) ? -(int)((zigzag + 1) >> 1) : (int)(zigzag >> 1);
+    }
+    return at;
+}
+//--End Entry Encoding--------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Log Initialization
+//----------------------------------------------------------------------
+// Find the newest block and carry the log clock on from it. The first
+// entry of this run starts a new block marked TEMP_LOG_RESTART.
+void temp_log_init(void)
+{
+    signed char i;
+
+    newest = -1;
+    for (i = 0; i < TEMP_LOG_BLOCKS; i++) {
+        if (blocks[i].count != 0 &&
+            (newest < 0 || (signed short)(blocks[i].sequence - blocks[newest].sequence) > 0)) {
+            newest = i;
+        }
+    }
+    if (newest >= 0) {
+        used = temp_log_scan(&blocks[newest], blocks[newest].count, &last);
+        clock_s = blocks[newest].time + (unsigned long)blocks[newest].count * TEMP_LOG_ENTRY_S;
+    }
+    restarted = true;
+    sum = 0;
+    samples = 0;
+    pending = false;
+}
+//--End Log Initialization----------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Log Append
+//----------------------------------------------------------------------
+// Write the pending entry: a few bytes and the count into the newest
+// block, or a header into the next one, with program FRAM unlocked only
+// for those writes. The count goes last, so a reset part way through
+// leaves the entry, or the whole block, unwritten rather than torn.
+static void temp_log_write(void)
+{
+    temp_log_block_t *block;
+    unsigned char bytes[VARINT_MAX];
+    unsigned char length = varint_encode((long)pending_value - last, bytes);
+    unsigned int protect = SYSCFG0 & (PFWP | DFWP);
+    unsigned char i;
+
+    if (newest >= 0 && !restarted && used + length <= TEMP_LOG_DATA) {
+        block = &blocks[newest];
+        SYSCFG0 = FRWPPW | (protect & ~PFWP);
+        for (i = 0; i < length; i++) {
+            block->data[used + i] = bytes[i];
+        }
+        block->count++;
+        SYSCFG0 = FRWPPW | protect;
+        used += length;
+    } else {
+        if (telemetry_streaming()) {
+            return;                     // The export may not have sent the next block yet
+        }
+        block = &blocks[(newest + 1) % TEMP_LOG_BLOCKS];
+        SYSCFG0 = FRWPPW | (protect & ~PFWP);
+        block->count = 0;               // Invalid until complete
+        block->sequence = (newest < 0) ? 0 : blocks[newest].sequence + 1;
+        block->time = pending_time;
+        block->first = pending_value;
+        block->flags = restarted ? TEMP_LOG_RESTART : 0;
+        block->count = 1;
+        SYSCFG0 = FRWPPW | protect;
+        newest = block - blocks;
+        used = 0;
+        restarted = false;
+    }
+    last = pending_value;
+    pending = false;
+}
+
+// Call with every ADC sample. Every TEMP_LOG_PERIOD samples the mean
+// becomes an entry: only a sum here, a table lookup and a few FRAM bytes
+// once a minute, all in main, so the sampling itself (started by TB1) is
+// untouched.
+void temp_log_add(unsigned int raw)
+{
+    if (pending) {
+        temp_log_write();
+    }
+    sum += raw;
+    if (++samples < TEMP_LOG_PERIOD) {
+        return;
+    }
+    // An entry still pending after a whole period is lost to this one
+    pending_value = lm19_centi_celsius((unsigned int)((sum * 16 + TEMP_LOG_PERIOD / 2) / TEMP_LOG_PERIOD));
+    pending_time = clock_s;
+    pending = true;
+    clock_s += TEMP_LOG_ENTRY_S;
+    sum = 0;
+    samples = 0;
+    temp_log_write();
+}
+//--End Log Append------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Log Export
+//----------------------------------------------------------------------
+// Frames are built in the UART interrupt, one block at a time, oldest
+// first; each block's data goes straight from FRAM.
+static unsigned char frame[13];
+static unsigned char frame_size;
+static const unsigned char *export_data;
+static unsigned char export_size;
+static unsigned char export_pos;
+static unsigned char export_crc;
+static unsigned char export_index;      // Next block to look at
+static unsigned char export_left;       // Blocks not yet looked at
+static bool export_ended;               // The 'T' 'E' frame has been built
+static unsigned long export_now;
+
+static unsigned char put16(unsigned char *out, unsigned int value)
+{
+    out[0] = value & 0xFF;
+    out[1] = value >> 8;
+    return 2;
+}
+
+static unsigned char put32(unsigned char *out, unsigned long value)
+{
+    put16(out, (unsigned int)value);
+    return 2 + put16(out + 2, (unsigned int)(value >> 16));
+}
+
+// Set up the next frame. Returns false when the export is complete.
+static bool temp_log_next_frame(void)
+{
+    const temp_log_block_t *block;
+    unsigned char count;
+    int value;
+
+    frame[0] = 'T';
+    while (export_left != 0) {
+        block = &blocks[export_index];
+        export_index = (export_index + 1) % TEMP_LOG_BLOCKS;
+        export_left--;
+        count = block->count;           // Main may append meanwhile: send these
+        if (count == 0) {
+            continue;
+        }
+        frame[1] = 'L';
+        frame_size = 2;
+        frame_size += put16(&frame[frame_size], block->sequence);
+        frame_size += put32(&frame[frame_size], block->time);
+        frame_size += put16(&frame[frame_size], (unsigned int)block->first);
+        frame[frame_size++] = count;
+        frame[frame_size++] = block->flags;
+        export_size = temp_log_scan(block, count, &value);
+        frame[frame_size++] = export_size;
+        export_data = block->data;
+        return true;
+    }
+    if (export_ended) {
+        return false;
+    }
+    frame[1] = 'E';
+    frame_size = 2 + put32(&frame[2], export_now);
+    export_size = 0;
+    export_ended = true;
+    return true;
+}
+
+// telemetry_source_t for the export
+static int temp_log_export_byte(void)
+{
+    unsigned char total, byte;
+
+    if (export_pos == 0) {
+        if (!temp_log_next_frame()) {
+            return TELEMETRY_SOURCE_END;
+        }
+        export_crc = 0;
+    }
+    total = frame_size + export_size;
+    if (export_pos > total) {
+        export_pos = 0;
+        return TELEMETRY_SOURCE_BREAK;  // Let queued records out between frames
+    }
+    if (export_pos == total) {
+        export_pos++;
+        return export_crc;
+    }
+    byte = (export_pos < frame_size) ? frame[export_pos] : export_data[export_pos - frame_size];
+    if (export_pos >= 2) {
+        export_crc = crc8_update(export_crc, byte);
+    }
+    export_pos++;
+    return byte;
+}
+
+// Stream the whole log, oldest block first, then the log clock, through
+// the telemetry UART. Returns false if an export is already running.
+bool temp_log_export(void)
+{
+    if (telemetry_streaming()) {
+        return false;
+    }
+    export_index = (newest < 0) ? 0 : (newest + 1) % TEMP_LOG_BLOCKS;
+    export_left = TEMP_LOG_BLOCKS;
+    export_pos = 0;
+    export_ended = false;
+    export_now = clock_s - (TEMP_LOG_PERIOD - samples) / 2;
+    return telemetry_stream(temp_log_export_byte);
+}
+//--End Log Export------------------------------------------------------
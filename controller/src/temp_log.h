@@ -0,0 +1,32 @@
+#include <stdbool.h>
+
+// Temperature log in program FRAM: one entry per TEMP_LOG_PERIOD samples,
+// the mean of those samples in hundredths of a degC, kept through resets
+// and power loss until temp_log_export() streams it out.
+//
+// The log is a ring of TEMP_LOG_BLOCKS blocks. A block holds the time and
+// value of its first entry, then each later entry as the zigzag varint
+// of its difference from the one before: one byte for a change of up to
+// 0.63 degC, so a block of TEMP_LOG_BLOCK_SIZE bytes holds up to 55
+// entries. Once the ring is full the oldest block is reused.
+//
+// Time is the log's own clock in seconds, which only runs while the
+// controller does: after a reset the log carries on from its newest
+// entry and marks the block TEMP_LOG_RESTART. The export ends with the
+// clock's current value, which ties the entries to wall time.
+//
+// Export frames, little-endian, crc8 (common/i2c_frame.h) over all but
+// the first two bytes, decoded by tools/telemetry_decode.c -l:
+//
+//   'T' 'L' seq(2) time(4) first(2) count(1) flags(1) length(1) data(length) crc8
+//   'T' 'E' now(4) crc8
+#define TEMP_LOG_BLOCK_SIZE     64
+#define TEMP_LOG_BLOCKS         64      // 4 KB, about 2.4 days of entries
+#define TEMP_LOG_PERIOD         120     // Samples per entry (1 minute)
+#define TEMP_LOG_ENTRY_S        60      // TEMP_LOG_PERIOD * 0.5 s
+
+#define TEMP_LOG_RESTART        0x01    // First block after a reset
+
+void temp_log_init(void);
+void temp_log_add(unsigned int raw);
+bool temp_log_export(void);
@@ -0,0 +1,307 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include "temperature.h"
+#include "power.h"
+#include "trace.h"
+
+// LM19 output on P1.4 / A4, converted against AVCC (3.3 V)
+#define LM19_SEL0   P1SEL0
+#define LM19_SEL1   P1SEL1
+#define LM19_PIN    BIT4
+#define LM19_INCH   ADCINCH_4
+
+#define DELTA_MAX   127                 // Largest step one history entry holds
+#define EMA_FRAC    12                  // Fraction bits of the EMA state
+
+//----------------------------------------------------------------------
+// Sample History
+//----------------------------------------------------------------------
+// The window is a ring of 8-bit steps, each sample minus the one before,
+// so 999 samples take 999 bytes. A step too big for a byte is clamped,
+// and the stored sample follows the input at DELTA_MAX codes (about
+// 9 degC) per sample instead. Only the samples at either end of the
+// window are kept whole: the ADC ISR adds the new one to a running sum
+// and takes out the oldest, then walks `oldest` one step forward, so a
+// sample costs the same at any window size. Main divides once per
+// reading, outside the ISR.
+static signed char deltas[TEMP_WINDOW_MAX];
+static unsigned int newest;             // Last stored sample
+static unsigned int oldest;             // First sample in the window
+static unsigned long sum;               // Sum of the samples in the window
+static unsigned int head;               // Next slot to write
+static unsigned int count;              // Samples in the window, <= window
+static unsigned int window = TEMP_WINDOW_DEFAULT;
+static unsigned char filter = TEMP_FILTER_BOXCAR;
+static unsigned long ema;               // EMA_FRAC fraction bits
+static unsigned char ema_shift;         // EMA weight is 1/2^ema_shift
+static volatile unsigned int last_sample;   // ADC code, before the history's slew limit
+static volatile bool new_sample;        // Set per sample, cleared by main
+//--End Sample History--------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Temperature Initialization
+//----------------------------------------------------------------------
+// TB1 runs in up mode from ACLK with TB1.1 in reset/set, so TB1.1B rises
+// once per TEMP_PERIOD and starts a conversion with no CPU involvement.
+void temperature_init(void)
+{
+    LM19_SEL0 |= LM19_PIN;              // Analog function on the LM19 pin
+    LM19_SEL1 |= LM19_PIN;
+
+    ADCCTL0 &= ~ADCENC;
+    ADCCTL0 = ADCSHT_2 | ADCON;         // 16 ADC clocks sample time, ADC on
+    ADCCTL1 = ADCSHS_1 | ADCSHP | ADCCONSEQ_2;  // TB1.1B trigger, pulse mode,
+                                                // repeat single channel
+    ADCCTL2 = ADCRES_2;                 // 12-bit result
+    ADCMCTL0 = LM19_INCH | ADCSREF_0;   // LM19 input, VR+ = AVCC
+    ADCIFG &= ~ADCIFG0;
+    ADCIE |= ADCIE0;
+    ADCCTL0 |= ADCENC;                  // Armed, waiting for the timer
+
+    TB1CTL |= TBCLR;                    // Clear timer and dividers
+    TB1CTL |= TBSSEL__ACLK;             // Source = ACLK
+    TB1CCR0 = TEMP_PERIOD - 1;          // 0.5 s period
+    TB1CCR1 = TEMP_PERIOD / 2;
+    TB1CCTL1 = OUTMOD_7;                // Reset/set: rising edge each period
+    TB1CTL |= MC__UP;                   // Mode = UP
+}
+//--End Temperature Initialization--------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Set Window
+//----------------------------------------------------------------------
+// Start a new `filter` over `size` samples. Old samples are dropped, so
+// nothing is shown until the new window has filled. The history is only
+// marked empty, not cleared, whatever the size.
+void temperature_set_window(unsigned int size, unsigned char kind)
+{
+    unsigned int sr = __get_SR_register();
+    unsigned char shift = 0;
+
+    if (size == 0 || size > TEMP_WINDOW_MAX || kind >= TEMP_FILTER_COUNT) {
+        return;
+    }
+    while ((2U << shift) <= size) {
+        shift++;
+    }
+    __disable_interrupt();
+    window = size;
+    filter = kind;
+    ema_shift = shift;
+    head = 0;
+    count = 0;
+    sum = 0;
+    __bis_SR_register(sr & GIE);
+}
+
+unsigned int temperature_window(void)
+{
+    return window;
+}
+
+unsigned char temperature_filter(void)
+{
+    return filter;
+}
+//--End Set Window------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Take Sample
+//----------------------------------------------------------------------
+// True once per conversion since the last call.
+bool temperature_take_sample(void)
+{
+    if (!new_sample) {
+        return false;
+    }
+    new_sample = false;
+    return true;
+}
+
+// ADC code of the latest conversion, as read
+unsigned int temperature_last_sample(void)
+{
+    return last_sample;
+}
+//--End Take Sample-----------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Average
+//----------------------------------------------------------------------
+// Median of the last min(count, TEMP_MEDIAN_MAX) samples, rebuilt from
+// the newest one back through the steps
+static unsigned int temperature_median(void)
+{
+    unsigned int sr = __get_SR_register();
+    unsigned int values[TEMP_MEDIAN_MAX];
+    unsigned int value, slot;
+    unsigned char n, i, j;
+
+    __disable_interrupt();
+    n = count < TEMP_MEDIAN_MAX ? count : TEMP_MEDIAN_MAX;
+    value = newest;
+    slot = head;
+    for (i = 0; i < n; i++) {
+        slot = (slot == 0 ? window : slot) - 1;
+        values[i] = value;
+        value -= deltas[slot];
+    }
+    __bis_SR_register(sr & GIE);
+
+    for (i = 1; i < n; i++) {           // Insertion sort, n is small
+        value = values[i];
+        for (j = i; j > 0 && values[j - 1] > value; j--) {
+            values[j] = values[j - 1];
+        }
+        values[j] = value;
+    }
+    if (n & 1) {
+        return values[n / 2] << 4;
+    }
+    return (values[n / 2 - 1] + values[n / 2]) << 3;
+}
+
+// Filter output as an ADC code in Q4 (1/16 LSB), since averaging gains
+// resolution. Returns false until the window holds `window` samples.
+bool temperature_average(unsigned int *code_q4)
+{
+    unsigned int sr = __get_SR_register();
+    unsigned long total, level;
+    unsigned int n;
+    bool full;
+
+    __disable_interrupt();              // sum and ema are 32-bit: copy them whole
+    total = sum;
+    level = ema;
+    n = window;
+    full = (count == window);
+    __bis_SR_register(sr & GIE);
+
+    if (!full) {
+        return false;
+    }
+    switch (filter) {
+        case TEMP_FILTER_EMA:
+            *code_q4 = (level + (1UL << (EMA_FRAC - 5))) >> (EMA_FRAC - 4);
+            break;
+        case TEMP_FILTER_MEDIAN:
+            *code_q4 = temperature_median();
+            break;
+        default:
+            *code_q4 = (total << 4) / n;
+            break;
+    }
+    return true;
+}
+//--End Average---------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin History
+//----------------------------------------------------------------------
+void temperature_get_history(temperature_history_t *history)
+{
+    history->window = window;
+    history->filter = filter;
+    history->full = temperature_average(&history->level_q4);
+    if (!history->full) {
+        history->level_q4 = 0;          // Keep saved records comparable
+    }
+}
+
+// Take up the saved filter, and with a full window, a history of
+// `level_q4` samples, so readings go out from the next sample on
+void temperature_set_history(const temperature_history_t *history)
+{
+    unsigned int sr, i, level;
+
+    temperature_set_window(history->window, history->filter);
+    if (!history->full || window != history->window) {
+        return;
+    }
+    level = (history->level_q4 + 8) >> 4;
+    sr = __get_SR_register();
+    __disable_interrupt();
+    for (i = 0; i < window; i++) {
+        deltas[i] = 0;
+    }
+    newest = oldest = level;
+    sum = (unsigned long)level * window;
+    ema = (unsigned long)history->level_q4 << (EMA_FRAC - 4);
+    count = window;
+    __bis_SR_register(sr & GIE);
+}
+//--End History---------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Interrupt Service Routine
+//----------------------------------------------------------------------
+// Move the EMA one sample along. The 32-bit shifts are library loops on
+// the MSP430, so this only runs while the EMA is the selected filter.
+static void temperature_ema(unsigned int sample)
+{
+    unsigned long input = (unsigned long)sample << EMA_FRAC;
+
+    if (count == 0) {
+        ema = input;
+    } else if (input >= ema) {
+        ema += (input - ema) >> ema_shift;
+    } else {
+        ema -= (ema - input) >> ema_shift;
+    }
+}
+
+// Store one sample as a step from the last and move the window along
+static void temperature_push(unsigned int sample)
+{
+    int delta = 0;
+
+    if (filter == TEMP_FILTER_EMA) {
+        temperature_ema(sample);
+    }
+    if (count == 0) {
+        newest = oldest = sample;
+    } else {
+        delta = (int)(sample - newest);
+        if (delta > DELTA_MAX) {
+            delta = DELTA_MAX;
+        } else if (delta < -DELTA_MAX) {
+            delta = -DELTA_MAX;
+        }
+        newest += delta;
+    }
+
+    if (count < window) {
+        count++;
+    } else {
+        sum -= oldest;                  // Oldest sample leaves the window
+        if (window == 1) {
+            oldest = newest;
+        } else {
+            oldest += deltas[head + 1 == window ? 0 : head + 1];
+        }
+    }
+    deltas[head] = delta;
+    sum += newest;
+    if (++head == window) {
+        head = 0;
+    }
+}
+
+#pragma vector = ADC_VECTOR
+__interrupt void ADC_ISR(void)
+{
+    TRACE_ENTER(TRACE_ADC);
+    switch (__even_in_range(ADCIV, ADCIV_ADCIFG))
+    {
+        case ADCIV_ADCIFG:              // Conversion done
+            last_sample = ADCMEM0;
+            temperature_push(last_sample);
+            new_sample = true;
+            POWER_WAKE_ON_EXIT();
+            break;
+        default: break;
+    }
+    TRACE_EXIT(TRACE_ADC);
+}
+//--End Interrupt Service Routine---------------------------------------
@@ -0,0 +1,33 @@
+#include <stdbool.h>
+
+#define TEMP_WINDOW_MAX      999    // Largest window, samples (three keypad digits)
+#define TEMP_WINDOW_DEFAULT  3
+#define TEMP_PERIOD          16384  // Sample period in ACLK counts (0.5 s)
+#define TEMP_MEDIAN_MAX      15     // Median of the last min(window, this) samples
+
+// Filters over the window, chosen with temperature_set_window()
+#define TEMP_FILTER_BOXCAR   0      // Mean of the last `window` samples
+#define TEMP_FILTER_EMA      1      // Exponential, weight 1/2^k, 2^k <= window
+#define TEMP_FILTER_MEDIAN   2      // Median of the last few samples
+#define TEMP_FILTER_COUNT    3
+
+// Filter settings and output, for keeping across a reset. The samples
+// themselves do not fit in a persisted record; a full window restarts
+// as if every sample in it had read `level_q4`.
+typedef struct
+{
+    unsigned int window;
+    unsigned char filter;
+    bool full;                      // level_q4 is from a full window
+    unsigned int level_q4;
+} temperature_history_t;
+
+void temperature_init(void);
+void temperature_set_window(unsigned int window, unsigned char filter);
+unsigned int temperature_window(void);
+unsigned char temperature_filter(void);
+bool temperature_take_sample(void);
+unsigned int temperature_last_sample(void);
+bool temperature_average(unsigned int *code_q4);
+void temperature_get_history(temperature_history_t *history);
+void temperature_set_history(const temperature_history_t *history);
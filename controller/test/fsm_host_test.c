@@ -0,0 +1,308 @@
+/**
+ * @file
+ * @brief Host test for the controller's lock state machine (fsm.c).
+ *
+ * Drives key, sample and persist events through fsm_handle() and records
+ * every fsm_output() call. Checks the code, window and pattern entry
+ * paths one by one, then runs random event sequences against a reference
+ * model written the way main.c used to be, as nested loops over an entry
+ * mode, and checks both give the same outputs in the same order and the
+ * same lock state after every event. Reports events handled per second.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon -Icontroller/src controller/test/fsm_host_test.c controller/src/fsm.c \
+ *       -o fsm_test && ./fsm_test
+ */
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include <time.h>
+#include "fsm.h"
+#include "temperature.h"
+#define HOST_TEST_SEED 2025
+#include "host_test.h"
+
+#define OUTPUTS_MAX     16              // Per event, far more than any uses
+#define SEQUENCES       20000
+#define SEQUENCE_LENGTH 64
+
+typedef struct
+{
+    fsm_output_t output;
+    char key;
+    unsigned int failed;
+    unsigned int window;
+    unsigned char filter;
+} output_t;
+
+static output_t outputs[OUTPUTS_MAX];   // From fsm_output() since the last clear
+static unsigned int output_count;
+static bool recording = true;
+
+// Normally in main.c, which acts on it
+void fsm_output(fsm_output_t output, const fsm_t *machine)
+{
+    output_t *out = &outputs[output_count % OUTPUTS_MAX];
+
+    if (!recording) {
+        return;
+    }
+    out->output = output;
+    out->key = machine->key;
+    out->failed = machine->failed;
+    out->window = machine->window;
+    out->filter = machine->filter;
+    output_count++;
+}
+
+static void key(char k)
+{
+    fsm_handle(fsm_key_event(k), k);
+}
+
+static void keys(const char *k)
+{
+    while (*k) {
+        key(*k++);
+    }
+}
+
+// The outputs since the last call are exactly `expect`, `count` of them
+static bool outputs_are(const fsm_output_t *expect, unsigned int count)
+{
+    unsigned int i, n = output_count;
+
+    output_count = 0;
+    if (n != count) {
+        return false;
+    }
+    for (i = 0; i < count; i++) {
+        if (outputs[i].output != expect[i]) {
+            return false;
+        }
+    }
+    return true;
+}
+
+//----------------------------------------------------------------------
+// Reference Model
+//----------------------------------------------------------------------
+// The lock logic as main.c had it before the state machine: count code
+// keys while locked, then act on keys by entry mode until 'D'.
+typedef struct
+{
+    bool unlocked;
+    char entered[FSM_CODE_LENGTH];
+    unsigned int count;
+    unsigned int failed;
+    char entry_mode;                    // 'A', 'B' or 'C'
+    unsigned int window, window_entry;
+    unsigned char filter, filter_entry;
+} model_t;
+
+static model_t model;
+static output_t expected[OUTPUTS_MAX];
+static unsigned int expected_count;
+
+static void model_output(fsm_output_t output, char k)
+{
+    output_t *out = &expected[expected_count++ % OUTPUTS_MAX];
+
+    out->output = output;
+    out->key = k;
+    out->failed = model.failed;
+    out->window = model.window;
+    out->filter = model.filter;
+}
+
+static void model_key(char k)
+{
+    if (!model.unlocked) {
+        model.entered[model.count++] = k;
+        model_output(FSM_OUT_CODE_KEY, k);
+        if (model.count == FSM_CODE_LENGTH) {
+            model.count = 0;
+            if (memcmp(model.entered, FSM_CODE, FSM_CODE_LENGTH) == 0) {
+                model.failed = 0;
+                model.unlocked = true;
+                model.entry_mode = 'A';
+                model_output(FSM_OUT_UNLOCK, k);
+            } else {
+                model.failed++;
+                model_output(FSM_OUT_WRONG_CODE, k);
+            }
+        }
+    } else if (k == 'D') {
+        model.unlocked = false;
+        model_output(FSM_OUT_LOCK, k);
+    } else if (k == 'A' || k == 'B' || k == 'C') {
+        model.entry_mode = k;
+        model.window_entry = 0;
+        model.filter_entry = model.filter;
+        model_output(FSM_OUT_ECHO_KEY, k);
+    } else if (model.entry_mode == 'B' && k >= '0' && k <= '9') {
+        if (model.window_entry * 10 + (k - '0') <= TEMP_WINDOW_MAX) {
+            model.window_entry = model.window_entry * 10 + (k - '0');
+            model_output(FSM_OUT_ECHO_KEY, k);
+        }
+    } else if (model.entry_mode == 'B' && k == '*') {
+        model.filter_entry = (model.filter_entry + 1) % TEMP_FILTER_COUNT;
+        model_output(FSM_OUT_ECHO_KEY, k);
+    } else if (model.entry_mode == 'B' && k == '#') {
+        model.window = model.window_entry != 0 ? model.window_entry : model.window;
+        model.filter = model.filter_entry;
+        model.entry_mode = 'A';
+        model_output(FSM_OUT_SET_WINDOW, k);
+    } else if (model.entry_mode == 'C' && k >= '0' && k <= '7') {
+        model.entry_mode = 'A';
+        model_output(FSM_OUT_SET_PATTERN, k);
+    } else if (k == '#') {
+        model_output(FSM_OUT_TOGGLE_UNIT, k);
+    } else if (k == '0') {
+        model_output(FSM_OUT_EXPORT_LOG, k);
+    } else if (k == '*') {
+        model_output(FSM_OUT_TRACE_DUMP, k);
+    }
+}
+//--End Reference Model-------------------------------------------------
+
+static const char all_keys[] = "0123456789ABCD*#";
+
+// Mostly the right next code key while locked, so sequences get past it
+static char random_key(void)
+{
+    if (!model.unlocked && rand_below(4) != 0) {
+        return FSM_CODE[model.count];
+    }
+    return all_keys[rand_below(16)];
+}
+
+static bool same_outputs(void)
+{
+    unsigned int i;
+
+    if (output_count != expected_count || output_count > OUTPUTS_MAX) {
+        return false;
+    }
+    for (i = 0; i < output_count; i++) {
+        if (outputs[i].output != expected[i].output || outputs[i].key != expected[i].key ||
+            outputs[i].failed != expected[i].failed || outputs[i].window != expected[i].window ||
+            outputs[i].filter != expected[i].filter) {
+            return false;
+        }
+    }
+    return true;
+}
+
+// Random sequences from a fresh start. Returns the events handled, or 0
+// on the first difference from the model.
+static unsigned long random_sequences(unsigned int sequences)
+{
+    unsigned long events = 0;
+    unsigned int s, i, r;
+    char k = 0;
+
+    for (s = 0; s < sequences; s++) {
+        fsm_init(TEMP_WINDOW_DEFAULT, TEMP_FILTER_BOXCAR);
+        memset(&model, 0, sizeof(model));
+        model.window = TEMP_WINDOW_DEFAULT;
+        model.filter = TEMP_FILTER_BOXCAR;
+        for (i = 0; i < SEQUENCE_LENGTH; i++) {
+            output_count = 0;
+            expected_count = 0;
+            r = rand_below(8);
+            if (r == 0) {
+                fsm_handle(FSM_SAMPLE, 0);
+                model_output(FSM_OUT_SAMPLE, 0);
+            } else if (r == 1) {
+                fsm_handle(FSM_PERSIST, 0);
+                model_output(FSM_OUT_PERSIST, 0);
+            } else {
+                k = random_key();
+                key(k);
+                model_key(k);
+            }
+            events++;
+            if (!same_outputs() || fsm_unlocked() != model.unlocked ||
+                (model.unlocked && (fsm.window != model.window || fsm.filter != model.filter))) {
+                printf("  sequence %u event %u (key %c): %u outputs, expected %u\n", s, i, k ? k : '-',
+                       output_count, expected_count);
+                return 0;
+            }
+        }
+    }
+    return events;
+}
+
+int main(void)
+{
+    static const fsm_output_t unlock[] = { FSM_OUT_CODE_KEY, FSM_OUT_CODE_KEY, FSM_OUT_CODE_KEY,
+                                           FSM_OUT_CODE_KEY, FSM_OUT_UNLOCK };
+    static const fsm_output_t wrong[] = { FSM_OUT_CODE_KEY, FSM_OUT_CODE_KEY, FSM_OUT_CODE_KEY,
+                                          FSM_OUT_CODE_KEY, FSM_OUT_WRONG_CODE };
+    static const fsm_output_t echo3[] = { FSM_OUT_ECHO_KEY, FSM_OUT_ECHO_KEY, FSM_OUT_ECHO_KEY,
+                                          FSM_OUT_ECHO_KEY };
+    static const fsm_output_t apply[] = { FSM_OUT_SET_WINDOW };
+    static const fsm_output_t pattern[] = { FSM_OUT_ECHO_KEY, FSM_OUT_SET_PATTERN };
+    static const fsm_output_t lock[] = { FSM_OUT_LOCK };
+    static const fsm_output_t sample[] = { FSM_OUT_SAMPLE };
+    unsigned long events;
+    clock_t start;
+    double seconds;
+    bool ok;
+
+    fsm_init(TEMP_WINDOW_DEFAULT, TEMP_FILTER_BOXCAR);
+    keys("3940");
+    ok = outputs_are(wrong, 5) && fsm.state == FSM_LOCKED && fsm.failed == 1;
+    keys("D9D4");
+    ok = ok && outputs_are(wrong, 5) && fsm.failed == 2;
+    report("a wrong code counts and stays locked", ok);
+
+    keys(FSM_CODE);
+    ok = outputs_are(unlock, 5) && fsm.state == FSM_UNLOCKED && fsm.failed == 0;
+    report("the code unlocks, 'D' included as a code key", ok);
+
+    keys("B1234");
+    ok = outputs_are(echo3, 4) && fsm.state == FSM_WINDOW_ENTRY && fsm.window_entry == 123;
+    key('#');
+    ok = ok && outputs_are(apply, 1) && outputs[0].window == 123 && fsm.state == FSM_UNLOCKED;
+    keys("B**");
+    output_count = 0;
+    key('#');
+    ok = ok && outputs[0].window == 123 && outputs[0].filter == 2 && fsm.state == FSM_UNLOCKED;
+    report("window digits stop at the maximum, '#' applies", ok);
+
+    output_count = 0;
+    keys("C895");
+    ok = outputs_are(pattern, 2) && outputs[1].key == '5' && fsm.state == FSM_UNLOCKED;
+    report("pattern entry takes 0-7 and ignores 8 and 9", ok);
+
+    keys("B12");
+    output_count = 0;
+    key('D');
+    ok = outputs_are(lock, 1) && fsm.state == FSM_LOCKED && !fsm_unlocked();
+    fsm_handle(FSM_SAMPLE, 0);
+    ok = ok && outputs_are(sample, 1) && fsm.state == FSM_LOCKED;
+    keys("39");
+    output_count = 0;
+    fsm_handle(FSM_SAMPLE, 0);
+    ok = ok && outputs_are(sample, 1) && fsm.state == FSM_UNLOCKING;
+    report("'D' locks mid-entry, samples leave the state alone", ok);
+
+    ok = random_sequences(SEQUENCES) == (unsigned long)SEQUENCES * SEQUENCE_LENGTH;
+    report("random sequences match the nested-loop model", ok);
+
+    // Throughput of the table alone, outputs not recorded
+    recording = false;
+    start = clock();
+    events = 0;
+    fsm_init(TEMP_WINDOW_DEFAULT, TEMP_FILTER_BOXCAR);
+    while (clock() - start < CLOCKS_PER_SEC / 4) {
+        keys("394DB12*#C5#0A*D1234");
+        events += 20;
+    }
+    seconds = (double)(clock() - start) / CLOCKS_PER_SEC;
+    printf("  %.0f events/s, %.0f 20-event sequences/s\n", events / seconds, events / seconds / 20);
+
+    return failures != 0;
+}
@@ -0,0 +1,184 @@
+/**
+ * @file
+ * @brief Host tests for the keypad debounce and event FIFO.
+ *
+ * Feeds synthetic 16-bit matrix snapshots to keypad_debounce(), one per
+ * scan tick, with contact bounce, overlapping presses and a slow consumer,
+ * and checks what comes out of keypad_get_event().
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon -Icontroller/src controller/test/keypad_host_test.c \
+ *       controller/src/keypad.c controller/src/power.c controller/src/master_i2c.c \
+ *       controller/src/rgb_led.c common/i2c_frame.c common/timer.c common/host/msp430_host.c \
+ *       -o keypad_test && ./keypad_test
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "keypad.h"
+#define HOST_TEST_SEED 12345
+#include "host_test.h"
+
+#define TICK_US     (KEYPAD_TICK * 1000000UL / 32768)
+#define MAX_BOUNCE  8                   // Ticks of chatter after contact
+
+extern const char keypad_keys[];
+
+// Normally in telemetry.c, for power_sleep()
+bool telemetry_busy(void)
+{
+    return false;
+}
+
+static void drain(void)
+{
+    keypad_event_t event;
+    while (keypad_get_event(&event)) {
+    }
+}
+
+// Clean press and release of one key: latency is exactly the debounce count
+static void test_clean_press(void)
+{
+    keypad_event_t event;
+    unsigned int tick;
+    int press_tick = -1, release_tick = -1;
+
+    for (tick = 0; tick < 40; tick++) {
+        keypad_debounce(tick < 20 ? 1u << 5 : 0);
+        while (keypad_get_event(&event)) {
+            if (event.key == '5' && event.pressed)
+                press_tick = tick;
+            if (event.key == '5' && !event.pressed)
+                release_tick = tick;
+        }
+    }
+    report("clean press/release reported after debounce",
+           press_tick == KEYPAD_DEBOUNCE - 1 && release_tick == 20 + KEYPAD_DEBOUNCE - 1);
+}
+
+// Random bounce on make and break: exactly one press and one release per
+// keystroke, and the worst-case key-to-event latency stays bounded
+static void test_bounce(void)
+{
+    keypad_event_t event;
+    unsigned int trial, tick, key, bounce, hold;
+    unsigned int presses = 0, releases = 0, worst = 0, wrong_keys = 0;
+
+    for (trial = 0; trial < 2000; trial++) {
+        key = rand_below(16);
+        bounce = 1 + rand_below(MAX_BOUNCE);
+        hold = 10 + rand_below(20);
+        int press_at = -1;
+        for (tick = 0; tick < bounce + hold + bounce + 2 * KEYPAD_DEBOUNCE; tick++) {
+            int down;
+            if (tick < bounce)
+                down = rand_below(2);                       // Make bounce
+            else if (tick < bounce + hold)
+                down = 1;
+            else if (tick < bounce + hold + bounce)
+                down = rand_below(2);                       // Break bounce
+            else
+                down = 0;
+            keypad_debounce(down ? 1u << key : 0);
+            while (keypad_get_event(&event)) {
+                wrong_keys += event.key != keypad_keys[key];
+                if (event.pressed) {
+                    presses++;
+                    if (press_at < 0)
+                        press_at = tick;
+                } else {
+                    releases++;
+                }
+            }
+        }
+        if (press_at >= 0 && (unsigned int)press_at + 1 > worst)
+            worst = press_at + 1;
+    }
+    report("bounced keystrokes give one press, one release",
+           presses == 2000 && releases == 2000 && wrong_keys == 0);
+    report("press latency <= bounce + debounce", worst <= MAX_BOUNCE + KEYPAD_DEBOUNCE);
+    printf("  worst-case key-to-event latency: %u ticks, %lu us\n", worst, worst * TICK_US);
+}
+
+// Bursts of overlapping presses with the consumer only draining every few
+// ticks: nothing lost, order kept per key
+static void test_burst(void)
+{
+    keypad_event_t event;
+    unsigned int tick, snapshot = 0;
+    unsigned int down_at[16] = { 0 };
+    unsigned long pressed = 0, released = 0, seen_press = 0, seen_release = 0;
+    int state[16] = { 0 };
+    int order_ok = 1;
+    unsigned int i;
+
+    keypad_dropped_events = 0;
+    for (tick = 0; tick < 20000; tick++) {
+        // Up to four keys down at once, each held at least the debounce time
+        for (i = 0; i < 16; i++) {
+            unsigned int bit = 1u << i;
+            if ((snapshot & bit) && tick - down_at[i] > KEYPAD_DEBOUNCE + rand_below(6)) {
+                snapshot &= ~bit;
+                released++;
+                down_at[i] = tick;
+            } else if (!(snapshot & bit) && tick - down_at[i] > KEYPAD_DEBOUNCE + 1 &&
+                       __builtin_popcount(snapshot) < 4 && rand_below(8) == 0) {
+                snapshot |= bit;
+                pressed++;
+                down_at[i] = tick;
+            }
+        }
+        keypad_debounce(snapshot);
+        if (tick % 8 == 0) {                   // Slow consumer
+            while (keypad_get_event(&event)) {
+                for (i = 0; keypad_keys[i] != event.key; i++) {
+                }
+                order_ok &= state[i] != event.pressed;
+                state[i] = event.pressed;
+                if (event.pressed)
+                    seen_press++;
+                else
+                    seen_release++;
+            }
+        }
+    }
+    for (tick = 0; tick < 2 * KEYPAD_DEBOUNCE; tick++)
+        keypad_debounce(tick < KEYPAD_DEBOUNCE ? snapshot : 0);  // Let the last presses land, then release
+    while (keypad_get_event(&event)) {
+        if (event.pressed)
+            seen_press++;
+        else
+            seen_release++;
+    }
+    released += __builtin_popcount(snapshot);
+    printf("  burst: %lu keystrokes, %lu press / %lu release events\n", pressed, seen_press, seen_release);
+    report("bursts with a slow consumer lose no events",
+           seen_press == pressed && seen_release == released && keypad_dropped_events == 0 && order_ok);
+}
+
+// A consumer that stops draining loses events, and says so
+static void test_overflow(void)
+{
+    unsigned int i, tick;
+
+    keypad_dropped_events = 0;
+    for (i = 0; i < 16; i++) {
+        for (tick = 0; tick < KEYPAD_DEBOUNCE; tick++)
+            keypad_debounce(1u << i);
+        for (tick = 0; tick < KEYPAD_DEBOUNCE; tick++)
+            keypad_debounce(0);
+    }
+    drain();
+    report("full FIFO counts dropped events", keypad_dropped_events == 32 - KEYPAD_FIFO_SIZE);
+}
+
+int main(void)
+{
+    keypad_init();
+    test_clean_press();
+    test_bounce();
+    test_burst();
+    test_overflow();
+    return failures != 0;
+}
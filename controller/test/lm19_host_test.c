@@ -0,0 +1,68 @@
+/**
+ * @file
+ * @brief Host test for the LM19 table conversion.
+ *
+ * Runs every Q4 ADC code through lm19_centi_celsius() and compares it,
+ * and the Fahrenheit and tenths conversions built on it, against the
+ * datasheet equation evaluated in double precision.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icontroller/src controller/test/lm19_host_test.c controller/src/lm19.c \
+ *       -lm -o lm19_test && ./lm19_test
+ */
+#include <math.h>
+#include <stdio.h>
+#include "lm19.h"
+#include "host_test.h"
+
+#define VREF_MV     3300.0
+#define ADC_CODES   4096
+#define MAX_ERROR_C 0.05                // Allowed table error, degC
+
+static double lm19_celsius(double mv)
+{
+    return -1481.96 + sqrt(2.1962e6 + (1.8639 - mv / 1000.0) / 3.88e-6);
+}
+
+int main(void)
+{
+    long code;
+    double worst_c = 0, worst_f = 0;
+    long worst_code = 0;
+    int tenths_ok = 1;
+    long centi;
+
+    for (code = 0; code <= 0xFFFF; code++) {
+        double ref = lm19_celsius(code / 16.0 * VREF_MV / ADC_CODES);
+        int c = lm19_centi_celsius((unsigned int)code);
+        int f = lm19_centi_fahrenheit(c);
+        double err_c = fabs(c / 100.0 - ref);
+        double err_f = fabs(f / 100.0 - (ref * 9.0 / 5.0 + 32.0));
+
+        if (err_c > worst_c) {
+            worst_c = err_c;
+            worst_code = code;
+        }
+        if (err_f > worst_f) {
+            worst_f = err_f;
+        }
+    }
+    printf("worst C error: %.4f degC at Q4 code %ld (ADC %.2f)\n", worst_c, worst_code, worst_code / 16.0);
+    printf("worst F error: %.4f degF\n", worst_f);
+    report("every ADC code within 0.05 degC of the datasheet", worst_c <= MAX_ERROR_C);
+    report("Fahrenheit within 9/5 of that", worst_f <= MAX_ERROR_C * 9.0 / 5.0 + 0.005);
+
+    for (centi = -32768; centi <= 32767; centi++) {
+        double exact = centi / 10.0;
+        long expect = (long)(exact < 0 ? -floor(-exact + 0.5) : floor(exact + 0.5));
+
+        if (lm19_tenths((int)centi) != expect) {
+            printf("  tenths(%ld) = %d, expected %ld\n", centi, lm19_tenths((int)centi), expect);
+            tenths_ok = 0;
+            break;
+        }
+    }
+    report("tenths rounding matches for every int", tenths_ok);
+
+    return failures != 0;
+}
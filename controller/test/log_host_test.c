@@ -0,0 +1,179 @@
+/**
+ * @file
+ * @brief Host test for the deferred log ring.
+ *
+ * Puts messages with log_put() and drains them through the UCA1 transmit
+ * ISR against a simulated UART, then parses the bytes as
+ * tools/log_decode.c and tools/telemetry_decode.c do. Checks each message
+ * arrives as one whole frame with a good CRC, its ID and argument, in
+ * order; that a full ring drops messages, counts them and leaves a
+ * sequence gap; that messages and telemetry records put at random never
+ * split each other; and that log_put() leaves GIE as it found it.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon -Icontroller/src controller/test/log_host_test.c controller/src/log.c \
+ *       controller/src/telemetry.c common/i2c_frame.c common/host/msp430_host.c -o log_test && ./log_test
+ */
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include <stdio.h>
+#include "log.h"
+#include "telemetry.h"
+#include "i2c_frame.h"
+#define HOST_TEST_SEED 23
+#include "host_test.h"
+
+void EUSCI_A1_UART_ISR(void);
+
+typedef struct
+{
+    unsigned char seq;
+    unsigned char id;
+    unsigned int arg;
+} message_t;
+
+static unsigned char wire[16384];       // Bytes the UART sent
+static unsigned int wire_length;
+static message_t got[1024];             // Messages parsed from the wire
+static unsigned int got_count, records;
+
+// Normally in clock.c, which needs the whole clock system
+void clock_uart_divider(unsigned long baud, unsigned int *brw, unsigned int *mctlw)
+{
+    (void)baud;
+    *brw = 1;
+    *mctlw = 0;
+}
+
+// Run the transmit interrupt `bytes` times, or until it goes idle
+static void step(unsigned int bytes)
+{
+    while (bytes-- != 0 && (UCA1IE & UCTXIE)) {
+        UCA1IV = USCI_UART_UCTXIFG;
+        UCA1TXBUF = 0xFFFF;
+        EUSCI_A1_UART_ISR();
+        if (UCA1TXBUF != 0xFFFF && wire_length < sizeof(wire)) {
+            wire[wire_length++] = (unsigned char)UCA1TXBUF;
+        }
+    }
+}
+
+static void drain(void)
+{
+    step(0xFFFF);
+}
+
+static bool crc_ok(const unsigned char *frame, unsigned int size)
+{
+    unsigned char crc = 0;
+    unsigned int i;
+
+    for (i = 2; i < size - 1; i++) {
+        crc = crc8_update(crc, frame[i]);
+    }
+    return crc == frame[size - 1];
+}
+
+// Split the wire into log frames and telemetry records. Returns false on
+// anything else, a bad CRC or a frame cut short.
+static bool parse(void)
+{
+    unsigned int at = 0;
+    const unsigned char *p;
+
+    got_count = 0;
+    records = 0;
+    while (at < wire_length) {
+        p = &wire[at];
+        if (at + LOG_FRAME_SIZE <= wire_length && p[0] == 'T' && p[1] == 'G' && crc_ok(p, LOG_FRAME_SIZE) &&
+            got_count < 1024) {
+            got[got_count].seq = p[2];
+            got[got_count].id = p[3];
+            got[got_count].arg = (unsigned int)(p[4] | p[5] << 8);
+            got_count++;
+            at += LOG_FRAME_SIZE;
+        } else if (at + TELEMETRY_RECORD_SIZE <= wire_length && p[0] == 'T' && p[1] == 'M' &&
+                   crc_ok(p, TELEMETRY_RECORD_SIZE)) {
+            records++;
+            at += TELEMETRY_RECORD_SIZE;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    unsigned int i, puts, sends;
+    bool ok;
+
+    telemetry_init();
+
+    log_put(LOG_CODE_INCORRECT, 3);
+    ok = telemetry_busy() && (UCA1IE & UCTXIE);
+    drain();
+    ok = ok && parse() && got_count == 1 && got[0].seq == 0 && got[0].id == LOG_CODE_INCORRECT &&
+         got[0].arg == 3 && !telemetry_busy() && !(UCA1IE & UCTXIE);
+    report("a message goes out whole and the interrupt stops", ok);
+
+    wire_length = 0;
+    for (i = 0; i < LOG_RING_SIZE; i++) {
+        log_put(LOG_START + i % LOG_IDS, 0xA500 + i);
+        UCA1IE &= ~UCTXIE;              // UART stalled
+    }
+    log_put(LOG_LOCKED, 1);
+    log_put(LOG_LOCKED, 2);
+    ok = log_dropped == 2;
+    drain();
+    log_put(LOG_CODE_CORRECT, 0);
+    drain();
+    ok = ok && parse() && got_count == LOG_RING_SIZE + 1 && log_dropped == 2;
+    for (i = 0; ok && i < LOG_RING_SIZE; i++) {
+        ok = got[i].seq == i + 1 && got[i].id == LOG_START + i % LOG_IDS && got[i].arg == 0xA500 + i;
+    }
+    ok = ok && got[LOG_RING_SIZE].id == LOG_CODE_CORRECT && got[LOG_RING_SIZE].seq == LOG_RING_SIZE + 3;
+    report("a full ring drops messages and leaves a gap", ok);
+
+    // Messages and records put at random while the UART runs a few bytes
+    // at a time: neither may land inside the other, and with the UART
+    // kept busy both still get out
+    wire_length = 0;
+    log_dropped = 0;
+    telemetry_dropped = 0;
+    puts = 0;
+    sends = 0;
+    for (i = 0; i < 2000; i++) {
+        switch (rand_below(5)) {
+            case 0:
+                log_put(LOG_CODE_INCORRECT, puts++);
+                break;
+            case 1:
+                sends += telemetry_send(i, i, 0, 0);
+                break;
+            default:
+                step(rand_below(12));
+                break;
+        }
+    }
+    drain();
+    ok = parse() && records == sends && got_count == puts - log_dropped && records > 200 &&
+         got_count > 200;
+    for (i = 1; ok && i < got_count; i++) {
+        ok = got[i].arg > got[i - 1].arg && (unsigned char)(got[i].seq - got[i - 1].seq) ==
+             (unsigned char)(got[i].arg - got[i - 1].arg);
+    }
+    report("messages and records never split each other", ok);
+
+    // As from an ISR (GIE off) and from main (GIE on)
+    host_sr = 0;
+    log_put(LOG_START, 0);
+    ok = !(host_sr & GIE);
+    host_sr = GIE;
+    log_put(LOG_START, 0);
+    ok = ok && (host_sr & GIE);
+    report("log_put leaves GIE as it found it", ok);
+
+    return failures != 0;
+}
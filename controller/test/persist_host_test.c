@@ -0,0 +1,74 @@
+/**
+ * @file
+ * @brief Host test for the FRAM state record (common/persist.c).
+ *
+ * Saves and loads a state struct through the two record slots and checks
+ * the round trip, that an unchanged state is not written again, that a
+ * record of another size or version is ignored, and that the newest
+ * record still wins once the sequence number has wrapped. FRAM writes are
+ * counted from SYSCFG0: the test leaves it without the password bits, and
+ * every write leaves them set.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon controller/test/persist_host_test.c common/persist.c \
+ *       common/i2c_frame.c common/host/msp430_host.c -o persist_test && ./persist_test
+ */
+#include <msp430.h>
+#include <stdio.h>
+#include <string.h>
+#include "persist.h"
+#include "host_test.h"
+
+#define VERSION     3
+
+typedef struct
+{
+    unsigned short samples[9];          // 16-bit, as on the MSP430
+    unsigned char window;
+    char unit;
+} state_t;
+
+// Save and say whether FRAM was written
+static int save(const state_t *state)
+{
+    SYSCFG0 = PFWP | DFWP;
+    persist_save(state, sizeof(*state), VERSION);
+    return SYSCFG0 != (PFWP | DFWP);
+}
+
+int main(void)
+{
+    state_t state, loaded;
+    unsigned long i;
+    int ok;
+
+    memset(&loaded, 0x5A, sizeof(loaded));
+    report("nothing to load before the first save",
+           !persist_load(&loaded, sizeof(loaded), VERSION) && loaded.window == 0x5A);
+
+    memset(&state, 0, sizeof(state));
+    state.window = 5;
+    state.unit = 'F';
+    state.samples[0] = 1234;
+    state.samples[4] = 4321;
+    report("first save writes", save(&state));
+    report("round trip", persist_load(&loaded, sizeof(loaded), VERSION) &&
+           memcmp(&loaded, &state, sizeof(state)) == 0);
+    report("unchanged state is not written again", !save(&state));
+    report("write protection restored after a save",
+           (save(&(state_t){ .window = 6 }), SYSCFG0 == (FRWPPW | PFWP | DFWP)));
+    report("other version ignored", !persist_load(&loaded, sizeof(loaded), VERSION + 1));
+    report("other size ignored", !persist_load(&loaded, sizeof(loaded) - 2, VERSION));
+
+    // 70000 saves wrap the 16-bit sequence number; the last one must load
+    ok = 1;
+    for (i = 0; i < 70000UL && ok; i++) {
+        state.samples[i % 9] = (unsigned short)i;
+        state.window = 1 + i % 9;
+        ok = save(&state) && persist_load(&loaded, sizeof(loaded), VERSION) &&
+             memcmp(&loaded, &state, sizeof(state)) == 0;
+    }
+    report("newest record loads across a sequence wrap", ok);
+
+    return failures != 0;
+}
@@ -0,0 +1,156 @@
+/**
+ * @file
+ * @brief Host test for the hardware-PWM RGB driver and its fades.
+ *
+ * Fires the TB3 overflow ISR the way the timer would while a fade runs
+ * and checks that each channel moves monotonically to the exact target
+ * colour, in RGB_FADE_STEPS duty updates over RGB_FADE_MS, and that the
+ * interrupt is off again when the fade is done. Runs the software timer
+ * past RGB_IDLE_MS and checks the lock-state colour stays lit. Built with
+ * -DRGB_IDLE_BLANK, checks instead that the LED fades to dark with its
+ * outputs held low, so power_sleep() can use LPM3, and lights again on
+ * the next colour.
+ *
+ * Build and run from the repository root:
+ *   gcc -D__MSP430FR2355__ -Icommon/host -Icommon -Icontroller/src controller/test/rgb_led_host_test.c \
+ *       controller/src/rgb_led.c common/timer.c common/host/msp430_host.c -o rgb_led_test && ./rgb_led_test
+ */
+#include <msp430.h>
+#include <stdio.h>
+#include "intrinsics.h"
+#include "rgb_led.h"
+#include "gamma_table.h"
+#include "timer.h"
+#include "host_test.h"
+
+void ISR_TB3_CCRn(void);
+void ISR_TIMER_WHEEL(void);
+
+// Advance `n` ACLK ticks on the timer service, as timer_host_test.c does
+static void run(unsigned long n)
+{
+    static unsigned int ticks;
+
+    while (n-- != 0) {
+        TB2R = ++ticks;
+        if ((TB2CCTL0 & CCIE) && (TB2R == TB2CCR0 || (TB2CCTL0 & CCIFG))) {
+            ISR_TIMER_WHEEL();
+        }
+    }
+}
+
+static unsigned int duty(int channel)
+{
+    return channel == 0 ? TB3CCR5 : channel == 1 ? TB0CCR1 : TB0CCR2;
+}
+
+// Run one fade to `state`; returns PWM periods until the ISR turned off
+static unsigned long fade(int state, const unsigned char *colour, int *monotonic, int *updates)
+{
+    unsigned int last[3];
+    int dir[3] = { 0, 0, 0 };
+    unsigned long periods = 0;
+    int c;
+
+    for (c = 0; c < 3; c++) {
+        last[c] = duty(c);
+    }
+    *monotonic = 1;
+    *updates = 0;
+    rgb_led_continue(state);
+    while (TB3CTL & TBIE && periods < 100000) {
+        int changed = 0;
+
+        TB3IV = TB3IV_TBIFG;
+        ISR_TB3_CCRn();
+        periods++;
+        for (c = 0; c < 3; c++) {
+            int d = (duty(c) > last[c]) - (duty(c) < last[c]);
+
+            if (d != 0) {
+                changed = 1;
+                if (dir[c] != 0 && d != dir[c]) {
+                    *monotonic = 0;
+                }
+                dir[c] = d;
+            }
+            last[c] = duty(c);
+        }
+        *updates += changed;
+    }
+    for (c = 0; c < 3; c++) {
+        if (duty(c) != gamma_table[colour[c]]) {
+            *monotonic = 0;
+        }
+    }
+    return periods;
+}
+
+int main(void)
+{
+    static const unsigned char red[3] = { 0xC4, 0x3E, 0x1D };
+    static const unsigned char yellow[3] = { 0xC4, 0x92, 0x1D };
+    static const unsigned char blue[3] = { 0x1D, 0xA2, 0xC4 };
+    unsigned long periods;
+    int ok, updates;
+
+    timer_init();
+    rgb_led_init();
+    report("starts red, no interrupt",
+           TB3CCR5 == gamma_table[red[0]] && TB0CCR1 == gamma_table[red[1]] &&
+           TB0CCR2 == gamma_table[red[2]] && !(TB3CTL & TBIE));
+    report("PWM outputs in reset/set, glitch-free reload",
+           TB3CCTL5 == (OUTMOD_7 | CLLD_1) && TB0CCTL1 == (OUTMOD_7 | CLLD_1) &&
+           TB0CCTL2 == (OUTMOD_7 | CLLD_1) && TB3CCR0 == RGB_PWM_PERIOD - 1);
+    printf("  PWM %lu Hz, 10-bit; fade %lu steps\n", (unsigned long)RGB_PWM_HZ, (unsigned long)RGB_FADE_STEPS);
+    report("PWM above 1 kHz", RGB_PWM_HZ > 1000);
+
+    periods = fade(0, yellow, &ok, &updates);
+    report("red -> yellow lands on yellow, monotonic", ok);
+    report("fade takes RGB_FADE_STEPS steps", periods == (unsigned long)RGB_FADE_STEPS * RGB_FADE_DIV);
+    printf("  %lu periods = %lu ms, %d duty updates\n", periods, periods * 1000 / RGB_PWM_HZ, updates);
+    report("fade time within 10% of RGB_FADE_MS",
+           periods * 1000 / RGB_PWM_HZ * 10 >= RGB_FADE_MS * 9 &&
+           periods * 1000 / RGB_PWM_HZ * 10 <= RGB_FADE_MS * 11);
+    report("interrupt off after the fade", !(TB3CTL & TBIE) && !rgb_led_fading());
+
+    fade(1, blue, &ok, &updates);
+    report("yellow -> blue lands on blue, monotonic", ok);
+    fade(3, red, &ok, &updates);
+    report("blue -> red (any other state) lands on red", ok);
+
+    rgb_led_continue(1);
+    TB3IV = TB3IV_TBIFG;
+    for (periods = 0; periods < RGB_FADE_STEPS * RGB_FADE_DIV / 2; periods++) {
+        ISR_TB3_CCRn();
+    }
+    fade(0, yellow, &ok, &updates);
+    report("retarget mid-fade lands on the new colour", ok);
+    report("lit LED keeps SMCLK (LPM0)", rgb_led_lit());
+
+#ifndef RGB_IDLE_BLANK
+    run(2 * TIMER_MS(RGB_IDLE_MS));
+    report("stays lit past RGB_IDLE_MS", rgb_led_lit() && !rgb_led_fading() &&
+           TB3CCR5 == gamma_table[yellow[0]] && TB3CCTL5 == (OUTMOD_7 | CLLD_1));
+#else
+    run(TIMER_MS(RGB_IDLE_MS) - 1);
+    ok = !rgb_led_fading();
+    run(1);
+    ok = ok && rgb_led_fading();
+    report("fades out RGB_IDLE_MS after the last colour", ok);
+    while (TB3CTL & TBIE) {
+        TB3IV = TB3IV_TBIFG;
+        ISR_TB3_CCRn();
+    }
+    report("dark LED leaves LPM3 to main, outputs held low",
+           !rgb_led_lit() && TB3CCTL5 == OUTMOD_0 && TB0CCTL1 == OUTMOD_0 && TB0CCTL2 == OUTMOD_0);
+
+    run(TIMER_MS(RGB_IDLE_MS) / 2);
+    fade(3, red, &ok, &updates);
+    report("next colour lights it from dark", ok && rgb_led_lit() && TB3CCTL5 == (OUTMOD_7 | CLLD_1));
+    run(TIMER_MS(RGB_IDLE_MS) - 1);
+    report("and restarts the idle time", !rgb_led_fading());
+#endif
+
+    return failures != 0;
+}
@@ -0,0 +1,264 @@
+/**
+ * @file
+ * @brief Host test for the FRAM temperature log and its export.
+ *
+ * Feeds samples through temp_log_add(), exports the log through the
+ * telemetry UART interrupt against a simulated UART and decodes the
+ * frames as tools/telemetry_decode.c -l does. Checks every entry comes
+ * back exactly, with its time, through a ring wrap and a reset, that
+ * telemetry records sent during an export arrive whole between its
+ * frames, that an entry needing a new block during an export waits for
+ * it to end, and reports how many entries the log packs per KB.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon -Icontroller/src controller/test/temp_log_host_test.c controller/src/temp_log.c \
+ *       controller/src/telemetry.c controller/src/log.c controller/src/lm19.c common/i2c_frame.c \
+ *       common/host/msp430_host.c -o temp_log_test && ./temp_log_test
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "temp_log.h"
+#include "telemetry.h"
+#include "i2c_frame.h"
+#include "lm19.h"
+#define HOST_TEST_SEED 465
+#include "host_test.h"
+
+#define MAX_ENTRIES (TEMP_LOG_BLOCKS * TEMP_LOG_BLOCK_SIZE)
+
+void EUSCI_A1_UART_ISR(void);
+
+typedef struct
+{
+    unsigned long time;
+    int centi;
+    bool restart;
+} entry_t;
+
+static unsigned char wire[16384];       // Bytes the UART sent
+static unsigned int wire_length;
+
+static entry_t expect[MAX_ENTRIES * 2]; // Every entry added, oldest first
+static unsigned int expect_count;
+static entry_t got[MAX_ENTRIES];        // Entries decoded from an export
+static unsigned int got_count, records;
+static unsigned long now;               // From the 'T' 'E' frame
+static unsigned long clock_s = TEMP_LOG_ENTRY_S;
+static bool next_restart = true;
+
+// Normally in clock.c, which needs the whole clock system
+void clock_uart_divider(unsigned long baud, unsigned int *brw, unsigned int *mctlw)
+{
+    (void)baud;
+    *brw = 1;
+    *mctlw = 0;
+}
+
+// Run the transmit interrupt `bytes` times, or until it goes idle
+static void step(unsigned int bytes)
+{
+    while (bytes-- != 0 && (UCA1IE & UCTXIE)) {
+        UCA1IV = USCI_UART_UCTXIFG;
+        UCA1TXBUF = 0xFFFF;
+        EUSCI_A1_UART_ISR();
+        if (UCA1TXBUF != 0xFFFF && wire_length < sizeof(wire)) {
+            wire[wire_length++] = (unsigned char)UCA1TXBUF;
+        }
+    }
+}
+
+static void drain(void)
+{
+    step(0xFFFF);
+}
+
+// One entry's worth of samples around `code`, noting what it should log
+static void add_entry(unsigned int code, unsigned int spread)
+{
+    unsigned long sum = 0;
+    unsigned int i, raw;
+
+    for (i = 0; i < TEMP_LOG_PERIOD; i++) {
+        raw = code + rand_below(2 * spread + 1) - spread;
+        sum += raw;
+        temp_log_add(raw);
+    }
+    expect[expect_count].centi = lm19_centi_celsius((unsigned int)((sum * 16 + TEMP_LOG_PERIOD / 2) / TEMP_LOG_PERIOD));
+    expect[expect_count].time = clock_s;
+    expect[expect_count].restart = next_restart;
+    expect_count++;
+    clock_s += TEMP_LOG_ENTRY_S;
+    next_restart = false;
+}
+
+static unsigned int get16(const unsigned char *p)
+{
+    return (unsigned int)(p[0] | p[1] << 8);
+}
+
+static unsigned long get32(const unsigned char *p)
+{
+    return get16(p) | (unsigned long)get16(p + 2) << 16;
+}
+
+static bool crc_ok(const unsigned char *frame, unsigned int size)
+{
+    unsigned char crc = 0;
+    unsigned int i;
+
+    for (i = 2; i < size - 1; i++) {
+        crc = crc8_update(crc, frame[i]);
+    }
+    return crc == frame[size - 1];
+}
+
+// Decode the wire. Returns false on any framing or CRC error.
+static bool decode(void)
+{
+    unsigned long zigzag;
+    unsigned int at = 0, n, count, length, data, shift;
+    const unsigned char *p;
+    int value;
+
+    got_count = 0;
+    records = 0;
+    while (at < wire_length) {
+        p = &wire[at];
+        if (p[0] != 'T') {
+            return false;
+        }
+        if (p[1] == 'M') {
+            if (!crc_ok(p, TELEMETRY_RECORD_SIZE)) {
+                return false;
+            }
+            records++;
+            at += TELEMETRY_RECORD_SIZE;
+        } else if (p[1] == 'E') {
+            if (!crc_ok(p, 7)) {
+                return false;
+            }
+            now = get32(&p[2]);
+            at += 7;
+        } else if (p[1] == 'L') {
+            length = p[12];
+            if (!crc_ok(p, 14 + length)) {
+                return false;
+            }
+            value = (short)get16(&p[8]);
+            count = p[10];
+            data = 13;
+            for (n = 0; n < count; n++) {
+                if (n > 0) {
+                    zigzag = 0;
+                    shift = 0;
+                    do {
+                        zigzag |= (unsigned long)(p[data] & 0x7F) << shift;
+                        shift += 7;
+                    } while (p[data++] & 0x80);
+                    value += (zigzag & 1) ? -(int)((zigzag + 1) >> 1) : (int)(zigzag >> 1);
+                }
+                got[got_count].time = get32(&p[4]) + n * TEMP_LOG_ENTRY_S;
+                got[got_count].centi = value;
+                got[got_count].restart = n == 0 && (p[11] & TEMP_LOG_RESTART);
+                got_count++;
+            }
+            if (data != 13 + length) {
+                return false;
+            }
+            at += 14 + length;
+        } else {
+            return false;
+        }
+    }
+    return true;
+}
+
+static bool export_log(void)
+{
+    wire_length = 0;
+    return temp_log_export() && (drain(), decode());
+}
+
+// The export holds the newest `got_count` entries added, in order
+static bool matches(void)
+{
+    unsigned int i, first = expect_count - got_count;
+
+    if (got_count > expect_count) {
+        return false;
+    }
+    for (i = 0; i < got_count; i++) {
+        if (got[i].time != expect[first + i].time || got[i].centi != expect[first + i].centi ||
+            got[i].restart != expect[first + i].restart) {
+            printf("  entry %u: %lu s %d restart %d, expected %lu s %d restart %d\n", i, got[i].time,
+                   got[i].centi, got[i].restart, expect[first + i].time, expect[first + i].centi,
+                   expect[first + i].restart);
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    unsigned int code = 2000, i;
+    bool ok;
+
+    telemetry_init();
+    temp_log_init();
+
+    ok = export_log() && got_count == 0 && now == 0;
+    report("an empty log exports just its clock", ok);
+
+    for (i = 0; i < 500; i++) {
+        code += rand_below(9) - 4;
+        add_entry(code, 3);
+    }
+    ok = export_log() && got_count == 500 && matches() && now == clock_s - TEMP_LOG_ENTRY_S;
+    report("entries come back exactly with their times", ok);
+    printf("  %u entries in %u blocks: %.0f entries per KB\n", got_count, (got_count + 54) / 55,
+           got_count * 1024.0 / wire_length);
+
+    for (i = 0; i < 200; i++) {
+        add_entry(rand_below(2) ? 1000 + rand_below(3000) : code, 0);
+    }
+    ok = export_log() && got_count == 700 && matches();
+    report("large steps take wider deltas and match", ok);
+
+    for (i = 0; i < 4000; i++) {
+        code += rand_below(9) - 4;
+        add_entry(code, 3);
+    }
+    ok = export_log() && got_count > 3000 && got_count < expect_count && matches();
+    report("a full ring keeps the newest entries", ok);
+
+    // Reset: RAM state is lost, the FRAM blocks are not
+    temp_log_init();
+    next_restart = true;
+    for (i = 0; i < 10; i++) {
+        add_entry(code, 3);
+    }
+    ok = export_log() && matches() && got[got_count - 10].restart && !got[got_count - 9].restart &&
+         got[got_count - 10].time == got[got_count - 11].time + TEMP_LOG_ENTRY_S;
+    report("after a reset the log goes on, marked restart", ok);
+
+    // Records sent mid-export, and an entry that needs a new block (the
+    // first after a reset) while the export may still have to send it
+    temp_log_init();
+    next_restart = true;
+    wire_length = 0;
+    ok = temp_log_export();
+    for (i = 0; i < 20; i++) {
+        telemetry_send(i, code, 0, 0);
+        step(100);
+    }
+    add_entry(code, 0);
+    drain();
+    ok = ok && decode() && records == 20 && got[got_count - 1].time == expect[expect_count - 2].time;
+    temp_log_add(code);                 // The next sample writes it
+    ok = ok && export_log() && matches() && got[got_count - 1].restart;
+    report("records interleave and entries wait for an export", ok);
+
+    return failures != 0;
+}
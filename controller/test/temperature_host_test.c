@@ -0,0 +1,184 @@
+/**
+ * @file
+ * @brief Host test for the temperature filters and their delta history.
+ *
+ * Feeds random-walk ADC samples through the ADC ISR at random window
+ * sizes up to TEMP_WINDOW_MAX and compares every reading with reference
+ * filters that keep whole samples: the boxcar mean exactly, the median
+ * exactly, and the EMA within 1/16 LSB of a double-precision one. Steps
+ * too big for the 8-bit history must follow the input at the slew limit
+ * and still match. Also checks that a saved history restarts full.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon -Icontroller/src controller/test/temperature_host_test.c \
+ *       controller/src/temperature.c common/host/msp430_host.c -o temperature_test && ./temperature_test
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include "intrinsics.h"
+#include "temperature.h"
+#define HOST_TEST_SEED 465
+#include "host_test.h"
+
+#define SLEW        127                 // Largest step the history keeps
+
+void ADC_ISR(void);
+volatile bool power_wake_pending;       // Normally in power.c
+
+static unsigned int history[TEMP_WINDOW_MAX];   // Reference, whole samples
+static unsigned int stored;             // Samples in the reference window
+static unsigned int last;               // Last sample as the history holds it
+static double ema;
+static unsigned int ema_weight;
+
+static int compare(const void *a, const void *b)
+{
+    return (int)*(const unsigned int *)a - (int)*(const unsigned int *)b;
+}
+
+static void start(unsigned int window, unsigned char filter)
+{
+    temperature_set_window(window, filter);
+    stored = 0;
+    for (ema_weight = 1; ema_weight * 2 <= window; ema_weight *= 2) {
+    }
+}
+
+// One conversion through the ISR and the reference
+static void sample(unsigned int code)
+{
+    unsigned int window = temperature_window();
+    unsigned int i;
+
+    if (stored == 0) {
+        last = code;
+        ema = code;
+    } else {
+        if (code > last + SLEW) {
+            last += SLEW;
+        } else if (code + SLEW < last) {
+            last -= SLEW;
+        } else {
+            last = code;
+        }
+        ema += (code - ema) / ema_weight;
+    }
+    if (stored == window) {
+        for (i = 1; i < window; i++) {
+            history[i - 1] = history[i];
+        }
+        stored--;
+    }
+    history[stored++] = last;
+
+    ADCMEM0 = code;
+    ADCIV = ADCIV_ADCIFG;
+    ADC_ISR();
+}
+
+// The reading the reference expects, or -1 while the window fills
+static long expected(void)
+{
+    unsigned int sorted[TEMP_MEDIAN_MAX];
+    unsigned long total = 0;
+    unsigned int i, n;
+
+    if (stored < temperature_window()) {
+        return -1;
+    }
+    switch (temperature_filter()) {
+        case TEMP_FILTER_MEDIAN:
+            n = stored < TEMP_MEDIAN_MAX ? stored : TEMP_MEDIAN_MAX;
+            for (i = 0; i < n; i++) {
+                sorted[i] = history[stored - n + i];
+            }
+            qsort(sorted, n, sizeof(sorted[0]), compare);
+            return (n & 1) ? sorted[n / 2] * 16L : (sorted[n / 2 - 1] + sorted[n / 2]) * 8L;
+        case TEMP_FILTER_EMA:
+            return (long)(ema * 16 + 0.5);
+        default:
+            for (i = 0; i < stored; i++) {
+                total += history[i];
+            }
+            return (long)((total << 4) / stored);
+    }
+}
+
+static bool matches(void)
+{
+    unsigned int code_q4;
+    bool full = temperature_average(&code_q4);
+    long expect = expected();
+
+    if (!full || expect < 0) {
+        return full == (expect >= 0);
+    }
+    if (temperature_filter() == TEMP_FILTER_EMA) {
+        return labs((long)code_q4 - expect) <= 1;
+    }
+    return code_q4 == expect;
+}
+
+// `runs` random windows and filters, a random walk of `samples` each
+static bool run(unsigned int runs, unsigned int jump, unsigned int samples)
+{
+    unsigned int code = 2048;
+    unsigned int r, i;
+
+    for (r = 0; r < runs; r++) {
+        start(rand_below(4) == 0 ? 1 + rand_below(TEMP_WINDOW_MAX) : 1 + rand_below(40),
+              rand_below(TEMP_FILTER_COUNT));
+        for (i = 0; i < samples; i++) {
+            code += rand_below(2 * jump + 1) - jump;
+            code &= 0x0FFF;
+            sample(code);
+            if (!matches()) {
+                printf("  run %u sample %u: window %u filter %u\n", r, i, temperature_window(),
+                       temperature_filter());
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    temperature_history_t saved;
+    unsigned int code_q4, i;
+    bool ok;
+
+    temperature_init();
+
+    report("slow walk, every filter and window matches", run(300, 6, 1500));
+    report("steps past the 8-bit history slew and match", run(300, 400, 1500));
+
+    start(TEMP_WINDOW_MAX, TEMP_FILTER_BOXCAR);
+    for (i = 0; i < TEMP_WINDOW_MAX; i++) {
+        sample(1000 + i % 7);
+    }
+    ok = matches();
+    temperature_get_history(&saved);
+    start(5, TEMP_FILTER_MEDIAN);
+    ok = ok && !temperature_average(&code_q4);
+    temperature_set_history(&saved);
+    ok = ok && temperature_window() == TEMP_WINDOW_MAX && temperature_filter() == TEMP_FILTER_BOXCAR &&
+         temperature_average(&code_q4) && (code_q4 + 8) >> 4 == (saved.level_q4 + 8) >> 4;
+    report("saved history restarts with a full window", ok);
+
+    // Called with interrupts off, e.g. from an ISR, they stay off
+    host_sr = 0;
+    temperature_set_history(&saved);
+    temperature_average(&code_q4);
+    start(5, TEMP_FILTER_MEDIAN);
+    for (i = 0; i < 5; i++) {
+        sample(1000 + i);
+    }
+    temperature_average(&code_q4);
+    report("critical sections leave GIE off if it was off", !(host_sr & GIE));
+    host_sr = GIE;
+
+    return failures != 0;
+}
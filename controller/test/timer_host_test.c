@@ -0,0 +1,269 @@
+/**
+ * @file
+ * @brief Host test for the software timer wheel (common/timer.c).
+ *
+ * Counts TB2R up one ACLK tick at a time and calls the compare ISR
+ * whenever TB2R reaches TB2CCR0 or CCIFG is set, like the hardware would.
+ * Checks that one-shot and periodic timers fire on exactly their expiry
+ * tick, across 16-bit wraps and wheel turns, under random start/stop
+ * from main and from callbacks, and counts the interrupts against the
+ * number of distinct deadlines. Also checks that no interrupt calls one
+ * timer twice: not a periodic timer that fell behind, nor one that
+ * restarts itself with no delay.
+ *
+ * Build and run from the repository root:
+ *   gcc -D__MSP430FR2355__ -Icommon/host -Icommon controller/test/timer_host_test.c \
+ *       common/timer.c common/host/msp430_host.c -o timer_test && ./timer_test
+ */
+#include <msp430.h>
+#include <stdio.h>
+#include "intrinsics.h"
+#include "timer.h"
+#define HOST_TEST_SEED 465
+#include "host_test.h"
+
+#define TIMERS      12
+
+void ISR_TIMER_WHEEL(void);
+
+static unsigned long ticks;             // Simulated time since timer_init()
+static unsigned long interrupts;
+static unsigned long pass_calls, max_pass;  // Calls in one interrupt
+
+// Advance `n` ticks, taking the compare interrupt when it is due
+static void run(unsigned long n)
+{
+    while (n-- != 0) {
+        ticks++;
+        TB2R = (unsigned int)ticks;
+        if ((TB2CCTL0 & CCIE) && (TB2R == TB2CCR0 || (TB2CCTL0 & CCIFG))) {
+            interrupts++;
+            pass_calls = 0;
+            ISR_TIMER_WHEEL();
+            if (pass_calls > max_pass) {
+                max_pass = pass_calls;
+            }
+        }
+    }
+}
+
+// Advance `n` ticks with the interrupt held off, as by a long critical
+// section; a compare match still sets CCIFG
+static void stall(unsigned long n)
+{
+    while (n-- != 0) {
+        ticks++;
+        TB2R = (unsigned int)ticks;
+        if (TB2R == TB2CCR0) {
+            TB2CCTL0 |= CCIFG;
+        }
+    }
+}
+
+//----------------------------------------------------------------------
+// Reference: each timer's expected next call, checked by its callback
+//----------------------------------------------------------------------
+static soft_timer_t timers[TIMERS];
+static unsigned long expect[TIMERS];    // Tick of the next call
+static unsigned long period[TIMERS];
+static int armed[TIMERS];
+static unsigned long calls, late, early;
+
+static void fired(int i)
+{
+    if (!armed[i] || ticks > expect[i]) {
+        late++;
+    } else if (ticks < expect[i]) {
+        early++;
+    }
+    calls++;
+    if (period[i] != 0) {
+        expect[i] += period[i];
+    } else {
+        armed[i] = 0;
+    }
+}
+
+static void start(int i, unsigned long delay, unsigned long every);
+
+#define CALLBACK(i) static bool fired_##i(void) { fired(i); return false; }
+CALLBACK(0) CALLBACK(1) CALLBACK(2) CALLBACK(3) CALLBACK(4) CALLBACK(5)
+CALLBACK(6) CALLBACK(7) CALLBACK(8) CALLBACK(9)
+
+// Timer 10 restarts itself with a new period, like the keypad scan
+static bool fired_10(void)
+{
+    fired(10);
+    start(10, 64 + rand_below(2000), 64 + rand_below(2000));
+    return false;
+}
+
+// Timer 11 stops a random other timer, then restarts one
+static bool fired_11(void)
+{
+    int victim = (int)rand_below(10);
+
+    fired(11);
+    timer_stop(&timers[victim]);
+    armed[victim] = 0;
+    victim = (int)rand_below(10);
+    start(victim, 1 + rand_below(70000), rand_below(3) == 0 ? 0 : 1 + rand_below(40000));
+    return false;
+}
+
+static timer_callback_t const callbacks[TIMERS] = {
+    fired_0, fired_1, fired_2, fired_3, fired_4, fired_5,
+    fired_6, fired_7, fired_8, fired_9, fired_10, fired_11
+};
+
+static void start(int i, unsigned long delay, unsigned long every)
+{
+    timer_start(&timers[i], delay, every, callbacks[i]);
+    expect[i] = ticks + (delay != 0 ? delay : 1);
+    period[i] = every;
+    armed[i] = 1;
+}
+
+static void stop_all(void)
+{
+    int i;
+
+    for (i = 0; i < TIMERS; i++) {
+        timer_stop(&timers[i]);
+        armed[i] = 0;
+    }
+}
+//--End Reference-------------------------------------------------------
+
+// A 1 s periodic timer over a minute: no drift, and besides its own
+// compare only the one horizon wake-up per second
+static void test_periodic(void)
+{
+    unsigned long before = interrupts;
+
+    calls = late = early = 0;
+    start(0, TIMER_HZ, TIMER_HZ);
+    run(60 * TIMER_HZ);
+    stop_all();
+    report("1 s periodic: 60 calls on the exact tick", calls == 60 && late == 0 && early == 0);
+    report("1 s periodic: one compare per call, plus horizon", interrupts - before <= 60 * 2);
+}
+
+// One-shots past the 16-bit counter wrap and several wheel turns away,
+// all landing in the same bucket
+static void test_far_one_shots(void)
+{
+    calls = late = early = 0;
+    start(0, 100, 0);
+    start(1, 100 + (TIMER_SLOTS << TIMER_SLOT_SHIFT), 0);
+    start(2, 100 + 3 * (TIMER_SLOTS << TIMER_SLOT_SHIFT), 0);
+    start(3, 5 * TIMER_HZ, 0);
+    start(4, 1, 0);
+    run(6 * TIMER_HZ);
+    report("one-shots across wraps and wheel turns", calls == 5 && late == 0 && early == 0);
+    stop_all();
+}
+
+// Random load: a mix of periods, restarts from callbacks and from main
+static void test_random(void)
+{
+    unsigned long step, deadlines, before = interrupts;
+    int i;
+
+    calls = late = early = 0;
+    for (i = 0; i < 10; i++) {
+        start(i, 1 + rand_below(40000), rand_below(2) ? 1 + rand_below(30000) : 0);
+    }
+    start(10, 64, 64);
+    start(11, 3000, 3000);
+    for (step = 0; step < 4000; step++) {
+        run(rand_below(600));
+        if (rand_below(4) == 0) {
+            i = (int)rand_below(10);
+            start(i, 1 + rand_below(70000), rand_below(2) ? 1 + rand_below(30000) : 0);
+        }
+        if (rand_below(16) == 0) {
+            i = (int)rand_below(10);
+            timer_stop(&timers[i]);
+            armed[i] = 0;
+        }
+    }
+    deadlines = calls;
+    stop_all();
+    report("random start/stop: every call on its exact tick", late == 0 && early == 0);
+    report("random start/stop: interrupts <= calls + horizon",
+           interrupts - before <= deadlines + ticks / TIMER_HORIZON + 1);
+    printf("  %lu calls from %lu interrupts in %lu s\n", deadlines, interrupts - before, ticks / TIMER_HZ);
+}
+
+// Keypad idle scan, heartbeat and LED-bar-like pattern step together,
+// against the 1 ms tick a fixed-rate scheduler would need for them
+static void test_load(void)
+{
+    unsigned long before = interrupts, seconds = 30;
+
+    calls = late = early = 0;
+    start(0, 1024, 1024);               // Keypad idle check, ~31 ms
+    start(1, TIMER_HZ, TIMER_HZ);       // Heartbeat
+    start(2, TIMER_HZ / 2, TIMER_HZ / 2);   // Pattern step
+    run(seconds * TIMER_HZ);
+    stop_all();
+    report("typical load: all calls on time", late == 0 && early == 0);
+    printf("  %lu interrupts in %lu s, vs %lu with a 1 ms tick\n", interrupts - before, seconds, seconds * 1000);
+}
+
+static unsigned long last_call, gaps;
+
+static bool behind(void)
+{
+    pass_calls++;
+    calls++;
+    return false;
+}
+
+// Restarts itself with no delay, 50 times: one call on each tick
+static bool again(void)
+{
+    pass_calls++;
+    gaps += calls != 0 && ticks != last_call + 1;
+    last_call = ticks;
+    if (++calls < 50) {
+        timer_start(&timers[0], 0, 0, again);
+    }
+    return false;
+}
+
+// A 100-tick periodic timer held off for five periods is called once
+// when the interrupt is taken, then keeps its period from there
+static void test_behind(void)
+{
+    calls = max_pass = 0;
+    timer_start(&timers[0], 100, 100, behind);
+    stall(550);
+    run(1);
+    report("behind periodic: one call on the late interrupt", calls == 1 && max_pass == 1);
+    run(1000);
+    stop_all();
+    report("behind periodic: then one call per period", calls == 1 + 10 && max_pass == 1);
+}
+
+static void test_restart_now(void)
+{
+    calls = gaps = max_pass = 0;
+    timer_start(&timers[0], 0, 0, again);
+    run(100);
+    stop_all();
+    report("delay 0 from its own callback: next tick, not now", calls == 50 && gaps == 0 && max_pass == 1);
+}
+
+int main(void)
+{
+    timer_init();
+    test_periodic();
+    test_far_one_shots();
+    test_random();
+    test_load();
+    test_behind();
+    test_restart_now();
+    return failures != 0;
+}
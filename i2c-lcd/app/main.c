@@ -1,219 +1,398 @@
 #include "intrinsics.h"
 #include <msp430.h>
 #include <stdbool.h>
+#include "i2c_frame.h"
+#include "lcd.h"
+#include "event.h"
+#include "trace.h"
+#include "clock.h"
+#include "persist.h"
+#include "i2c_slave.h"
+#include "gpio.h"
 
 
-// Puerto 2
-#define RS BIT0     // P2.0
-#define EN BIT6     // P2.6
-
-// Puerto 1
-#define D4  BIT4     // P1.4
-#define D5 BIT5     // P1.5
-#define D6 BIT6     // P1.6
-#define D7 BIT7     // P1.7
 #define SLAVE_ADDR  0x48                    // Slave I2C Address
+#define STATE_VERSION 2                     // Bump when lcd_state_t changes
 
-volatile unsigned char receivedData = 0;    // Recieved data
-char key_unlocked;
 char mode = '\0';
-char new_window_size = '\0';
+unsigned int window_entry;                  // Digits typed after 'B', 0 = none
+unsigned char filter_entry;                 // Filter chosen after 'B'
 char pattern_cur = '\0';
 
-void I2C_Slave_Init(void)
+// What is on screen, kept in FRAM so a reset can redraw it
+typedef struct
+{
+    unsigned int window;                    // Shown as "N=<n>"
+    unsigned char filter;                   // Letter in place of the N
+    char pattern;                           // pattern_cur
+    char unit;                              // 'C' or 'F'
+    bool unlocked;                          // Screen in use, not cleared
+} lcd_state_t;
+
+lcd_state_t state = { 3, 0, '\0', 'C', false };
+
+// Window letter per filter, indexed by the controller's TEMP_FILTER_*:
+// boxcar mean, exponential, median
+const char filter_letters[] = "NEM";
+#define FILTER_COUNT (sizeof(filter_letters) - 1)
+
+// Line 1 text is 14 cells wide: the sparkline takes the last two
+const char *pattern_names[] = {
+    "STATIC        ",
+    "TOGGLE        ",
+    "UP COUNTER    ",
+    "IN AND OUT    ",
+    "DOWN COUNTER  ",
+    "ROTATE 1 LEFT ",
+    "ROTATE 7 RIGHT",
+    "COMET         "
+};
+#define PATTERN_COUNT (sizeof(pattern_names) / sizeof(pattern_names[0]))
+
+//----------------------------------------------------------------------
+// Begin Glyphs
+//----------------------------------------------------------------------
+// Custom characters, kept in CGRAM by the driver's glyph cache
+enum
 {
-    WDTCTL = WDTPW | WDTHOLD;  // Stop Watchdog Timer
+    GLYPH_UP,
+    GLYPH_DOWN,
+    GLYPH_LOCK,
+    GLYPH_SPARK                             // One per sparkline cell
+};
 
-    // Configure P1.2 as SDA and P1.3 as SCL
-    P1SEL1 &= ~(BIT2 | BIT3);
-    P1SEL0 |= BIT2 | BIT3;
+#define ARROW_STEADY    0x7E                // Built-in right arrow
+#define LOCK_POSITION   0x00
+#define SPARK_POSITION  0x0E                // End of line 1
+#define SPARK_CELLS     2
+#define SPARK_COLUMNS   (SPARK_CELLS * 5)   // One sample per pixel column
+#define SPARK_STEP      2                   // Tenths of a degree per pixel row
 
-    // Configure USCI_B0 as I2C Slave
-    UCB0CTLW0 |= UCSWRST;               // Put eUSCI_B0 into software reset
-    UCB0CTLW0 |= UCMODE_3;              // Select I2C slave mode
-    UCB0I2COA0 = SLAVE_ADDR + UCOAEN;   // Set and enable first own address
-    UCB0CTLW0 |= UCTXACK;               // Send ACKs
+static const unsigned char glyph_up[LCD_GLYPH_ROWS] = { 0x04, 0x0E, 0x15, 0x04, 0x04, 0x04, 0x04, 0x00 };
+static const unsigned char glyph_down[LCD_GLYPH_ROWS] = { 0x04, 0x04, 0x04, 0x04, 0x15, 0x0E, 0x04, 0x00 };
+static const unsigned char glyph_lock[LCD_GLYPH_ROWS] = { 0x0E, 0x11, 0x11, 0x1F, 0x1B, 0x1B, 0x1F, 0x00 };
 
-    PM5CTL0 &= ~LOCKLPM5;               // Disable low-power inhibit mode
+// Recent averages, drawn as a sweep: each sample replaces the oldest
+// column, so only the cell holding it needs its glyph uploaded again
+static unsigned char spark[SPARK_CELLS][LCD_GLYPH_ROWS];
+static int spark_tenths[SPARK_COLUMNS];
+static unsigned char spark_count;           // Samples so far, up to SPARK_COLUMNS
+static unsigned char spark_next;            // Column the next sample goes in
+static int spark_base;                      // Tenths shown on the middle row
+static int last_tenths;
 
-    UCB0CTLW0 &= ~UCSWRST;              // Pull eUSCI_B0 out of software reset
-    UCB0IE |= UCSTTIE + UCRXIE;         // Enable Start and RX interrupts
+// Pixel row for `tenths`, or -1 or LCD_GLYPH_ROWS when off the scale
+static int spark_row(int tenths)
+{
+    int row = LCD_GLYPH_ROWS / 2 - (tenths - spark_base) / SPARK_STEP;
 
-    __enable_interrupt();               // Enable Maskable IRQs
+    if (row < 0)
+        return -1;
+    if (row >= LCD_GLYPH_ROWS)
+        return LCD_GLYPH_ROWS;
+    return row;
 }
 
-void pulseEnable() {
-    P2OUT |= EN;             // Establecer Enable en 1
-    __delay_cycles(1000);    // Retardo
-    P2OUT &= ~EN;            // Establecer Enable en 0
-    __delay_cycles(1000);    // Retardo
+// Draw one column: its sample's pixel, clamped to the top or bottom row
+static void spark_plot(unsigned char column)
+{
+    unsigned char *cell = spark[column / 5];
+    unsigned char bit = 0x10 >> (column % 5);
+    unsigned char i;
+    int row = spark_row(spark_tenths[column]);
+
+    for (i = 0; i < LCD_GLYPH_ROWS; i++)
+        cell[i] &= ~bit;
+    if (column >= spark_count)
+        return;                             // No sample yet
+    if (row < 0)
+        row = 0;
+    else if (row == LCD_GLYPH_ROWS)
+        row = LCD_GLYPH_ROWS - 1;
+    cell[row] |= bit;
 }
 
-void sendNibble(unsigned char nibble) {
-    P1OUT &= ~(D4 | D5 | D6 | D7);  // Limpiar los bits de datos
-    P1OUT |= ((nibble & 0x0F) << 4);  // Cargar el nibble en los bits correspondientes (P1.4 a P1.7)
-    pulseEnable();  // Pulsar Enable para enviar datos
+// Add one average. A sample off the scale re-centres it and redraws
+// every column; otherwise only the newest column's cell changes.
+void spark_add(int tenths)
+{
+    unsigned char column;
+    int row;
+
+    spark_tenths[spark_next] = tenths;
+    if (spark_count < SPARK_COLUMNS)
+        spark_count++;
+    row = spark_row(tenths);
+    if (spark_count == 1 || row < 0 || row == LCD_GLYPH_ROWS)
+    {
+        spark_base = tenths;
+        for (column = 0; column < SPARK_COLUMNS; column++)
+            spark_plot(column);
+        for (column = 0; column < SPARK_CELLS; column++)
+            lcd_glyph_changed(GLYPH_SPARK + column);
+    }
+    else
+    {
+        spark_plot(spark_next);
+        lcd_glyph_changed(GLYPH_SPARK + spark_next / 5);
+    }
+    spark_next = (spark_next + 1) % SPARK_COLUMNS;
 }
 
-void send_data(unsigned char data) {
-    P2OUT |= RS;    // Modo datos
-    sendNibble(data >> 4);  // Enviar los 4 bits más significativos
-    sendNibble(data & 0x0F);  // Enviar los 4 bits menos significativos (corregido)
-    __delay_cycles(4000); // Retardo para procesar los datos
+void show_spark(void)
+{
+    unsigned char i;
+
+    for (i = 0; i < SPARK_CELLS; i++)
+        lcd_put_glyph(SPARK_POSITION + i, GLYPH_SPARK + i, spark[i]);
 }
+//--End Glyphs----------------------------------------------------------
 
-void send_command(unsigned char cmd) {
-    P2OUT &= ~RS;   // Modo comando
-    sendNibble(cmd >> 4);  // Enviar los 4 bits más significativos
-    sendNibble(cmd);  // Enviar los 4 bits menos significativos
-    __delay_cycles(4000); // Retardo para asegurarse de que el comando se procese
+void show_pattern(char pattern)
+{
+    lcd_print(pattern_names[pattern - '0'], 0x00);
+    pattern_cur = pattern;
 }
 
-void lcdInit() {
-    // Configurar pines como salida
-    P1DIR |= D4 | D5 | D6 | D7;
-    P2DIR |= RS | EN;
-
-    // Limpiar salidas
-    P1OUT &= ~(D4 | D5 | D6 | D7);
-    P2OUT &= ~(RS | EN);
-    __delay_cycles(50000);  // Retardo de inicio
-    sendNibble(0x03);  // Inicialización del LCD
-    __delay_cycles(5000);  // Retardo
-    sendNibble(0x03);  // Repetir la inicialización
-    __delay_cycles(200);  // Retardo
-    sendNibble(0x03);  // Repetir la inicialización
-    sendNibble(0x02);  // Establecer modo de 4 bits
-
-    send_command(0x28);  // Configurar LCD: 4 bits, 2 líneas, 5x8
-    send_command(0x0C);  // Encender display, apagar cursor
-    send_command(0x06);  // Modo de escritura automática
-    send_command(0x01);  // Limpiar la pantalla
-    __delay_cycles(2000); // Esperar para limpiar la pantalla
+// Window size, right-aligned against the end of line 2 as "N=<n>", with
+// the filter's letter in place of the N
+void show_window(unsigned int window, unsigned char filter)
+{
+    char text[8];
+    unsigned char i = sizeof(text) - 1;
+
+    text[i] = '\0';
+    do
+    {
+        text[--i] = '0' + window % 10;
+        window /= 10;
+    } while (window != 0 && i > 2);
+    text[--i] = '=';
+    text[--i] = filter_letters[filter < FILTER_COUNT ? filter : 0];
+    while (i > 2)
+        text[--i] = ' ';                    // Clear what a longer window left
+    lcd_print(&text[i], 0x50 - (sizeof(text) - 1 - i));
 }
 
-void lcdSetCursor(unsigned char position) {
-    send_command(0x80 | position);  // Establecer la dirección del cursor en la DDRAM
+// Averaged temperature in tenths of a degree, as "T=xx.x" + degree + unit,
+// then an arrow for the trend since the last reading
+void show_temperature(int tenths, char unit)
+{
+    char text[12];
+    unsigned char i = 0;
+    unsigned int value = tenths < 0 ? -tenths : tenths;
+    char digits[4];
+    unsigned char n = 0;
+
+    text[i++] = 'T';
+    text[i++] = '=';
+    if (tenths < 0)
+        text[i++] = '-';
+    do
+    {
+        digits[n++] = '0' + value % 10;
+        value /= 10;
+    } while (value != 0 && n < sizeof(digits));
+    if (n == 1)
+        digits[n++] = '0';                  // Leading zero before the point
+    while (n > 1)
+        text[i++] = digits[--n];
+    text[i++] = '.';
+    text[i++] = digits[0];
+    text[i++] = 0xDF;                       // Built-in degree symbol
+    text[i++] = unit;
+    n = i;                                  // The arrow goes here
+    while (i < sizeof(text) - 1)
+        text[i++] = ' ';                    // Clear what a longer value left
+    text[i] = '\0';
+    lcd_print(text, 0x40);
+    if (spark_count == 0)
+        last_tenths = tenths;               // First reading: no trend yet
+    if (tenths > last_tenths)
+        lcd_put_glyph(0x40 + n, GLYPH_UP, glyph_up);
+    else if (tenths < last_tenths)
+        lcd_put_glyph(0x40 + n, GLYPH_DOWN, glyph_down);
+    else
+        lcd_put(0x40 + n, ARROW_STEADY);
+    last_tenths = tenths;
+    state.unit = unit;
 }
 
-void lcd_print(const char* str, unsigned char startPos) {
-    lcdSetCursor(startPos);
-    while (*str) {
-        send_data(*str++);
-        startPos++;
-        if (startPos == 0x10) startPos = 0x40;  // Salto automático a segunda línea
-    }
+// The unlocked screen: pattern or "NO PATTERN", a temperature
+// placeholder until the next reading, and the window size
+void show_screen(void)
+{
+    lcd_clear();
+    if (pattern_cur != '\0')
+        show_pattern(pattern_cur);
+    else
+        lcd_print("NO PATTERN", 0x00);
+    lcd_print("T=xx.x", 0x40);              // Start of temperature display
+    lcd_put(0x46, 0xDF);                    // Built-in degree symbol
+    lcd_put(0x47, state.unit);
+    show_window(state.window, state.filter);
+    show_spark();
+}
+
+// The locked screen: blank but for the lock
+void show_locked(void)
+{
+    lcd_clear();
+    lcd_put_glyph(LOCK_POSITION, GLYPH_LOCK, glyph_lock);
 }
 
 void display_output(char input)
 {
+    if (mode == 'B' && (input == 'A' || input == 'C'))
+        show_window(state.window, state.filter);    // Entry left unapplied
+
     switch (input)
     {
         case 'A':
             mode = 'A';
             break;
         case 'B':
-            lcd_print("SET WINDOW SIZE ", 0x00);
+            lcd_print("SET WINDOW    ", 0x00);
             mode = 'B';
+            window_entry = 0;
+            filter_entry = state.filter;
             break;
         case 'C':
-            lcd_print("SET PATTERN     ", 0x00);
+            lcd_print("SET PATTERN   ", 0x00);
             mode = 'C';
             break;
         case 'D':
-            send_command(0x01);
+            lcd_clear();
             break;
         case 'Z':
-            send_command(0x01);
-            __delay_cycles(2000);
-            lcd_print("NO PATTERN", 0x00);
-            lcd_print("T=xx.x", 0x40);      // Start of temperature display
-            lcdSetCursor(0x46);             // Move to where the degree symbol goes
-            send_data(0xDF);                // Send the built-in degree symbol
-            lcd_print("C", 0x47);           // Continue with 'C'
-            lcd_print("N=3", 0x4D);
+            pattern_cur = '\0';             // The LED bar cleared it on lock
+            show_screen();
             mode = 'A';
             break;
     }
 
-    if ((mode == 'B') && (input >= '1' && input <= '9')) 
-    { 
-        new_window_size = input;
-        lcd_print("N=", 0x4D);
-        send_data(new_window_size);
-        mode = 'C';
-        input = pattern_cur;
-    } 
-           
+    // Echo the entry as it is typed; the controller applies it on '#'
+    // with FRAME_OP_SET_WINDOW
+    if (mode == 'B' && input >= '0' && input <= '9')
+    {
+        window_entry = window_entry * 10 + (input - '0');
+        show_window(window_entry, filter_entry);
+    }
+    else if (mode == 'B' && input == '*')
+    {
+        filter_entry = (filter_entry + 1) % FILTER_COUNT;
+        show_window(window_entry != 0 ? window_entry : state.window, filter_entry);
+    }
+
     if (mode == 'C')
     {
-        switch (input) 
-        { 
-            case '0':
-                lcd_print("STATIC          ", 0x00);
-                pattern_cur = input;
-                mode = 'A';
-                break;
-            case '1':
-                lcd_print("TOGGLE          ", 0x00);
-                pattern_cur = input;
-                mode = 'A';
-                break;
-            case '2':
-                lcd_print("UP COUNTER      ", 0x00);
-                pattern_cur = input;
-                mode = 'A';
-                break;
-            case '3':
-                lcd_print("IN AND OUT      ", 0x00);
-                pattern_cur = input;
-                mode = 'A';
-                break;
-            case '4':
-                lcd_print("DOWN COUNTER    ", 0x00);
-                pattern_cur = input;
-                mode = 'A';
-                break;
-            case '5':
-                lcd_print("ROTATE 1 LEFT   ", 0x00);
-                pattern_cur = input;
-                mode = 'A';
-                break;
-            case '6':
-                lcd_print("ROTATE 7 RIGHT  ", 0x00);
-                pattern_cur = input;
-                mode = 'A';
-                break;
-            case 'D':
-                send_command(0x01);
-                mode = 'A';
-                break;
+        if (input >= '0' && input < '0' + PATTERN_COUNT)
+        {
+            show_pattern(input);
+            mode = 'A';
+        }
+        else if (input == 'D')
+        {
+            lcd_clear();
+            mode = 'A';
         }
     }
 }
 
-int main(void) {
-    //char key_unlocked;
-    WDTCTL = WDTPW | WDTHOLD;  // Detener el watchdog
-    PM5CTL0 &= ~LOCKLPM5;
-    lcdInit();  // Inicializar el LCD
-    I2C_Slave_Init();                   // Initialize the slave for I2C
-    __bis_SR_register(LPM0_bits + GIE); // Enter LPM0, enable interrupts
-    return 0;
-        
-    
-}
-
-// I2C ISR
-#pragma vector = USCI_B0_VECTOR
-__interrupt void USCI_B0_ISR(void)
+// Act on one complete command frame from the controller
+void frame_dispatch(const i2c_frame_t *frame)
 {
-    switch (__even_in_range(UCB0IV, USCI_I2C_UCTXIFG0))
+    int tenths;
+
+    switch (frame->opcode)
     {
-        case USCI_I2C_UCRXIFG0:         // Receive Interrupt
-            display_output(UCB0RXBUF);
+        case FRAME_OP_KEY:
+            display_output(frame->payload[0]);
             break;
-        default: 
+        case FRAME_OP_SET_WINDOW:
+            state.window = frame->payload[0] | (frame->payload[1] << 8);
+            if (frame->length > 2 && frame->payload[2] < FILTER_COUNT)
+                state.filter = frame->payload[2];
+            show_window(state.window, state.filter);
+            if (pattern_cur != '\0')
+                show_pattern(pattern_cur);      // Replace the window prompt
+            else
+                lcd_print("NO PATTERN    ", 0x00);
+            mode = 'A';
+            break;
+        case FRAME_OP_TEMPERATURE:
+            tenths = frame->payload[0] | (frame->payload[1] << 8);
+            show_temperature(tenths, frame->length > 2 ? frame->payload[2] : 'C');
+            spark_add(tenths);
+            show_spark();
+            break;
+        case FRAME_OP_SET_PATTERN:
+            if (frame->payload[0] < PATTERN_COUNT)
+                show_pattern('0' + frame->payload[0]);
+            mode = 'A';
+            break;
+        case FRAME_OP_UNLOCK:
+            display_output('Z');
+            state.unlocked = true;
+            break;
+        case FRAME_OP_LOCK:
+            display_output('D');
+            show_locked();
+            state.unlocked = false;
+            break;
+        case FRAME_OP_TRACE_DUMP:
+            trace_dump('L');
             break;
     }
+    lcd_flush();                            // Send only the cells that changed
+
+    // Temperature frames leave this unchanged, so FRAM is only written
+    // when a key changed what is shown
+    state.pattern = pattern_cur;
+    persist_save(&state, sizeof(state), STATE_VERSION);
+}
+
+// Bring back what was on screen before the reset
+void state_restore(void)
+{
+    if (!persist_load(&state, sizeof(state), STATE_VERSION))
+        return;
+    if (state.pattern >= '0' && state.pattern < '0' + PATTERN_COUNT)
+        pattern_cur = state.pattern;
+    if (state.unlocked)
+        show_screen();
+    else
+        show_locked();
+    lcd_flush();
+}
+
+int main(void) {
+    event_t event;
+    bool warm;
+    clock_init();                       // Stops the watchdog first
+    warm = persist_warm_start();        // Before anything else reads SYSRSTIV
+    GPIO_UNLOCK();
+    trace_init();
+    lcd_init(warm);                     // The LCD is already up after a warm reset
+    state_restore();
+    i2c_slave_init(SLAVE_ADDR);         // Frames arrive as EVENT_FRAME
+
+    // Frames are handled here, one at a time, never inside the I2C ISR
+    while (true)
+    {
+        while (event_get(&event))
+        {
+            switch (event.type)
+            {
+                case EVENT_FRAME:
+                    frame_dispatch((const i2c_frame_t *)event.data);
+                    break;
+                case EVENT_LCD_FLUSH:
+                    lcd_flush();
+                    break;
+            }
+        }
+        event_sleep();                  // LPM0 until an ISR posts
+    }
+    return 0;
 }
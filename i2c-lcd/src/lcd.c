@@ -0,0 +1,347 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include <string.h>
+#include "lcd.h"
+#include "trace.h"
+#include "ring.h"
+
+// Port 2
+#define RS BIT0     // P2.0
+#define EN BIT6     // P2.6
+
+// Port 1
+#define D4 BIT4     // P1.4
+#define D5 BIT5     // P1.5
+#define D6 BIT6     // P1.6
+#define D7 BIT7     // P1.7
+#define DATA_MASK (D4 | D5 | D6 | D7)
+
+#define QUEUE_DATA  0x0100  // Queue entry flag: write to DDRAM/CGRAM (RS = 1)
+
+// Bytes waiting for the LCD (common/ring.h). Main is the sole producer and
+// only advances queue_head; the TB0 ISR is the sole consumer and only
+// advances queue_tail.
+RING_CHECK_SIZE(lcd_queue, LCD_QUEUE_SIZE);
+static unsigned int queue[LCD_QUEUE_SIZE];
+static volatile unsigned char queue_head, queue_tail;
+volatile unsigned int lcd_overflow_count;
+
+// What the application wants on screen, and what has been queued to the
+// LCD so far. lcd_flush() sends only the cells where the two differ.
+static char shadow[LCD_ROWS][LCD_COLS];
+static char shown[LCD_ROWS][LCD_COLS];
+static volatile bool flush_pending;     // A flush stopped on a full queue
+
+// Which glyph each CGRAM slot holds (LCD_GLYPH_NONE if none), slots in
+// least recently used order, and the slots lcd_flush() must upload
+#define LCD_GLYPH_NONE 0xFF
+static unsigned char glyph_id[LCD_GLYPH_SLOTS];
+static const unsigned char *glyph_bitmap[LCD_GLYPH_SLOTS];
+static unsigned char glyph_lru[LCD_GLYPH_SLOTS];   // Most recently used first
+static unsigned char glyph_dirty;                   // Bit per slot
+unsigned int lcd_glyph_misses;
+
+//----------------------------------------------------------------------
+// Begin Bus Writes
+//----------------------------------------------------------------------
+// EN is held high for the 450 ns minimum and the next nibble waits out
+// the 1000 ns enable cycle time, at whatever MCLK is.
+static void lcd_nibble(unsigned char nibble)
+{
+    P1OUT = (P1OUT & ~DATA_MASK) | ((nibble & 0x0F) << 4);
+    P2OUT |= EN;
+    __delay_cycles(CLOCK_CYCLES_NS(450));
+    P2OUT &= ~EN;
+    __delay_cycles(CLOCK_CYCLES_NS(550));
+}
+
+static void lcd_write(unsigned int entry)
+{
+    if (entry & QUEUE_DATA) {
+        P2OUT |= RS;
+    } else {
+        P2OUT &= ~RS;
+    }
+    lcd_nibble(entry >> 4);
+    lcd_nibble(entry);
+}
+//--End Bus Writes------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin LCD Initialization
+//----------------------------------------------------------------------
+// The power-on reset sequence runs blocking, once, before interrupts are
+// enabled; after that the configuration goes through the queue. With
+// `powered` (the MCU reset but the supply did not drop, so the LCD has
+// long been up) the 40 ms power-on wait is skipped; the 8-bit resync
+// still runs, since a reset can land between the nibbles of a byte.
+void lcd_init(bool powered)
+{
+    unsigned char i;
+
+    P1DIR |= DATA_MASK;
+    P2DIR |= RS | EN;
+    P1OUT &= ~DATA_MASK;
+    P2OUT &= ~(RS | EN);
+
+    // Drain timer: TB0 free-runs on SMCLK, CCR0 is armed while bytes wait
+    TB0CTL |= TBCLR;                // Clear timer and dividers
+    TB0CTL |= TBSSEL__SMCLK;        // Source = SMCLK
+    TB0CTL |= MC__CONTINUOUS;       // Mode = continuous
+    TB0CCTL0 &= ~(CCIFG | CCIE);
+
+    if (!powered) {
+        __delay_cycles(CLOCK_CYCLES_US(40000)); // > 40 ms after power-on
+    }
+    lcd_nibble(0x03);                           // Function set, 8-bit
+    __delay_cycles(CLOCK_CYCLES_US(4100));      // > 4.1 ms
+    lcd_nibble(0x03);
+    __delay_cycles(CLOCK_CYCLES_US(100));       // > 100 us
+    lcd_nibble(0x03);
+    __delay_cycles(CLOCK_CYCLES_US(LCD_WAIT_US));
+    lcd_nibble(0x02);                           // Switch to 4-bit
+    __delay_cycles(CLOCK_CYCLES_US(LCD_WAIT_US));
+
+    lcd_command(LCD_FUNCTION_4BIT);
+    lcd_command(LCD_DISPLAY_ON);
+    lcd_command(LCD_ENTRY_INC);
+    lcd_command(LCD_CLEAR);
+    lcd_clear();
+    memset(shown, ' ', sizeof(shown));  // What LCD_CLEAR leaves in DDRAM
+
+    // CGRAM is not cleared, and after a warm start holds whatever it did
+    memset(glyph_id, LCD_GLYPH_NONE, sizeof(glyph_id));
+    for (i = 0; i < LCD_GLYPH_SLOTS; i++) {
+        glyph_lru[i] = i;
+    }
+    glyph_dirty = 0;
+}
+//--End LCD Initialization----------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Queue
+//----------------------------------------------------------------------
+static unsigned char lcd_queue_free(void)
+{
+    return RING_FREE(queue_head, queue_tail, LCD_QUEUE_SIZE);
+}
+
+// Queue one byte and start the drain timer if it was idle. Never waits.
+static void lcd_enqueue(unsigned int entry)
+{
+    if (lcd_queue_free() == 0) {
+        lcd_overflow_count++;
+        return;
+    }
+    queue[RING_SLOT(queue_head, LCD_QUEUE_SIZE)] = entry;
+    queue_head++;                   // Publish after the slot is written
+
+    if (!(TB0CCTL0 & CCIE)) {       // Idle: the last wait has already passed
+        TB0CCTL0 &= ~CCIFG;
+        TB0CCR0 = TB0R + 2;
+        TB0CCTL0 |= CCIE;
+    }
+}
+
+void lcd_command(unsigned char cmd)
+{
+    lcd_enqueue(cmd);
+}
+
+void lcd_data(unsigned char data)
+{
+    lcd_enqueue(QUEUE_DATA | data);
+}
+
+void lcd_set_cursor(unsigned char position)
+{
+    lcd_enqueue(LCD_SET_DDRAM | position);
+}
+
+// True while bytes are queued or the last one is still executing
+bool lcd_busy(void)
+{
+    return (TB0CCTL0 & CCIE) != 0;
+}
+//--End Queue-----------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Framebuffer
+//----------------------------------------------------------------------
+// Positions are DDRAM addresses: 0x00-0x0F on line 1, 0x40-0x4F on
+// line 2. Writes only touch the shadow; nothing reaches the LCD until
+// lcd_flush().
+void lcd_put(unsigned char position, char c)
+{
+    shadow[position >> 6][position & (LCD_COLS - 1)] = c;
+}
+
+// Text from `position` on, wrapping from the end of line 1 to line 2
+void lcd_print(const char *str, unsigned char position)
+{
+    while (*str) {
+        if (position == 0x10) {
+            position = 0x40;
+        } else if (position == 0x50) {
+            break;                      // Off the end of the screen
+        }
+        lcd_put(position++, *str++);
+    }
+}
+
+void lcd_clear(void)
+{
+    memset(shadow, ' ', sizeof(shadow));
+}
+
+// Send the cells that changed since the last flush. A run of adjacent
+// changed cells costs one cursor command plus its characters, since
+// DDRAM auto-increments. If the queue fills, the drain ISR posts
+// EVENT_LCD_FLUSH once it empties, and main flushes the rest.
+void lcd_flush(void)
+{
+    unsigned char row, col, slot;
+    bool in_run;
+
+    flush_pending = false;
+    for (slot = 0; glyph_dirty != 0; slot++) {
+        if (!(glyph_dirty & (1 << slot))) {
+            continue;
+        }
+        if (lcd_queue_free() < 1 + LCD_GLYPH_ROWS) {
+            flush_pending = true;
+            return;
+        }
+        lcd_command(LCD_SET_CGRAM | (slot << 3));
+        for (row = 0; row < LCD_GLYPH_ROWS; row++) {
+            lcd_data(glyph_bitmap[slot][row]);
+        }
+        glyph_dirty &= ~(1 << slot);
+    }
+    // Each run below starts with a cursor command, which moves the
+    // address counter back from CGRAM to DDRAM
+    for (row = 0; row < LCD_ROWS; row++) {
+        in_run = false;
+        for (col = 0; col < LCD_COLS; col++) {
+            if (shadow[row][col] == shown[row][col]) {
+                in_run = false;
+                continue;
+            }
+            if (lcd_queue_free() < (in_run ? 1 : 2)) {
+                flush_pending = true;
+                return;
+            }
+            if (!in_run) {
+                lcd_set_cursor((row << 6) | col);
+                in_run = true;
+            }
+            lcd_data(shadow[row][col]);
+            shown[row][col] = shadow[row][col];
+        }
+    }
+}
+//--End Framebuffer-----------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Glyph Cache
+//----------------------------------------------------------------------
+// Move `slot` to the front of the LRU order
+static void glyph_touch(unsigned char slot)
+{
+    unsigned char i;
+
+    for (i = 0; glyph_lru[i] != slot; i++) {
+    }
+    for (; i > 0; i--) {
+        glyph_lru[i] = glyph_lru[i - 1];
+    }
+    glyph_lru[0] = slot;
+}
+
+// True if a cell other than `position` will show `slot` after a flush
+static bool glyph_on_screen(unsigned char slot, unsigned char position)
+{
+    unsigned char row, col;
+
+    for (row = 0; row < LCD_ROWS; row++) {
+        for (col = 0; col < LCD_COLS; col++) {
+            if (shadow[row][col] == (char)slot && ((row << 6) | col) != position) {
+                return true;
+            }
+        }
+    }
+    return false;
+}
+
+bool lcd_put_glyph(unsigned char position, unsigned char id, const unsigned char *bitmap)
+{
+    unsigned char i, slot;
+
+    for (slot = 0; slot < LCD_GLYPH_SLOTS && glyph_id[slot] != id; slot++) {
+    }
+    if (slot == LCD_GLYPH_SLOTS) {
+        // Miss: the least recently used slot that is not on screen
+        i = LCD_GLYPH_SLOTS;
+        do {
+            if (i-- == 0) {
+                return false;           // All eight in use
+            }
+        } while (glyph_on_screen(glyph_lru[i], position));
+        slot = glyph_lru[i];
+        glyph_id[slot] = id;
+        glyph_dirty |= 1 << slot;
+        lcd_glyph_misses++;
+    }
+    glyph_bitmap[slot] = bitmap;
+    glyph_touch(slot);
+    lcd_put(position, (char)slot);
+    return true;
+}
+
+void lcd_glyph_changed(unsigned char id)
+{
+    unsigned char slot;
+
+    for (slot = 0; slot < LCD_GLYPH_SLOTS; slot++) {
+        if (glyph_id[slot] == id) {
+            glyph_dirty |= 1 << slot;
+        }
+    }
+}
+//--End Glyph Cache-----------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Interrupt Service Routine
+//----------------------------------------------------------------------
+// Each compare sends the next byte and sets the following compare at the
+// execution time of what was just sent. With nothing left, the timer
+// interrupt is turned off until the next lcd_enqueue().
+#pragma vector = TIMER0_B0_VECTOR
+__interrupt void ISR_TB0_CCR0(void)
+{
+    unsigned int entry;
+
+    TRACE_ENTER(TRACE_TIMER0_B0);
+    TB0CCTL0 &= ~CCIFG;
+    if (queue_tail == queue_head) {
+        TB0CCTL0 &= ~CCIE;
+        if (flush_pending) {
+            flush_pending = false;
+            event_post(EVENT_LCD_FLUSH, 0, 0);  // Main finishes the flush
+            EVENT_WAKE_ON_EXIT();
+        }
+        TRACE_EXIT(TRACE_TIMER0_B0);
+        return;
+    }
+    entry = queue[RING_SLOT(queue_tail, LCD_QUEUE_SIZE)];
+    queue_tail++;
+    lcd_write(entry);
+    if (entry == LCD_CLEAR || (entry & 0x1FE) == LCD_HOME) {
+        TB0CCR0 += LCD_WAIT_LONG;
+    } else {
+        TB0CCR0 += LCD_WAIT;
+    }
+    TRACE_EXIT(TRACE_TIMER0_B0);
+}
+//--End Interrupt Service Routine---------------------------------------
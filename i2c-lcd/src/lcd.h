@@ -0,0 +1,53 @@
+#include <stdbool.h>
+#include "event.h"
+#include "clock.h"
+
+// HD44780 instructions
+#define LCD_CLEAR           0x01
+#define LCD_HOME            0x02
+#define LCD_ENTRY_INC       0x06    // Cursor moves right after each write
+#define LCD_DISPLAY_ON      0x0C    // Display on, cursor and blink off
+#define LCD_FUNCTION_4BIT   0x28    // 4-bit bus, 2 lines, 5x8 font
+#define LCD_SET_CGRAM       0x40    // OR with the CGRAM address
+#define LCD_SET_DDRAM       0x80    // OR with the DDRAM address
+
+// Execution times, HD44780 datasheet minimums, in us and in TB0 (SMCLK) ticks
+#define LCD_WAIT_US         37      // Most instructions and data writes
+#define LCD_WAIT_LONG_US    1520    // Clear display and return home
+#define LCD_WAIT            CLOCK_SMCLK_US(LCD_WAIT_US)
+#define LCD_WAIT_LONG       CLOCK_SMCLK_US(LCD_WAIT_LONG_US)
+#define LCD_QUEUE_SIZE      64      // Pending bytes, power of two
+#define EVENT_LCD_FLUSH     (EVENT_APP + 0x0F)  // Posted by the driver: call lcd_flush()
+#define LCD_ROWS            2
+#define LCD_COLS            16
+#define LCD_GLYPH_SLOTS     8       // CGRAM characters 0-7
+#define LCD_GLYPH_ROWS      8       // 5 pixels each, bit 4 on the left
+
+void lcd_init(bool powered);
+bool lcd_busy(void);
+
+// Screen contents go through a shadow framebuffer: draw with these, then
+// lcd_flush() sends only what changed
+void lcd_put(unsigned char position, char c);
+void lcd_print(const char *str, unsigned char position);
+void lcd_clear(void);
+void lcd_flush(void);
+
+// Custom glyphs, cached in the CGRAM slots: `id` is the caller's name
+// for the glyph. A glyph already in a slot costs nothing; a miss takes
+// the least recently used slot not on screen and lcd_flush() uploads
+// the bitmap, which must stay valid while the glyph is cached. Returns
+// false, drawing nothing, if every slot is on screen. After editing a
+// cached glyph's bitmap, lcd_glyph_changed() has the next flush upload
+// it again: cells already showing it change without being rewritten.
+bool lcd_put_glyph(unsigned char position, unsigned char id, const unsigned char *bitmap);
+void lcd_glyph_changed(unsigned char id);
+
+// Raw instructions, bypassing the framebuffer. Anything that moves or
+// rewrites DDRAM here leaves the shadow out of step with the screen.
+void lcd_command(unsigned char cmd);
+void lcd_data(unsigned char data);
+void lcd_set_cursor(unsigned char position);
+
+extern volatile unsigned int lcd_overflow_count;    // Bytes lost to a full queue
+extern unsigned int lcd_glyph_misses;               // Glyphs that needed a slot
@@ -0,0 +1,181 @@
+/**
+ * @file
+ * @brief Host test for the queued HD44780 driver.
+ *
+ * Draws into the framebuffer and flushes the way the I2C ISR does, then
+ * fires the TB0 compare ISR until the queue drains. Checks that nothing
+ * spins, that each byte is followed by exactly its datasheet wait, and
+ * how many bytes a redraw costs, with and without glyph cache misses,
+ * and that a miss evicts the least recently used slot not on screen.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon -Ii2c-lcd/src i2c-lcd/test/lcd_host_test.c i2c-lcd/src/lcd.c \
+ *       common/event.c common/host/msp430_host.c -o lcd_test && ./lcd_test
+ */
+#include <msp430.h>
+#include <stdio.h>
+#include "intrinsics.h"
+#include "lcd.h"
+#include "event.h"
+#include "host_test.h"
+
+void ISR_TB0_CCR0(void);
+
+// Fire the compare ISR until the queue is empty, handling flush events
+// the way the slave's main loop does. Stores the wait set after each
+// byte in waits[] and returns how many bytes went out.
+static int drain(unsigned int *waits, int max)
+{
+    int n = 0;
+    event_t event;
+
+    while (TB0CCTL0 & CCIE || event_get(&event)) {
+        if (!(TB0CCTL0 & CCIE)) {
+            if (event.type == EVENT_LCD_FLUSH) {
+                lcd_flush();
+            }
+            continue;
+        }
+        unsigned int before = TB0CCR0;
+
+        ISR_TB0_CCR0();
+        if (TB0CCTL0 & CCIE) {
+            if (n < max) {
+                waits[n] = TB0CCR0 - before;
+            }
+            n++;
+        }
+    }
+    return n;
+}
+
+int main(void)
+{
+    static unsigned char bitmap[LCD_GLYPH_SLOTS][LCD_GLYPH_ROWS];
+    unsigned int waits[80];
+    unsigned int misses;
+    unsigned long spun;
+    int n, i, ok;
+
+    spun = host_delay_cycles;
+    lcd_init(true);
+    report("warm start skips the 40 ms power-on wait",
+           host_delay_cycles - spun < CLOCK_CYCLES_US(5000));
+    drain(waits, 80);
+    spun = host_delay_cycles;
+    lcd_init(false);
+    report("cold start waits for the LCD to power up",
+           host_delay_cycles - spun >= CLOCK_CYCLES_US(44100));
+    n = drain(waits, 80);
+    report("init queues four configuration commands", n == 4);
+    report("clear waits 1.52 ms, the others 37 us",
+           waits[0] == LCD_WAIT && waits[1] == LCD_WAIT && waits[2] == LCD_WAIT && waits[3] == LCD_WAIT_LONG);
+    report("idle after the queue drains", !lcd_busy());
+
+    spun = host_delay_cycles;
+    lcd_print("SET PATTERN     ", 0x00);
+    lcd_flush();
+    report("lcd_flush does not spin", host_delay_cycles == spun);
+    report("lcd_flush starts the drain timer", lcd_busy());
+    n = drain(waits, 80);
+    ok = n == 12;
+    for (i = 0; i < n && i < 80; i++) {
+        ok = ok && waits[i] == LCD_WAIT;
+    }
+    report("one cursor + 11 changed cells, 37 us apart", ok);
+    printf("  old driver: %u cycles in the ISR, new: 0 (%u us of timer waits)\n",
+           17 * (2 * 2000 + 4000), n * LCD_WAIT_US);
+
+    lcd_print("T=23.4\xDF" "C", 0x40);
+    lcd_flush();
+    drain(waits, 80);
+    lcd_print("T=23.5\xDF" "C", 0x40);
+    lcd_flush();
+    n = drain(waits, 80);
+    report("temperature refresh sends cursor + 1 digit", n == 2);
+
+    lcd_put(0x01, 'x');
+    lcd_put(0x04, 'y');
+    lcd_flush();
+    n = drain(waits, 80);
+    report("two separate changes cost two cursor commands", n == 4);
+
+    lcd_flush();
+    report("unchanged screen sends nothing", !lcd_busy());
+
+    lcd_command(LCD_HOME);
+    lcd_data(0x02);                     // Data byte that looks like "home"
+    n = drain(waits, 80);
+    report("home waits long, a data 0x02 does not",
+           n == 2 && waits[0] == LCD_WAIT_LONG && waits[1] == LCD_WAIT);
+
+    for (i = 0; i < LCD_QUEUE_SIZE + 6; i++) {
+        lcd_data('x');
+    }
+    report("full queue counts dropped bytes", lcd_overflow_count == 6);
+    n = drain(waits, 80);
+    report("queued bytes still go out", n == LCD_QUEUE_SIZE);
+
+    for (i = 0; i < LCD_QUEUE_SIZE - 4; i++) {
+        lcd_data('x');
+    }
+    lcd_print("abcdefghijklmnopqrstuvwxyz012345", 0x00);
+    lcd_flush();
+    n = drain(waits, 80);
+    report("flush cut short by a full queue finishes later",
+           n == LCD_QUEUE_SIZE - 4 + 3 + 32 && lcd_overflow_count == 6);   // Resumes with a cursor
+
+    // Glyph cache
+    lcd_clear();
+    lcd_flush();
+    drain(waits, 80);
+    misses = lcd_glyph_misses;
+    ok = lcd_put_glyph(0x0E, 20, bitmap[0]);
+    lcd_flush();
+    n = drain(waits, 80);
+    report("a glyph miss uploads 8 rows before the cell", ok && n == 1 + LCD_GLYPH_ROWS + 2 &&
+           lcd_glyph_misses == misses + 1);
+
+    ok = lcd_put_glyph(0x40, 20, bitmap[0]);
+    lcd_flush();
+    n = drain(waits, 80);
+    report("a hit costs only its cell", ok && n == 2 && lcd_glyph_misses == misses + 1);
+
+    bitmap[0][3] ^= 0x1F;
+    lcd_glyph_changed(20);
+    lcd_flush();
+    n = drain(waits, 80);
+    report("a changed glyph is uploaded again, cells untouched", n == 1 + LCD_GLYPH_ROWS);
+
+    // Eight glyphs on screen: a ninth has no slot until one is off screen
+    lcd_clear();
+    for (i = 0; i < LCD_GLYPH_SLOTS; i++) {
+        ok = lcd_put_glyph(i, 30 + i, bitmap[i]) && ok;
+    }
+    ok = ok && !lcd_put_glyph(0x40, 40, bitmap[0]);
+    lcd_put(2, ' ');
+    lcd_put(5, ' ');
+    ok = ok && lcd_put_glyph(0x41, 32, bitmap[2]);  // 32 is now used after 35
+    lcd_put(0x41, ' ');
+    misses = lcd_glyph_misses;
+    ok = ok && lcd_put_glyph(0x40, 40, bitmap[0]) && lcd_glyph_misses == misses + 1;
+    ok = ok && lcd_put_glyph(0x41, 32, bitmap[2]) && lcd_glyph_misses == misses + 1;
+    lcd_put(0x41, ' ');
+    ok = ok && lcd_put_glyph(0x42, 35, bitmap[5]) && lcd_glyph_misses == misses + 2;
+    report("a miss evicts the least recently used unseen slot", ok);
+
+    // An upload that does not fit in the queue waits for the drain
+    lcd_flush();
+    drain(waits, 80);
+    for (i = 0; i < LCD_QUEUE_SIZE - 4; i++) {
+        lcd_data('x');
+    }
+    lcd_glyph_changed(30);
+    lcd_put(0x4F, 'z');
+    lcd_flush();
+    n = drain(waits, 80);
+    report("an upload cut short by a full queue finishes later",
+           n == LCD_QUEUE_SIZE - 4 + 1 + LCD_GLYPH_ROWS + 2 && lcd_overflow_count == 6);
+
+    return failures != 0;
+}
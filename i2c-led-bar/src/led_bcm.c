@@ -0,0 +1,105 @@
+#include <msp430.h>
+#include "intrinsics.h"
+#include <stdbool.h>
+#include "led_bcm.h"
+#include "trace.h"
+
+#if LED_BCM_BITS < 4 || LED_BCM_BITS > 6
+#error "LED_BCM_BITS must be 4 to 6"
+#endif
+
+#if LED_BCM_UNIT < 100
+#error "LED_BCM_UNIT too short for the slot interrupt, lower LED_BCM_HZ"
+#endif
+
+unsigned char led_bcm_frame[LED_BCM_LEDS];
+
+// Bit planes: planes[n][b] holds the bar LEDs that are on in slot b.
+// The ISR shows planes[front]; led_bcm_show() fills the other one and
+// sets `pending`, and the ISR swaps at the next frame boundary.
+static unsigned char planes[2][LED_BCM_BITS];
+static volatile unsigned char front;
+static volatile bool pending;
+static unsigned char slot;          // Next slot the ISR shows
+
+//------------------------------------------------------------------------------
+// Begin Output
+//------------------------------------------------------------------------------
+// Bar LEDs 2 and 3 are on P2.6 and P2.7, since P1.2 and P1.3 carry I2C
+static void led_bcm_output(unsigned char bar)
+{
+    P1OUT = bar;
+    P2OUT = (P2OUT & 0x3F) | ((bar & 0x0C) << 4);
+}
+//--End Output------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin BCM Initialization
+//------------------------------------------------------------------------------
+// TB1 free-runs on SMCLK; its CCR0 interrupt is only on while a frame
+// has in-between levels.
+void led_bcm_init(void)
+{
+    TB1CTL = TBSSEL__SMCLK | MC__CONTINUOUS | TBCLR;
+    TB1CCTL0 = 0;
+}
+//--End BCM Initialization------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Show
+//------------------------------------------------------------------------------
+void led_bcm_show(void)
+{
+    unsigned int sr = __get_SR_register();
+    unsigned char next[LED_BCM_BITS];
+    unsigned char b, i, bit;
+    bool steady = true;
+
+    for (b = 0; b < LED_BCM_BITS; b++) {
+        next[b] = 0;
+        for (i = 0, bit = 1; i < LED_BCM_LEDS; i++, bit <<= 1) {
+            if (led_bcm_frame[i] & (1 << b)) {
+                next[b] |= bit;
+            }
+        }
+        steady = steady && next[b] == next[0];
+    }
+
+    __disable_interrupt();
+    if (steady) {
+        TB1CCTL0 = 0;               // Only 0 and LED_BCM_MAX: no slots needed
+        pending = false;
+        led_bcm_output(next[0]);
+    } else {
+        for (b = 0; b < LED_BCM_BITS; b++) {
+            planes[front ^ 1][b] = next[b];
+        }
+        pending = true;
+        if (!(TB1CCTL0 & CCIE)) {   // Start a frame now
+            slot = 0;
+            TB1CCR0 = TB1R + LED_BCM_UNIT;
+            TB1CCTL0 = CCIE;
+        }
+    }
+    __bis_SR_register(sr & GIE);
+}
+//--End Show--------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Interrupt Service Routine
+//------------------------------------------------------------------------------
+// Show slot `slot` for LED_BCM_UNIT << slot ticks, then move on
+#pragma vector = TIMER1_B0_VECTOR
+__interrupt void ISR_TB1_CCR0(void)
+{
+    TRACE_ENTER(TRACE_TIMER1_B0);
+    if (slot == 0 && pending) {
+        front ^= 1;
+        pending = false;
+    }
+    led_bcm_output(planes[front][slot]);
+    TB1CCR0 += LED_BCM_UNIT << slot;
+    slot = (slot == LED_BCM_BITS - 1) ? 0 : slot + 1;
+    TRACE_EXIT(TRACE_TIMER1_B0);
+}
+//--End Interrupt Service Routine-----------------------------------------------
@@ -0,0 +1,33 @@
+/**
+ * @file
+ * @brief Per-LED brightness for the bar by binary code modulation.
+ *
+ * Each frame is split into LED_BCM_BITS slots of 1, 2, 4, ... units; in
+ * slot b an LED is on if bit b of its brightness is set, so its on-time
+ * is exactly brightness / LED_BCM_LEVELS of the frame. That is one TB1
+ * compare interrupt per slot, LED_BCM_BITS per frame whatever the
+ * resolution, instead of one per PWM step.
+ *
+ * Write led_bcm_frame[] and call led_bcm_show(); the new frame starts at
+ * the next frame boundary, so a change never tears. A frame of only 0
+ * and LED_BCM_MAX is written straight to the port and TB1 stops, so
+ * plain on/off patterns cost no interrupts at all.
+ */
+#ifndef LED_BCM_H
+#define LED_BCM_H
+
+#include "clock.h"
+
+#define LED_BCM_LEDS    8
+#define LED_BCM_BITS    5           // 4 to 6
+#define LED_BCM_LEVELS  (1 << LED_BCM_BITS)
+#define LED_BCM_MAX     (LED_BCM_LEVELS - 1)
+#define LED_BCM_HZ      150         // Frames per second, above visible flicker
+#define LED_BCM_UNIT    ((CLOCK_SMCLK_HZ / LED_BCM_HZ) >> LED_BCM_BITS) // Shortest slot, SMCLK ticks
+
+extern unsigned char led_bcm_frame[LED_BCM_LEDS];   // Bar LED i, 0 to LED_BCM_MAX
+
+void led_bcm_init(void);
+void led_bcm_show(void);
+
+#endif // LED_BCM_H
@@ -0,0 +1,180 @@
+#include <msp430.h>
+#include <stdbool.h>
+#include "led_pattern.h"
+#include "timer.h"
+#include "led_bcm.h"
+
+//------------------------------------------------------------------------------
+// Pattern Tables
+//------------------------------------------------------------------------------
+// Each pattern is a list of bar states stepped through in order, kept in FRAM.
+// The two counters would need 256 entries, so they have no list and show their
+// step number instead, inverted for the down counter. A pattern with a tail
+// lights its bar state at full brightness and dims every other LED by `tail`
+// halvings per step, so LEDs it left fade out behind it.
+typedef struct
+{
+    const unsigned char *steps;     // Bar states in order, or 0 for a counter
+    unsigned char last;             // Index of the final step before wrapping
+    unsigned char count_mask;       // Counters: bar = step number ^ count_mask
+    unsigned char period;           // Step period in quarters of timing_base,
+                                    // 0 leaves the timer alone
+    unsigned char tail;             // Dimming shift per step, 0 = on/off only
+} led_pattern_t;
+
+static const unsigned char static_steps[] = {0xAA};
+static const unsigned char toggle_steps[] = {0xAA, 0x55};
+static const unsigned char in_out_steps[] = {0x18, 0x24, 0x42, 0x81, 0x42, 0x24};
+static const unsigned char rotate_left_steps[] = {0x01, 0x02, 0x04, 0x08, 0x10, 0x20, 0x40, 0x80};
+static const unsigned char rotate_right_steps[] = {0x7F, 0xBF, 0xDF, 0xEF, 0xF7, 0xFB, 0xFD, 0xFE};
+
+#define STEPS(list) list, sizeof(list) - 1
+
+static const led_pattern_t patterns[LED_PATTERN_COUNT] = {
+    {STEPS(static_steps),       0x00, 0, 0},    // 0: static
+    {STEPS(toggle_steps),       0x00, 4, 0},    // 1: toggle, 1 s
+    {0, 0xFF,                   0x00, 2, 0},    // 2: up counter, 0.5 s
+    {STEPS(in_out_steps),       0x00, 2, 0},    // 3: in and out, 0.5 s
+    {0, 0xFF,                   0xFF, 1, 0},    // 4: down counter, 0.25 s
+    {STEPS(rotate_left_steps),  0x00, 6, 0},    // 5: rotate one left, 1.5 s
+    {STEPS(rotate_right_steps), 0x00, 2, 0},    // 6: rotate 7 right, 0.5 s
+    {STEPS(rotate_left_steps),  0x00, 1, 1},    // 7: comet, 0.25 s
+};
+//--End Pattern Tables----------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Variables
+//------------------------------------------------------------------------------
+unsigned int timing_base = 32768;           // 1 second
+
+static char key_cur;                        // Pattern selected, '0'-'7' or other
+static char key_prev;                       // Selection before that
+static bool new_input = true;               // Next update shows, not steps
+static unsigned char step[LED_PATTERN_COUNT];   // Where each pattern left off
+static bool started[LED_PATTERN_COUNT];
+static unsigned char bar_state;
+static soft_timer_t step_timer;
+//--End Variables---------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Display
+//------------------------------------------------------------------------------
+// LEDs in bar_state go to full brightness; the rest go off, or dim by
+// `tail` halvings for a pattern with a tail.
+static void display_led_pattern(unsigned char tail)
+{
+    unsigned char i, bit;
+
+    for (i = 0, bit = 1; i < LED_BCM_LEDS; i++, bit <<= 1) {
+        if (bar_state & bit) {
+            led_bcm_frame[i] = LED_BCM_MAX;
+        } else {
+            led_bcm_frame[i] = tail ? led_bcm_frame[i] >> tail : 0;
+        }
+    }
+    led_bcm_show();
+}
+//--End Display-----------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Update
+//------------------------------------------------------------------------------
+// Right after a selection, show where the pattern left off, or its first step
+// when it is new or was selected twice in a row. After that, every call
+// advances one step. Anything but '0'-'7' turns the bar off.
+static void led_pattern_update(void)
+{
+    const led_pattern_t *pattern;
+    unsigned char p = key_cur - '0';
+
+    if (p >= LED_PATTERN_COUNT) {
+        bar_state = 0;
+        display_led_pattern(0);
+        return;
+    }
+    pattern = &patterns[p];
+
+    if (new_input) {
+        if (pattern->period != 0) {
+            timer_set_period(&step_timer, (timing_base >> 2) * (unsigned long)pattern->period);
+            new_input = false;
+        }
+        if (key_cur == key_prev || !started[p]) {
+            step[p] = 0;
+            started[p] = true;
+        }
+    } else {
+        step[p] = (step[p] == pattern->last) ? 0 : step[p] + 1;
+    }
+    bar_state = pattern->steps ? pattern->steps[step[p]] : step[p] ^ pattern->count_mask;
+    display_led_pattern(pattern->tail);
+}
+//--End Update------------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Select and Tick
+//------------------------------------------------------------------------------
+// Start the step timer at timing_base. `step_due` runs in the timer
+// interrupt once per step period and should get led_pattern_tick() called.
+void led_pattern_init(timer_callback_t step_due)
+{
+    timer_start(&step_timer, timing_base, timing_base, step_due);
+}
+
+void led_pattern_select(char key)
+{
+    key_prev = key_cur;
+    key_cur = key;
+    new_input = true;
+    led_pattern_update();
+}
+
+// Called once per step period
+void led_pattern_tick(void)
+{
+    led_pattern_update();
+}
+
+unsigned char led_pattern_state(void)
+{
+    return bar_state;
+}
+
+// Step period in ACLK ticks
+unsigned long led_pattern_period(void)
+{
+    return step_timer.period;
+}
+//--End Select and Tick---------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Save and Restore
+//------------------------------------------------------------------------------
+void led_pattern_save(led_pattern_saved_t *saved)
+{
+    unsigned char p;
+
+    saved->key = key_cur;
+    saved->started = 0;
+    for (p = 0; p < LED_PATTERN_COUNT; p++) {
+        saved->step[p] = step[p];
+        if (started[p]) {
+            saved->started |= 1 << p;
+        }
+    }
+}
+
+// Show the saved selection from the step it was on, as if it had been
+// selected again after another pattern.
+void led_pattern_restore(const led_pattern_saved_t *saved)
+{
+    unsigned char p;
+
+    for (p = 0; p < LED_PATTERN_COUNT; p++) {
+        step[p] = saved->step[p] <= patterns[p].last ? saved->step[p] : 0;
+        started[p] = (saved->started >> p) & 1;
+    }
+    key_cur = '\0';
+    led_pattern_select(saved->key);
+}
+//--End Save and Restore--------------------------------------------------------
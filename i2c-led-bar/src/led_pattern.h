@@ -0,0 +1,22 @@
+#include <stdbool.h>
+#include "timer.h"
+
+#define LED_PATTERN_COUNT   8       // Patterns '0' to '7'
+
+// Selection and step positions, for keeping across a reset
+typedef struct
+{
+    char key;                                   // Pattern selected
+    unsigned char step[LED_PATTERN_COUNT];      // Where each pattern left off
+    unsigned char started;                      // Bit per pattern shown before
+} led_pattern_saved_t;
+
+void led_pattern_init(timer_callback_t step_due);
+void led_pattern_select(char key);
+void led_pattern_tick(void);
+unsigned char led_pattern_state(void);
+unsigned long led_pattern_period(void);
+void led_pattern_save(led_pattern_saved_t *saved);
+void led_pattern_restore(const led_pattern_saved_t *saved);
+
+extern unsigned int timing_base;    // Pattern step period scale, ACLK ticks (1 s)
@@ -0,0 +1,95 @@
+/**
+ * @file
+ * @brief Host test for the shared I2C slave (common/i2c_slave.c).
+ *
+ * Feeds frames a byte at a time through the eUSCI_B0 ISR, with a START
+ * before each, and checks that every good frame reaches main as one
+ * EVENT_FRAME with its payload, that a corrupted or cut-short frame posts
+ * nothing, and that a START resynchronises after garbage.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon i2c-led-bar/test/i2c_slave_host_test.c common/i2c_slave.c \
+ *       common/i2c_frame.c common/event.c common/host/msp430_host.c -o i2c_slave_test && ./i2c_slave_test
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include <string.h>
+#include "i2c_slave.h"
+#include "event.h"
+#include "host_test.h"
+
+void USCI_B0_ISR(void);
+
+static void start(void)
+{
+    UCB0IV = USCI_I2C_UCSTTIFG;
+    USCI_B0_ISR();
+}
+
+static void receive(const unsigned char *bytes, unsigned char size)
+{
+    unsigned char i;
+
+    for (i = 0; i < size; i++) {
+        UCB0RXBUF = bytes[i];
+        UCB0IV = USCI_I2C_UCRXIFG0;
+        USCI_B0_ISR();
+    }
+}
+
+// The frames posted since the last call, at most `max`
+static int frames(i2c_frame_t *out, int max)
+{
+    event_t event;
+    int n = 0;
+
+    while (event_get(&event)) {
+        if (event.type == EVENT_FRAME && n < max) {
+            memcpy(&out[n++], event.data, sizeof(out[0]));
+        }
+    }
+    return n;
+}
+
+int main(void)
+{
+    static const unsigned char window[3] = { 0xE7, 0x03, 2 };
+    static const unsigned char key = '5';
+    unsigned char frame[FRAME_MAX_SIZE], size;
+    i2c_frame_t got[4];
+    bool ok;
+    int i;
+
+    i2c_slave_init(0x68);
+    ok = (UCB0I2COA0 == (0x68 | UCOAEN)) && (UCB0CTLW0 & UCMODE_3) == UCMODE_3 && !(UCB0CTLW0 & UCSWRST) &&
+         (UCB0IE & (UCSTTIE | UCRXIE)) == (UCSTTIE | UCRXIE) && (P1SEL0 & (BIT2 | BIT3)) == (BIT2 | BIT3);
+    report("init answers at the address with its pins", ok);
+
+    size = i2c_frame_encode(frame, FRAME_OP_SET_WINDOW, window, sizeof(window));
+    for (i = 0; i < 3; i++) {
+        start();
+        receive(frame, size);
+    }
+    ok = frames(got, 4) == 3 && got[2].opcode == FRAME_OP_SET_WINDOW && got[2].length == 3 &&
+         memcmp(got[2].payload, window, 3) == 0;
+    report("each good frame posts one EVENT_FRAME", ok);
+
+    frame[size - 1] ^= 0x01;
+    start();
+    receive(frame, size);
+    start();
+    receive(frame, size - 2);
+    ok = frames(got, 4) == 0;
+    report("a bad CRC or a short frame posts nothing", ok);
+
+    start();
+    receive((const unsigned char *)"\x07\x05\x01", 3);
+    size = i2c_frame_encode(frame, FRAME_OP_KEY, &key, 1);
+    start();
+    receive(frame, size);
+    ok = frames(got, 4) == 1 && got[0].opcode == FRAME_OP_KEY && got[0].payload[0] == key;
+    report("a START resynchronises after garbage", ok);
+
+    return failures != 0;
+}
@@ -0,0 +1,153 @@
+/**
+ * @file
+ * @brief Host test for the binary code modulation brightness driver.
+ *
+ * Counts TB1R up one SMCLK tick at a time, calls the slot ISR on each
+ * compare, and reads every bar LED back from the port bits to measure its
+ * on-time per frame. Checks that each brightness level gives exactly
+ * level / LED_BCM_LEVELS of the frame, that a frame costs LED_BCM_BITS
+ * interrupts, that a change made mid-frame only shows from the next
+ * frame, and that an on/off frame stops the slots.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon -Ii2c-led-bar/src i2c-led-bar/test/led_bcm_host_test.c \
+ *       i2c-led-bar/src/led_bcm.c common/host/msp430_host.c -o led_bcm_test && ./led_bcm_test
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "intrinsics.h"
+#include "led_bcm.h"
+#include "host_test.h"
+
+#define FRAME_TICKS     (LED_BCM_UNIT * LED_BCM_MAX)
+
+void ISR_TB1_CCR0(void);
+
+static unsigned long interrupts;
+static unsigned long on_ticks[LED_BCM_LEDS];    // In the frame being measured
+
+// The bar as the port shows it: LEDs 2 and 3 are on P2.6 and P2.7
+static unsigned char bar(void)
+{
+    return (P1OUT & 0xF3) | ((P2OUT >> 4) & 0x0C);
+}
+
+static void show(const unsigned char *levels)
+{
+    unsigned char i;
+
+    for (i = 0; i < LED_BCM_LEDS; i++) {
+        led_bcm_frame[i] = levels[i];
+    }
+    led_bcm_show();
+}
+
+static void tick(void)
+{
+    TB1R++;
+    if ((TB1CCTL0 & CCIE) && TB1R == TB1CCR0) {
+        interrupts++;
+        ISR_TB1_CCR0();
+    }
+}
+
+// The slots run continuously from the first led_bcm_show(), so every
+// LED_BCM_BITS-th interrupt starts a frame. Run until one has.
+static void sync(void)
+{
+    unsigned long start = interrupts;
+
+    do {
+        tick();
+    } while (interrupts == start || interrupts % LED_BCM_BITS != 1);
+}
+
+// Measure one frame from its start; show `next` `change_at` ticks in
+static void run_frame(unsigned long change_at, const unsigned char *next)
+{
+    unsigned long start = interrupts, ticks = 0;
+    unsigned char i, shown;
+
+    for (i = 0; i < LED_BCM_LEDS; i++) {
+        on_ticks[i] = 0;
+    }
+    while (interrupts - start < LED_BCM_BITS) {
+        if (next != 0 && ticks++ == change_at) {
+            show(next);
+        }
+        shown = bar();
+        for (i = 0; i < LED_BCM_LEDS; i++) {
+            on_ticks[i] += (shown >> i) & 1;
+        }
+        tick();
+    }
+}
+
+static bool frame_is(const unsigned char *levels)
+{
+    unsigned char i;
+
+    for (i = 0; i < LED_BCM_LEDS; i++) {
+        if (on_ticks[i] != levels[i] * LED_BCM_UNIT) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    unsigned char levels[LED_BCM_LEDS], other[LED_BCM_LEDS];
+    unsigned long before;
+    unsigned int level, n;
+    unsigned char i;
+    bool ok = true, counted = true;
+
+    led_bcm_init();
+
+    // Every level, eight at a time
+    for (level = 0; level < LED_BCM_LEVELS && ok; level += LED_BCM_LEDS) {
+        for (i = 0; i < LED_BCM_LEDS; i++) {
+            levels[i] = (unsigned char)(level + i);
+        }
+        show(levels);
+        sync();
+        before = interrupts;
+        for (n = 0; n < 4 && ok; n++) {
+            run_frame(0, 0);
+            ok = frame_is(levels);
+        }
+        counted = counted && interrupts - before == 4 * LED_BCM_BITS;
+    }
+    report("every level gets exactly its share of the frame", ok);
+    report("one interrupt per bit per frame", counted);
+
+    // A change at any point in a frame only shows from the next one
+    ok = true;
+    for (n = 0; n < 200 && ok; n++) {
+        for (i = 0; i < LED_BCM_LEDS; i++) {
+            other[i] = (unsigned char)((n * 7 + i * 5) % LED_BCM_LEVELS);
+        }
+        sync();
+        run_frame((n * 997UL) % FRAME_TICKS, other);
+        ok = frame_is(levels);
+        run_frame(0, 0);
+        ok = ok && frame_is(other);
+        for (i = 0; i < LED_BCM_LEDS; i++) {
+            levels[i] = other[i];
+        }
+    }
+    report("mid-frame changes wait for the next frame", ok);
+
+    // Only 0 and full: straight to the port, no slot interrupts
+    for (i = 0; i < LED_BCM_LEDS; i++) {
+        levels[i] = (i & 1) ? LED_BCM_MAX : 0;
+    }
+    show(levels);
+    report("on/off frame is written directly, slots off", !(TB1CCTL0 & CCIE) && bar() == 0xAA);
+
+    printf("  %d-bit, %d Hz frames: %lu us shortest slot, %d interrupts per frame\n", LED_BCM_BITS,
+           LED_BCM_HZ, LED_BCM_UNIT * 1000000UL / CLOCK_SMCLK_HZ, LED_BCM_BITS);
+    return failures;
+}
@@ -0,0 +1,266 @@
+/**
+ * @file
+ * @brief Host test for the table-driven LED bar patterns.
+ *
+ * Replays long random runs of pattern selections and timer ticks through
+ * led_pattern.c and through a copy of the switch-based led_patterns() it
+ * replaced, and checks that the bar and the step period always agree (the
+ * old code wrote it to TB1CCR0, the tables set the step timer). On/off
+ * patterns must reach the port directly, without brightness slots; the
+ * comet, which the old code did not have, is checked for its tail, and a
+ * saved pattern is checked to resume where it was.
+ *
+ * The copy is the old code verbatim except for the lines marked FIX: the
+ * old code only saved a pattern's position when it stepped, so a pattern
+ * selected and left before its first tick later resumed at 0 (and the
+ * shifting patterns then stuck at 0). Both now resume at the first step.
+ * The copied code draws -Wsequence-point warnings; it is left as it was.
+ *
+ * Build and run from the repository root:
+ *   gcc -Icommon/host -Icommon -Ii2c-led-bar/src i2c-led-bar/test/led_pattern_host_test.c \
+ *       i2c-led-bar/src/led_pattern.c i2c-led-bar/src/led_bcm.c common/timer.c common/host/msp430_host.c \
+ *       -o led_pattern_test && ./led_pattern_test
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include <stdio.h>
+#include "led_pattern.h"
+#include "led_bcm.h"
+#define HOST_TEST_SEED 2025
+#include "host_test.h"
+
+//------------------------------------------------------------------------------
+// Reference: led_patterns() from i2c-led-bar/app/main.c before the tables
+//------------------------------------------------------------------------------
+#define ledOff 0
+#define ledPattern01_init 0b10101010
+#define ledPattern02_init 0
+#define ledPattern03_init 0b00011000
+#define ledPattern04_init 0xFF
+#define ledPattern05_init 0b00000001
+#define ledPattern06_init 0b01111111
+
+static bool new_input_bool = true;
+static bool pattern3_out = true;
+static char key_cur;
+static char key_prev = '\0';
+static int pattern1_cur, pattern2_cur, pattern3_cur, pattern4_cur, pattern5_cur, pattern6_cur;
+static bool pattern1_start, pattern2_start, pattern3_start, pattern4_start, pattern5_start,
+    pattern6_start;
+static unsigned char ledPattern_state;
+static unsigned int ref_ccr0;
+
+static void ref_led_patterns(char key_cur) 
+{
+    switch(key_cur)
+    {
+        case '0':           // Static state
+            ledPattern_state = ledPattern01_init;
+            break;
+        case '1':           // Toggle
+            ref_ccr0 = timing_base;
+            if (new_input_bool) {
+                if ((key_cur == key_prev | pattern1_start == false))
+                {
+                    ledPattern_state = ledPattern01_init;
+                    pattern1_start = true;
+                    pattern1_cur = ledPattern_state;    // FIX: resume here, not at 0
+                }
+                else
+                    ledPattern_state = pattern1_cur;
+                new_input_bool = false;
+            } else
+                ledPattern_state = pattern1_cur = (ledPattern_state ^= 0xFF);
+            break;
+        case '2':             // Up counter
+            ref_ccr0 = timing_base >> 1;
+            if (new_input_bool) {
+                if (key_cur == key_prev | pattern2_start == false)
+                {
+                    ledPattern_state = ledPattern02_init;
+                    pattern2_start = true;
+                    pattern2_cur = ledPattern_state;    // FIX: resume here, not at 0
+                }
+                else
+                    ledPattern_state = pattern2_cur;
+                new_input_bool = false;
+            } else
+                ledPattern_state = pattern2_cur = (++ledPattern_state);
+            break;
+        case '3':             // in and out
+            ref_ccr0 = timing_base >> 1;
+            if (new_input_bool) {
+                if (key_cur == key_prev | pattern3_start == false)
+                {
+                    ledPattern_state = ledPattern03_init;
+                    pattern3_start = true;
+                    pattern3_cur = ledPattern_state;    // FIX: resume here, not at 0
+                }
+                else
+                    ledPattern_state = pattern3_cur;
+                new_input_bool = false;
+            }
+            else if ((pattern3_out == true & ledPattern_state != 0b10000001) | (pattern3_out == false & ledPattern_state == 0b00011000))  // out
+            {
+                ledPattern_state = pattern3_cur = (ledPattern_state = ~ledPattern_state & ((0xF0 & ledPattern_state << 1) | (0xF & ledPattern_state >> 1) | ledPattern_state << 7 | ledPattern_state >> 7));
+                pattern3_out = true;
+            }
+            else if ((pattern3_out == false & ledPattern_state != 0b00011000) | (pattern3_out == true & ledPattern_state == 0b10000001))  // in
+            {
+                ledPattern_state = pattern3_cur = (ledPattern_state = ~ledPattern_state & ((0xF & ledPattern_state << 1) | (0xF0 & ledPattern_state >> 1) | ledPattern_state << 7 | ledPattern_state >> 7));
+                pattern3_out = false;
+            }
+            break;
+        case '4':             // down counter, extra credit
+            ref_ccr0 = timing_base >> 2;
+            if (new_input_bool) {
+                if (key_cur == key_prev | pattern4_start == false)
+                {
+                    ledPattern_state = ledPattern04_init;
+                    pattern4_start = true;
+                    pattern4_cur = ledPattern_state;    // FIX: resume here, not at 0
+                }
+                else
+                    ledPattern_state = pattern4_cur;
+                new_input_bool = false;
+            } else
+                ledPattern_state = pattern4_cur = (--ledPattern_state);
+            break;
+        case '5':             // rotate one left, extra credit
+            ref_ccr0 = timing_base + (timing_base >> 1);
+        if (new_input_bool) {
+            if (key_cur == key_prev | pattern5_start == false)
+                {
+                    ledPattern_state = ledPattern05_init;
+                    pattern5_start = true;
+                    pattern5_cur = ledPattern_state;    // FIX: resume here, not at 0
+                }
+            else
+                ledPattern_state = pattern5_cur;
+                new_input_bool = false;
+            } else
+                ledPattern_state = pattern5_cur = (ledPattern_state = ledPattern_state << 1 | ledPattern_state >> 7);
+            break;
+        case '6':             // rotate 7 right, extra credit
+            ref_ccr0 = timing_base >> 1;
+            if (new_input_bool) {
+                if (key_cur == key_prev | pattern6_start == false)
+                {
+                    ledPattern_state = ledPattern06_init;
+                    pattern6_start = true;
+                    pattern6_cur = ledPattern_state;    // FIX: resume here, not at 0
+                }
+                else
+                    ledPattern_state = pattern6_cur;
+                new_input_bool = false;
+            } else
+                ledPattern_state = pattern6_cur = (ledPattern_state = ledPattern_state >> 1 | ledPattern_state << 7);
+            break;
+        default:
+            ledPattern_state = ledOff;
+            break;
+    }
+}
+
+static void ref_select(char key)
+{
+    key_prev = key_cur;
+    key_cur = key;
+    new_input_bool = true;
+    ref_led_patterns(key_cur);
+}
+//--End Reference---------------------------------------------------------------
+
+// Both engines agree on the bar, its port bits and the timer period, and
+// no brightness slots run
+static bool same(void)
+{
+    return led_pattern_state() == ledPattern_state && P1OUT == ledPattern_state && !(TB1CCTL0 & CCIE) &&
+           (P2OUT & 0xC0) == ((ledPattern_state & 0x0C) << 4) && led_pattern_period() == ref_ccr0;
+}
+
+// Select `key`, then run `ticks` timer periods on both
+static bool run(char key, unsigned int ticks)
+{
+    unsigned int i;
+
+    led_pattern_select(key);
+    ref_select(key);
+    if (!same()) {
+        return false;
+    }
+    for (i = 0; i < ticks; i++) {
+        led_pattern_tick();
+        ref_led_patterns(key_cur);
+        if (!same()) {
+            return false;
+        }
+    }
+    return true;
+}
+
+int main(void)
+{
+    static const char keys[] = "0123456DA";
+    unsigned long n;
+    char p;
+    bool ok = true;
+
+    for (p = '0'; p <= '6'; p++) {
+        ok = ok && run(p, 600);         // Several full cycles, both counters wrap
+    }
+    report("every pattern steps like the old code", ok);
+
+    ok = run('2', 10) && run('5', 3) && run('2', 4) && run('2', 1) && run('D', 2) && run('5', 0);
+    report("resume and restart match", ok);
+
+    for (n = 0; ok && n < 200000; n++) {
+        char key = keys[rand_below(sizeof(keys) - 1)];
+
+        ok = run(key, rand_below(4) == 0 ? 0 : rand_below(40));
+        if (!ok) {
+            printf("  diverged at run %lu, key %c: new %02X, old %02X\n", n, key,
+                   led_pattern_state(), ledPattern_state);
+        }
+    }
+    report("200000 random selections match", ok);
+
+    // Comet: head at full brightness, each LED behind it at half the one
+    // before, after enough steps for any earlier pattern to have faded
+    led_pattern_select('7');
+    for (n = 0; n < 11; n++) {
+        led_pattern_tick();
+    }
+    ok = (TB1CCTL0 & CCIE) != 0;
+    for (n = 0; n < LED_BCM_LEDS; n++) {
+        ok = ok && led_bcm_frame[(3 - n) & 7] == (LED_BCM_MAX >> n);
+    }
+    led_pattern_select('0');
+    ok = ok && !(TB1CCTL0 & CCIE) && P1OUT == 0xAA;
+    report("comet tail halves per LED, slots stop after", ok);
+
+    // A reset between saving and restoring: the bar, its period and the
+    // next step carry on from where the saved pattern was
+    {
+        led_pattern_saved_t saved;
+        unsigned char bar;
+        unsigned long period;
+
+        led_pattern_select('5');
+        for (n = 0; n < 3; n++) {
+            led_pattern_tick();
+        }
+        bar = led_pattern_state();
+        period = led_pattern_period();
+        led_pattern_save(&saved);
+        led_pattern_select('2');
+        led_pattern_tick();
+        led_pattern_restore(&saved);
+        ok = led_pattern_state() == bar && led_pattern_period() == period;
+        led_pattern_tick();
+        ok = ok && led_pattern_state() == (unsigned char)(bar << 1);
+    }
+    report("restored pattern resumes at its saved step", ok);
+
+    return failures != 0;
+}
@@ -0,0 +1,24 @@
+#include <msp430.h>
+#include "bench.h"
+
+// Markers only: msp430_cycles watches for their addresses in the trace
+__attribute__((noinline)) void bench_begin(void)
+{
+    __asm__ volatile ("");
+}
+
+__attribute__((noinline)) void bench_end(void)
+{
+    __asm__ volatile ("");
+}
+
+__attribute__((interrupt)) void bench_empty_isr(void)
+{
+}
+
+// Harness cost with nothing to time, for a call and for an interrupt
+void bench_calibrate(void)
+{
+    BENCH("_overhead", 4, BENCH_NONE, BENCH_NONE);
+    BENCH("_isr_overhead", 4, BENCH_NONE, BENCH_ISR(bench_empty_isr));
+}
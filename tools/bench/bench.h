@@ -0,0 +1,42 @@
+/**
+ * @file
+ * @brief Benchmark harness for firmware code under msp430-elf-run.
+ *
+ * Each BENCH() prints "<name> <runs>" and then times every run separately:
+ * msp430_cycles counts the cycles of each instruction the simulator traces
+ * between bench_begin() and bench_end(). bench_calibrate() must run first;
+ * its empty runs are subtracted from everything else.
+ *
+ * Names starting with "isr_" are interrupt handlers started by BENCH_ISR(),
+ * reported from interrupt acceptance to the end of RETI.
+ */
+#ifndef BENCH_H
+#define BENCH_H
+
+#include <stdio.h>
+
+void bench_begin(void);
+void bench_end(void);
+void bench_calibrate(void);
+
+// Time `run` `runs` times, doing `setup` untimed before each
+#define BENCH(name, runs, setup, run)                   \
+    do {                                                \
+        unsigned int bench_i_;                          \
+        printf("%s %u\n", name, (unsigned int)(runs));  \
+        for (bench_i_ = 0; bench_i_ < (runs); bench_i_++) { \
+            setup;                                      \
+            bench_begin();                              \
+            run;                                        \
+            bench_end();                                \
+        }                                               \
+    } while (0)
+
+// Enter an interrupt handler as the CPU would: return address, then SR, on
+// the stack, so its RETI comes back here (small code model)
+#define BENCH_ISR(isr)                                  \
+    __asm__ volatile ("push #1f\n\tpush r2\n\tbr #" #isr "\n1:" ::: "memory")
+
+#define BENCH_NONE  ((void)0)
+
+#endif // BENCH_H
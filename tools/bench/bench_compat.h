@@ -0,0 +1,15 @@
+/**
+ * @file
+ * @brief Maps the TI compiler extensions used by the firmware onto
+ *        msp430-elf-gcc. Force-included by run_bench.sh.
+ */
+#ifndef BENCH_COMPAT_H
+#define BENCH_COMPAT_H
+
+#define __interrupt __attribute__((interrupt))
+
+#ifndef __even_in_range
+#define __even_in_range(x, y) (x)
+#endif
+
+#endif // BENCH_COMPAT_H
@@ -0,0 +1,106 @@
+/**
+ * @file
+ * @brief Controller (MSP430FR2355) benchmarks: keypad scan, LM19
+ *        conversion, I2C master and the ADC ISR.
+ *
+ * Built by run_bench.sh against controller/src; see README.md.
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include "bench.h"
+#include "keypad.h"
+#include "lm19.h"
+#include "master_i2c.h"
+#include "temperature.h"
+#include "i2c_frame.h"
+#include "timer.h"
+#include "telemetry.h"
+
+void ISR_TIMER_WHEEL(void);
+void EUSCI_B1_I2C_ISR(void);
+void ADC_ISR(void);
+void EUSCI_A1_UART_ISR(void);
+
+// Drain the I2C message queue the way the bus would, so the next send
+// finds room
+static void i2c_drain(void)
+{
+    while (master_i2c_busy()) {
+        UCB1IV = USCI_I2C_UCTXIFG0;
+        EUSCI_B1_I2C_ISR();
+        if (UCB1CTLW0 & UCTXSTP) {
+            UCB1CTLW0 &= ~UCTXSTP;
+            UCB1IV = USCI_I2C_UCSTPIFG;
+            EUSCI_B1_I2C_ISR();
+        }
+    }
+}
+
+// Send what the telemetry FIFO holds the way the UART would
+static void telemetry_drain(void)
+{
+    while (UCA1IE & UCTXIE) {
+        UCA1IV = USCI_UART_UCTXIFG;
+        EUSCI_A1_UART_ISR();
+    }
+}
+
+int main(void)
+{
+    static const unsigned char temperature[3] = { 234 & 0xFF, 234 >> 8, 'C' };
+    volatile int sink;
+    unsigned int code, i;
+
+    WDTCTL = WDTPW | WDTHOLD;
+    bench_calibrate();
+
+    // The simulator has no timers: set TB2R to the compare so the scan
+    // timer is due when the timer ISR runs
+    timer_init();
+    keypad_init();
+    BENCH("isr_keypad_idle", 8, (P6IN = 0x0F, TB2R = TB2CCR0), BENCH_ISR(ISR_TIMER_WHEEL));
+    BENCH("isr_keypad_scan", 8, (P6IN = 0x0E, TB2R = TB2CCR0), BENCH_ISR(ISR_TIMER_WHEEL));
+    P6IN = 0x0F;
+    for (code = 0; code < 2 * KEYPAD_DEBOUNCE; code++) {
+        keypad_debounce(0);         // Release everything again
+    }
+    BENCH("keypad_debounce_quiet", 8, BENCH_NONE, keypad_debounce(0));
+    BENCH("keypad_debounce_press", KEYPAD_DEBOUNCE, BENCH_NONE, keypad_debounce(0x0001));
+    BENCH("keypad_read_matrix", 8, BENCH_NONE, sink = keypad_read_matrix());
+
+    code = 0;
+    BENCH("lm19_centi_celsius", 32, code += 0x07FF, sink = lm19_centi_celsius(code));
+    BENCH("lm19_centi_fahrenheit", 8, BENCH_NONE, sink = lm19_centi_fahrenheit(2345));
+    BENCH("lm19_tenths", 8, BENCH_NONE, sink = lm19_tenths(-2345));
+
+    master_i2c_init();
+    BENCH("master_i2c_send_frame", 8, i2c_drain(),
+          master_i2c_send_frame(0x48, FRAME_OP_TEMPERATURE, temperature, sizeof(temperature)));
+    i2c_drain();
+    master_i2c_send_frame(0x48, FRAME_OP_TEMPERATURE, temperature, sizeof(temperature));
+    BENCH("isr_master_i2c_tx", sizeof(temperature) + FRAME_OVERHEAD + 1, UCB1IV = USCI_I2C_UCTXIFG0, BENCH_ISR(EUSCI_B1_I2C_ISR));
+    i2c_drain();
+
+    // Window-size independent: a large window costs what a small one does.
+    // Only the EMA filter pays for its 32-bit step in the ISR.
+    temperature_init();
+    temperature_set_window(TEMP_WINDOW_MAX, TEMP_FILTER_BOXCAR);
+    BENCH("isr_adc_sample", 2 * TEMP_WINDOW_MAX, (ADCIV = ADCIV_ADCIFG, ADCMEM0 = 0x0800 + (code++ & 0x3F)),
+          BENCH_ISR(ADC_ISR));
+    BENCH("temperature_average", 8, BENCH_NONE, temperature_average(&code));
+    BENCH("temperature_set_window", 8, BENCH_NONE, temperature_set_window(TEMP_WINDOW_MAX, TEMP_FILTER_EMA));
+    BENCH("isr_adc_sample_ema", TEMP_WINDOW_MAX, (ADCIV = ADCIV_ADCIFG, ADCMEM0 = 0x0800), BENCH_ISR(ADC_ISR));
+    BENCH("temperature_average_ema", 8, BENCH_NONE, temperature_average(&code));
+    temperature_set_window(TEMP_WINDOW_MAX, TEMP_FILTER_MEDIAN);
+    i = 0;
+    BENCH("isr_adc_sample_median", TEMP_WINDOW_MAX, (ADCIV = ADCIV_ADCIFG, ADCMEM0 = 0x0800 + (i++ * 37 & 0x3F)),
+          BENCH_ISR(ADC_ISR));
+    BENCH("temperature_average_median", 8, BENCH_NONE, temperature_average(&code));
+
+    telemetry_init();
+    BENCH("telemetry_send", 8, telemetry_drain(), telemetry_send(0x00012345UL, 0x0812, 0x8123, 2437));
+    BENCH("isr_telemetry_tx", TELEMETRY_RECORD_SIZE, UCA1IV = USCI_UART_UCTXIFG, BENCH_ISR(EUSCI_A1_UART_ISR));
+
+    (void)sink;
+    return 0;
+}
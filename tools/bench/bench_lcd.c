@@ -0,0 +1,91 @@
+/**
+ * @file
+ * @brief LCD slave (MSP430FR2310) benchmarks: drawing, flushing, the
+ *        queue drain ISR and the I2C receive path.
+ *
+ * The slave's app/main.c is linked in with its main() renamed, so
+ * display_output() and friends are the shipping code. Built by
+ * run_bench.sh; see README.md.
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include "bench.h"
+#include "event.h"
+#include "i2c_frame.h"
+#include "i2c_slave.h"
+#include "lcd.h"
+
+void display_output(char input);
+void show_temperature(int tenths, char unit);
+void frame_dispatch(const i2c_frame_t *frame);
+void ISR_TB0_CCR0(void);
+void USCI_B0_ISR(void);
+
+
+// Send everything queued, as the compare ISR and main loop would
+static void drain(void)
+{
+    event_t event;
+
+    while (TB0CCTL0 & CCIE || event_get(&event)) {
+        if (TB0CCTL0 & CCIE) {
+            ISR_TB0_CCR0();
+        } else if (event.type == EVENT_LCD_FLUSH) {
+            lcd_flush();
+        }
+    }
+}
+
+// Feed all but the last byte of `frame` to the I2C receive parser
+static void feed_partial(const unsigned char *frame, unsigned char size)
+{
+    unsigned char i;
+    event_t event;
+
+    while (event_get(&event)) {
+    }
+    i2c_frame_reset(&i2c_slave_rx);
+    for (i = 0; i + 1 < size; i++) {
+        i2c_frame_feed(&i2c_slave_rx, frame[i]);
+    }
+    UCB0RXBUF = frame[size - 1];
+    UCB0IV = USCI_I2C_UCRXIFG0;
+}
+
+int main(void)
+{
+    static const unsigned char payload[3] = { 234 & 0xFF, 234 >> 8, 'C' };
+    unsigned char frame[FRAME_MAX_SIZE];
+    unsigned char size = i2c_frame_encode(frame, FRAME_OP_TEMPERATURE, payload, sizeof(payload));
+    int tenths = 230;
+    i2c_frame_t parsed;
+
+    WDTCTL = WDTPW | WDTHOLD;
+    bench_calibrate();
+
+    lcd_init(false);
+    drain();
+    BENCH("lcd_print_line", 4, lcd_clear(), lcd_print("SET PATTERN     ", 0x00));
+    BENCH("lcd_flush_line", 4, (drain(), lcd_clear(), lcd_print("SET PATTERN     ", 0x00)), lcd_flush());
+    BENCH("lcd_flush_digit", 8, (drain(), lcd_put(0x44, '0' + (tenths++ & 7))), lcd_flush());
+    BENCH("lcd_flush_unchanged", 4, drain(), lcd_flush());
+    BENCH("show_temperature", 8, drain(), show_temperature(tenths++, 'C'));
+    BENCH("display_output_unlock", 4, drain(), display_output('Z'));
+    BENCH("display_output_digit", 4, drain(), display_output('5'));
+
+    drain();
+    lcd_clear();
+    lcd_flush();
+    BENCH("isr_lcd_drain", 16, BENCH_NONE, BENCH_ISR(ISR_TB0_CCR0));
+    drain();
+
+    BENCH("isr_i2c_rx_frame", 4, feed_partial(frame, size), BENCH_ISR(USCI_B0_ISR));
+    i2c_frame_reset(&i2c_slave_rx);
+    for (size = 0; size < FRAME_MAX_SIZE && !i2c_frame_feed(&i2c_slave_rx, frame[size]); size++) {
+    }
+    parsed = i2c_slave_rx.frame;
+    BENCH("frame_dispatch_temperature", 8, (drain(), parsed.payload[0] = tenths++),
+          frame_dispatch(&parsed));
+    drain();
+    return 0;
+}
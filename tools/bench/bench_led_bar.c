@@ -0,0 +1,81 @@
+/**
+ * @file
+ * @brief LED bar slave (MSP430FR2310) benchmarks: pattern steps, the
+ *        brightness slots and the timer and I2C receive ISRs.
+ *
+ * The slave's app/main.c is linked in with its main() renamed. Built by
+ * run_bench.sh; see README.md.
+ */
+#include <msp430.h>
+#include <stdbool.h>
+#include "bench.h"
+#include "event.h"
+#include "i2c_frame.h"
+#include "i2c_slave.h"
+#include "led_pattern.h"
+#include "led_bcm.h"
+#include "timer.h"
+
+void ISR_TIMER_WHEEL(void);
+void ISR_TB1_CCR0(void);
+void init_led_bar(void);
+void USCI_B0_ISR(void);
+
+
+static void events_clear(void)
+{
+    event_t event;
+
+    while (event_get(&event)) {
+    }
+}
+
+// Feed all but the last byte of `frame` to the I2C receive parser
+static void feed_partial(const unsigned char *frame, unsigned char size)
+{
+    unsigned char i;
+
+    events_clear();
+    i2c_frame_reset(&i2c_slave_rx);
+    for (i = 0; i + 1 < size; i++) {
+        i2c_frame_feed(&i2c_slave_rx, frame[i]);
+    }
+    UCB0RXBUF = frame[size - 1];
+    UCB0IV = USCI_I2C_UCRXIFG0;
+}
+
+int main(void)
+{
+    static const char *const names[LED_PATTERN_COUNT] = {
+        "led_pattern_tick_0", "led_pattern_tick_1", "led_pattern_tick_2", "led_pattern_tick_3",
+        "led_pattern_tick_4", "led_pattern_tick_5", "led_pattern_tick_6", "led_pattern_tick_7"
+    };
+    static const unsigned char key = '3';
+    unsigned char frame[FRAME_MAX_SIZE];
+    unsigned char size = i2c_frame_encode(frame, FRAME_OP_KEY, &key, 1);
+    unsigned char i;
+
+    WDTCTL = WDTPW | WDTHOLD;
+    bench_calibrate();
+    timer_init();
+    init_led_bar();                 // Starts the pattern step timer
+
+    for (i = 0; i < LED_PATTERN_COUNT; i++) {
+        led_pattern_select('0' + i);
+        BENCH(names[i], 8, BENCH_NONE, led_pattern_tick());
+    }
+    BENCH("led_pattern_select", 8, BENCH_NONE, led_pattern_select('0' + (i++ % LED_PATTERN_COUNT)));
+
+    led_pattern_select('7');        // Comet: a frame with in-between levels
+    led_pattern_tick();
+    led_pattern_tick();
+    BENCH("led_bcm_show", 8, BENCH_NONE, led_bcm_show());
+    BENCH("isr_bcm_slot", LED_BCM_BITS, BENCH_NONE, BENCH_ISR(ISR_TB1_CCR0));
+
+    // The simulator has no timers: set TB0R to the compare so the step
+    // timer is due when the timer ISR runs
+    BENCH("isr_pattern_timer", 4, (events_clear(), TB0R = TB0CCR0), BENCH_ISR(ISR_TIMER_WHEEL));
+    BENCH("isr_i2c_rx_byte", 4, feed_partial(frame, 1), BENCH_ISR(USCI_B0_ISR));
+    BENCH("isr_i2c_rx_frame", 4, feed_partial(frame, size), BENCH_ISR(USCI_B0_ISR));
+    return 0;
+}
@@ -0,0 +1,449 @@
+/**
+ * @file
+ * @brief Turns an msp430-elf-run instruction trace into per-benchmark cycle counts.
+ *
+ * The GDB simulator runs the code but does not report MSP430 cycle timing,
+ * so this tool replays its --trace-insn output through the MSP430X CPU
+ * instruction cycle tables (MSP430FR2xx/FR4xx family user's guide, SLAU445,
+ * "Instruction Cycles and Lengths"). FRAM wait states (common/clock.h
+ * sets them above 8 MHz) are not added: the FRAM cache hides most of them
+ * in loops, so at 16 or 24 MHz the counts are a lower bound.
+ *
+ * Every instruction between an entry to bench_begin() and the next entry to
+ * bench_end() belongs to one timed run. The benchmark program prints one
+ * "<name> <runs>" line per benchmark, in order, and runs are assigned to
+ * names in that order. The runs named _overhead and _isr_overhead measure the
+ * harness itself and are subtracted; see bench.h.
+ *
+ * Usage: msp430_cycles <trace> <names> <bench_begin addr> <bench_end addr> <prefix>
+ * Prints "<prefix>/<name> <runs> <min> <avg> <max>" per benchmark.
+ *
+ * Build:
+ *   gcc -O2 tools/bench/msp430_cycles.c -o msp430_cycles
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define MAX_BENCH   64
+#define MAX_LINE    512
+
+// Interrupt acceptance and RETI, which a run started by BENCH_ISR() replaces
+// with its own push/branch and which are added back after calibration
+#define ISR_ENTRY_CYCLES    6
+#define RETI_CYCLES         5
+
+typedef struct
+{
+    char name[64];
+    unsigned long runs;             // Runs announced by the program
+    unsigned long seen;             // Runs found in the trace
+    unsigned long min, max, total;
+} bench_t;
+
+typedef enum { M_REG, M_PC, M_CG, M_IND, M_INC, M_IMM, M_IDX, M_SYM, M_ABS } addr_mode_t;
+
+static unsigned long unknown;       // Instructions timed as 1 cycle, unrecognised
+
+//------------------------------------------------------------------------------
+// Begin Operand Modes
+//------------------------------------------------------------------------------
+static int is_pc(const char *s)
+{
+    return strcmp(s, "pc") == 0 || strcmp(s, "r0") == 0;
+}
+
+static int is_reg(const char *s)
+{
+    if (strcmp(s, "pc") == 0 || strcmp(s, "sp") == 0 || strcmp(s, "sr") == 0 || strcmp(s, "cg") == 0) {
+        return 1;
+    }
+    return s[0] == 'r' && isdigit((unsigned char)s[1]) && (s[2] == '\0' || (isdigit((unsigned char)s[2]) && s[3] == '\0'));
+}
+
+// Immediates the constant generators supply cost the same as a register
+static int is_cg_constant(const char *s)
+{
+    long v = strtol(s, NULL, 0);
+
+    return v == 0 || v == 1 || v == 2 || v == 4 || v == 8 || v == -1 || v == 0xFFFF || v == 0xFFFFF;
+}
+
+static addr_mode_t operand_mode(const char *s)
+{
+    if (s[0] == '#') {
+        return is_cg_constant(s + 1) ? M_CG : M_IMM;
+    }
+    if (s[0] == '@') {
+        return strchr(s, '+') ? M_INC : M_IND;
+    }
+    if (s[0] == '&') {
+        return M_ABS;
+    }
+    if (is_reg(s)) {
+        return is_pc(s) ? M_PC : M_REG;
+    }
+    if (strchr(s, '(')) {
+        return M_IDX;
+    }
+    return M_SYM;
+}
+
+static int is_memory(addr_mode_t m)
+{
+    return m == M_IDX || m == M_SYM || m == M_ABS;
+}
+//--End Operand Modes-----------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Cycle Tables
+//------------------------------------------------------------------------------
+// Format I (two operands), MSP430X CPU
+static unsigned int format1(addr_mode_t src, addr_mode_t dst, int mov_bit_cmp)
+{
+    unsigned int cycles;
+    int dst_mem = is_memory(dst);
+
+    switch (src) {
+    case M_REG:
+    case M_CG:
+        cycles = dst == M_PC ? 3 : dst_mem ? 4 : 1;
+        break;
+    case M_IND:
+    case M_INC:
+        cycles = dst == M_PC ? 4 : dst_mem ? 5 : 2;
+        break;
+    case M_IMM:
+        cycles = dst == M_PC ? 3 : dst_mem ? 5 : 2;
+        break;
+    default:                        // x(Rn), EDE, &EDE
+        cycles = dst == M_PC ? 5 : dst_mem ? 6 : 3;
+        break;
+    }
+    if (dst_mem && mov_bit_cmp) {
+        cycles--;                   // MOV, BIT and CMP skip the write back
+    }
+    return cycles;
+}
+
+// Format II (one operand), MSP430X CPU
+static unsigned int format2(const char *op, addr_mode_t m)
+{
+    int push = strcmp(op, "push") == 0;
+    int call = strcmp(op, "call") == 0;
+
+    switch (m) {
+    case M_REG:
+    case M_PC:
+        return call ? 4 : push ? 3 : 1;
+    case M_CG:
+    case M_IMM:
+    case M_IND:
+    case M_INC:
+        return call ? 4 : 3;
+    case M_ABS:
+        return call ? 6 : 4;
+    default:
+        return call ? 5 : 4;
+    }
+}
+//--End Cycle Tables------------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Instruction Timing
+//------------------------------------------------------------------------------
+static const char *const format1_ops[] = {
+    "mov", "add", "addc", "subc", "sub", "cmp", "dadd", "bit", "bic", "bis", "xor", "and", 0
+};
+static const char *const jumps[] = {
+    "jne", "jnz", "jeq", "jz", "jnc", "jlo", "jc", "jhs", "jn", "jge", "jl", "jmp", 0
+};
+// Emulated instructions whose only operand is the destination and whose
+// source comes from the constant generator
+static const char *const cg_ops[] = {
+    "clr", "inc", "incd", "dec", "decd", "adc", "dadc", "sbc", "inv", "tst", 0
+};
+static const char *const implied_ops[] = {
+    "nop", "dint", "eint", "clrc", "setc", "clrz", "setz", "clrn", "setn", 0
+};
+
+static int in_list(const char *op, const char *const *list)
+{
+    for (; *list; list++) {
+        if (strcmp(op, *list) == 0) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Cycles for one disassembled instruction. `op` is lower case without its
+// .b/.w/.a suffix; `x` is set for the MSP430X extended forms (movx etc).
+static unsigned int instruction_cycles(const char *op, int x, char operand[][64], int count)
+{
+    addr_mode_t a = count > 0 ? operand_mode(operand[0]) : M_REG;
+    addr_mode_t b = count > 1 ? operand_mode(operand[1]) : M_REG;
+    unsigned int extra = (x && (is_memory(a) || is_memory(b))) ? 1 : 0;
+
+    if (in_list(op, jumps)) {
+        return 2;
+    }
+    if (in_list(op, format1_ops) && count == 2) {
+        return format1(a, b, !strcmp(op, "mov") || !strcmp(op, "bit") || !strcmp(op, "cmp")) + extra;
+    }
+    if (in_list(op, cg_ops) && count == 1) {
+        return format1(M_CG, a, !strcmp(op, "clr") || !strcmp(op, "tst")) + extra;
+    }
+    if ((!strcmp(op, "rla") || !strcmp(op, "rlc")) && count == 1) {
+        return format1(a, a, 0) + extra;            // add dst, dst
+    }
+    if (!strcmp(op, "pop") && count == 1) {
+        return format1(M_INC, a, 1) + extra;        // mov @sp+, dst
+    }
+    if (!strcmp(op, "br") && count == 1) {
+        return format1(a, M_PC, 1);                 // mov src, pc
+    }
+    if (!strcmp(op, "ret")) {
+        return 4;                                   // mov @sp+, pc
+    }
+    if (!strcmp(op, "reti")) {
+        return RETI_CYCLES;
+    }
+    if (in_list(op, implied_ops)) {
+        return 1;
+    }
+    if ((!strcmp(op, "rrc") || !strcmp(op, "rra") || !strcmp(op, "swpb") || !strcmp(op, "sxt") ||
+         !strcmp(op, "push") || !strcmp(op, "call")) && count == 1) {
+        return format2(op, a) + extra;
+    }
+
+    // MSP430X address instructions
+    if ((!strcmp(op, "pushm") || !strcmp(op, "popm")) && count == 2) {
+        unsigned int n = (unsigned int)strtol(operand[0] + 1, NULL, 0);
+
+        return 2 + (x ? 2 * n : n);                 // .a pushes two words per register
+    }
+    if ((!strcmp(op, "rrcm") || !strcmp(op, "rram") || !strcmp(op, "rlam") || !strcmp(op, "rrum")) &&
+        count == 2) {
+        return (unsigned int)strtol(operand[0] + 1, NULL, 0);
+    }
+    if (!strcmp(op, "calla")) {
+        return a == M_ABS ? 7 : is_memory(a) || a == M_IND || a == M_INC ? 6 : 5;
+    }
+    if (!strcmp(op, "reta")) {
+        return 4;
+    }
+    if (!strcmp(op, "bra")) {
+        return a == M_REG || a == M_PC ? 3 : a == M_IMM || a == M_CG ? 3 : 5;
+    }
+    if (!strcmp(op, "mova") && count == 2) {
+        if (a == M_REG && b == M_REG) {
+            return 1;
+        }
+        if (a == M_IMM || a == M_CG) {
+            return 2;
+        }
+        if (a == M_IND || a == M_INC) {
+            return 3;
+        }
+        return 4;
+    }
+    if ((!strcmp(op, "adda") || !strcmp(op, "suba") || !strcmp(op, "cmpa")) && count == 2) {
+        return a == M_REG ? 1 : 2;
+    }
+
+    unknown++;
+    return 1;
+}
+//--End Instruction Timing------------------------------------------------------
+
+//------------------------------------------------------------------------------
+// Begin Trace Parsing
+//------------------------------------------------------------------------------
+// Find "<address> <mnemonic> <operands>" in a trace line, whatever prefix the
+// simulator puts in front. Returns 0 for lines that are not instructions.
+static int parse_line(char *line, unsigned long *address, char *op, int *x, char operand[][64], int *count)
+{
+    char *tok, *save, *rest;
+    char *semi = strchr(line, ';');
+    size_t n;
+
+    if (semi) {
+        *semi = '\0';               // Drop disassembler comments
+    }
+    for (tok = strtok_r(line, " \t\r\n", &save); tok; tok = strtok_r(NULL, " \t\r\n", &save)) {
+        char *end;
+        unsigned long value;
+        char *mnem, *dot;
+
+        n = strlen(tok);
+        if (n && tok[n - 1] == ':') {
+            tok[--n] = '\0';
+        }
+        value = strtoul(tok, &end, 16);
+        if (n < 4 || *end != '\0') {
+            continue;
+        }
+        mnem = strtok_r(NULL, " \t\r\n", &save);
+        if (!mnem) {
+            return 0;
+        }
+        // Skip opcode bytes some traces print between address and mnemonic
+        while (mnem && strlen(mnem) == 2 && isxdigit((unsigned char)mnem[0]) && isxdigit((unsigned char)mnem[1])) {
+            mnem = strtok_r(NULL, " \t\r\n", &save);
+        }
+        if (!mnem || !isalpha((unsigned char)mnem[0])) {
+            continue;
+        }
+        for (tok = mnem; *tok; tok++) {
+            *tok = (char)tolower((unsigned char)*tok);
+        }
+        dot = strchr(mnem, '.');
+        if (dot) {
+            *x = dot[1] == 'a' && (strncmp(mnem, "pushm", 5) == 0 || strncmp(mnem, "popm", 4) == 0);
+            *dot = '\0';
+        } else {
+            *x = 0;
+        }
+        n = strlen(mnem);
+        if (n > 3 && mnem[n - 1] == 'x' && strcmp(mnem, "sxt") != 0) {
+            mnem[n - 1] = '\0';     // movx, addx, ...: extended form
+            *x = 1;
+        }
+        strncpy(op, mnem, 15);
+        op[15] = '\0';
+
+        *count = 0;
+        rest = strtok_r(NULL, "", &save);
+        if (rest) {
+            char *o;
+
+            for (o = strtok_r(rest, ",", &save); o && *count < 2; o = strtok_r(NULL, ",", &save)) {
+                while (isspace((unsigned char)*o)) {
+                    o++;
+                }
+                n = strlen(o);
+                while (n && isspace((unsigned char)o[n - 1])) {
+                    o[--n] = '\0';
+                }
+                if (n) {
+                    for (tok = o; *tok; tok++) {
+                        *tok = (char)tolower((unsigned char)*tok);
+                    }
+                    strncpy(operand[*count], o, 63);
+                    operand[*count][63] = '\0';
+                    (*count)++;
+                }
+            }
+        }
+        *address = value;
+        return 1;
+    }
+    return 0;
+}
+//--End Trace Parsing-----------------------------------------------------------
+
+static bench_t *find(bench_t *list, int count, const char *name)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (strcmp(list[i].name, name) == 0) {
+            return &list[i];
+        }
+    }
+    return NULL;
+}
+
+int main(int argc, char **argv)
+{
+    static bench_t bench[MAX_BENCH];
+    char line[MAX_LINE];
+    char op[16], operand[2][64];
+    FILE *trace, *names;
+    unsigned long begin, end, address, cycles = 0;
+    int count = 0, current = 0, timing = 0, x, n, i;
+    bench_t *overhead, *isr_overhead;
+
+    if (argc != 6) {
+        fprintf(stderr, "usage: %s <trace> <names> <bench_begin addr> <bench_end addr> <prefix>\n", argv[0]);
+        return 2;
+    }
+    trace = fopen(argv[1], "r");
+    names = fopen(argv[2], "r");
+    if (!trace || !names) {
+        perror("msp430_cycles");
+        return 2;
+    }
+    begin = strtoul(argv[3], NULL, 16);
+    end = strtoul(argv[4], NULL, 16);
+
+    while (count < MAX_BENCH && fgets(line, sizeof(line), names)) {
+        if (sscanf(line, "%63s %lu", bench[count].name, &bench[count].runs) == 2) {
+            bench[count].min = (unsigned long)-1;
+            count++;
+        }
+    }
+
+    while (fgets(line, sizeof(line), trace)) {
+        if (!parse_line(line, &address, op, &x, operand, &n)) {
+            continue;
+        }
+        if (address == begin) {
+            timing = 1;
+            cycles = 0;
+        } else if (address == end && timing) {
+            bench_t *b;
+
+            timing = 0;
+            while (current < count && bench[current].seen == bench[current].runs) {
+                current++;
+            }
+            if (current == count) {
+                fprintf(stderr, "msp430_cycles: more timed runs than announced\n");
+                return 2;
+            }
+            b = &bench[current];
+            b->seen++;
+            b->total += cycles;
+            if (cycles < b->min) {
+                b->min = cycles;
+            }
+            if (cycles > b->max) {
+                b->max = cycles;
+            }
+        }
+        if (timing) {
+            cycles += instruction_cycles(op, x, operand, n);
+        }
+    }
+
+    overhead = find(bench, count, "_overhead");
+    isr_overhead = find(bench, count, "_isr_overhead");
+    for (i = 0; i < count; i++) {
+        bench_t *b = &bench[i];
+        unsigned long sub = 0, add = 0;
+
+        if (b->name[0] == '_') {
+            continue;
+        }
+        if (b->seen != b->runs || b->seen == 0) {
+            fprintf(stderr, "msp430_cycles: %s: %lu of %lu runs in the trace\n", b->name, b->seen, b->runs);
+            return 2;
+        }
+        if (strncmp(b->name, "isr_", 4) == 0 && isr_overhead && isr_overhead->seen) {
+            // Empty ISR run = harness + RETI; report acceptance to RETI done
+            sub = isr_overhead->min;
+            add = ISR_ENTRY_CYCLES + RETI_CYCLES;
+        } else if (overhead && overhead->seen) {
+            sub = overhead->min;
+        }
+        printf("%s/%s %lu %lu %lu %lu\n", argv[5], b->name, b->runs, b->min - sub + add,
+               b->total / b->runs - sub + add, b->max - sub + add);
+    }
+    if (unknown) {
+        fprintf(stderr, "msp430_cycles: %lu instructions not in the cycle tables, counted as 1\n", unknown);
+    }
+    return 0;
+}
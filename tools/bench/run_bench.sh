@@ -0,0 +1,77 @@
+#!/bin/sh
+# Build the firmware benchmarks with msp430-elf-gcc, run them under
+# msp430-elf-run and compare the cycle counts against baseline.txt.
+#
+# Usage, from anywhere:
+#   tools/bench/run_bench.sh            compare, exit 1 on a regression
+#   tools/bench/run_bench.sh --update   record the current counts as the baseline
+#
+# Needs msp430-elf-gcc, msp430-elf-run and msp430-elf-nm on PATH (TI's
+# MSP430-GCC package, built with the GDB simulator). MSP430_INC overrides
+# the directory holding msp430.h and the device linker scripts.
+set -e
+
+BENCH=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$BENCH/../.." && pwd)
+OUT=${BENCH_OUT:-$ROOT/_bench}
+MSP430_INC=${MSP430_INC:-$(dirname "$(command -v msp430-elf-gcc)")/../include}
+CFLAGS="-O2 -msim -I$MSP430_INC -L$MSP430_INC -I$BENCH -I$ROOT/common -include bench_compat.h -Wno-unknown-pragmas"
+
+mkdir -p "$OUT"
+gcc -O2 "$BENCH/msp430_cycles.c" -o "$OUT/msp430_cycles"
+
+# bench <name> <mcu> <driver> <app main.c or -> <sources...>
+bench() {
+    name=$1 mcu=$2 driver=$3 app=$4
+    shift 4
+    dir=$OUT/$name
+    rm -rf "$dir"
+    mkdir -p "$dir"
+    for src in "$BENCH/bench.c" "$BENCH/$driver" "$@"; do
+        msp430-elf-gcc -mmcu=$mcu $CFLAGS -I"$ROOT/$name/src" -c "$src" -o "$dir/$(basename "$src" .c).o"
+    done
+    if [ "$app" != - ]; then
+        msp430-elf-gcc -mmcu=$mcu $CFLAGS -I"$ROOT/$name/src" -Dmain=app_main -c "$app" -o "$dir/app_main.o"
+    fi
+    msp430-elf-gcc -mmcu=$mcu $CFLAGS "$dir"/*.o -o "$dir/bench.elf"
+
+    msp430-elf-run --trace-insn=on --trace-file="$dir/trace.txt" "$dir/bench.elf" > "$dir/names.txt"
+    begin=$(msp430-elf-nm "$dir/bench.elf" | awk '$3 == "bench_begin" { print $1 }')
+    end=$(msp430-elf-nm "$dir/bench.elf" | awk '$3 == "bench_end" { print $1 }')
+    "$OUT/msp430_cycles" "$dir/trace.txt" "$dir/names.txt" "0x$begin" "0x$end" "$name" >> "$OUT/results.txt"
+}
+
+rm -f "$OUT/results.txt"
+bench controller msp430fr2355 bench_controller.c - \
+    "$ROOT/controller/src/keypad.c" "$ROOT/controller/src/lm19.c" "$ROOT/controller/src/master_i2c.c" \
+    "$ROOT/controller/src/temperature.c" "$ROOT/controller/src/power.c" "$ROOT/controller/src/rgb_led.c" \
+    "$ROOT/controller/src/telemetry.c" "$ROOT/controller/src/log.c" "$ROOT/common/i2c_frame.c" "$ROOT/common/timer.c" "$ROOT/common/clock.c"
+bench i2c-lcd msp430fr2310 bench_lcd.c "$ROOT/i2c-lcd/app/main.c" \
+    "$ROOT/i2c-lcd/src/lcd.c" "$ROOT/common/event.c" "$ROOT/common/i2c_frame.c" "$ROOT/common/i2c_slave.c" \
+    "$ROOT/common/persist.c" "$ROOT/common/clock.c"
+bench i2c-led-bar msp430fr2310 bench_led_bar.c "$ROOT/i2c-led-bar/app/main.c" \
+    "$ROOT/i2c-led-bar/src/led_pattern.c" "$ROOT/i2c-led-bar/src/led_bcm.c" "$ROOT/common/event.c" \
+    "$ROOT/common/i2c_frame.c" "$ROOT/common/i2c_slave.c" "$ROOT/common/timer.c" "$ROOT/common/persist.c" \
+    "$ROOT/common/clock.c"
+
+echo "benchmark                                   runs    min    avg    max"
+awk '{ printf "%-42s %5s %6s %6s %6s\n", $1, $2, $3, $4, $5 }' "$OUT/results.txt"
+
+if [ "$1" = --update ]; then
+    cp "$OUT/results.txt" "$BENCH/baseline.txt"
+    echo "baseline updated"
+    exit 0
+fi
+if [ ! -f "$BENCH/baseline.txt" ]; then
+    echo "no baseline.txt yet: run with --update first"
+    exit 1
+fi
+
+# A benchmark regresses when its average or worst case exceeds the
+# baseline; new benchmarks are listed but do not fail the run
+awk 'NR == FNR { avg[$1] = $4; max[$1] = $5; next }
+     !($1 in avg) { printf "NEW        %s\n", $1; next }
+     $4 > avg[$1] || $5 > max[$1] {
+         printf "REGRESSED  %s avg %s -> %s, max %s -> %s\n", $1, avg[$1], $4, max[$1], $5; bad = 1
+     }
+     END { exit bad }' "$BENCH/baseline.txt" "$OUT/results.txt" && echo "no regressions"
@@ -0,0 +1,36 @@
+/**
+ * @file
+ * @brief Generates the RGB LED gamma table used by controller/src/rgb_led.c.
+ *
+ * Maps an 8-bit colour component, as in a "#C43E1D" colour code, to a PWM
+ * compare value with out = max * (in / 255)^gamma, so equal steps in the
+ * colour code look like equal steps in brightness.
+ *
+ * Build and run from the repository root:
+ *   gcc tools/gamma_table_gen.c -lm -o gamma_table_gen && ./gamma_table_gen > controller/src/gamma_table.h
+ */
+#include <math.h>
+#include <stdio.h>
+
+#define GAMMA       2.2
+#define PWM_MAX     1023            // RGB_PWM_PERIOD - 1 in rgb_led.h
+
+int main(void)
+{
+    int i;
+
+    printf("/*\n");
+    printf(" * Colour component to RGB PWM compare value, generated by\n");
+    printf(" * tools/gamma_table_gen.c. Do not edit; rerun the generator instead.\n");
+    printf(" *\n");
+    printf(" * Entry i is %d * (i / 255)^%.1f, rounded.\n", PWM_MAX, GAMMA);
+    printf(" */\n");
+    printf("#define GAMMA_TABLE_MAX   %d\n", PWM_MAX);
+    printf("\n");
+    printf("static const unsigned int gamma_table[256] = {");
+    for (i = 0; i < 256; i++) {
+        printf("%s%4ld%s", i % 12 == 0 ? "\n    " : " ", lround(PWM_MAX * pow(i / 255.0, GAMMA)), i < 255 ? "," : "");
+    }
+    printf("\n};\n");
+    return 0;
+}
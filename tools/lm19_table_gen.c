@@ -0,0 +1,54 @@
+/**
+ * @file
+ * @brief Generates the LM19 lookup table used by controller/src/lm19.c.
+ *
+ * The LM19 datasheet gives the sensor output as a quadratic in
+ * temperature, V = -3.88e-6 T^2 - 1.15e-2 T + 1.8639 (V, degC), whose
+ * inverse is
+ *
+ *     T = -1481.96 + sqrt(2.1962e6 + (1.8639 - V) / 3.88e-6)
+ *
+ * The table holds that inverse in hundredths of a degree at evenly
+ * spaced ADC codes (12-bit, 3.3 V reference) across the whole code
+ * range. The firmware interpolates between neighbouring entries.
+ *
+ * Build and run from the repository root:
+ *   gcc tools/lm19_table_gen.c -lm -o lm19_table_gen && ./lm19_table_gen > controller/src/lm19_table.h
+ */
+#include <math.h>
+#include <stdio.h>
+
+#define VREF_MV         3300.0
+#define ADC_CODES       4096
+#define SEGMENT_SHIFT   11          // Q4 code bits per segment: 128 ADC codes
+#define SEGMENTS        (65536 >> SEGMENT_SHIFT)
+
+static double lm19_celsius(double mv)
+{
+    return -1481.96 + sqrt(2.1962e6 + (1.8639 - mv / 1000.0) / 3.88e-6);
+}
+
+int main(void)
+{
+    int i;
+
+    printf("/*\n");
+    printf(" * LM19 ADC code to temperature, generated by tools/lm19_table_gen.c.\n");
+    printf(" * Do not edit; rerun the generator instead.\n");
+    printf(" *\n");
+    printf(" * Entry i is the temperature in 0.01 degC at a Q4 (1/16 LSB) ADC code\n");
+    printf(" * of i << LM19_TABLE_SHIFT, 12-bit ADC against a %.1f V reference.\n", VREF_MV / 1000.0);
+    printf(" */\n");
+    printf("#define LM19_TABLE_SHIFT  %d\n", SEGMENT_SHIFT);
+    printf("#define LM19_TABLE_SIZE   %d\n", SEGMENTS + 1);
+    printf("\n");
+    printf("static const int lm19_table[LM19_TABLE_SIZE] = {");
+    for (i = 0; i <= SEGMENTS; i++) {
+        double code = (double)((long)i << SEGMENT_SHIFT) / 16.0;
+        double celsius = lm19_celsius(code * VREF_MV / ADC_CODES);
+
+        printf("%s%6ld%s", i % 8 == 0 ? "\n    " : " ", lround(celsius * 100.0), i < SEGMENTS ? "," : "");
+    }
+    printf("\n};\n");
+    return 0;
+}
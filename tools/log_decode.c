@@ -0,0 +1,102 @@
+/**
+ * @file
+ * @brief Prints the controller's log messages from a UART capture.
+ *
+ * Reads the same capture as tools/telemetry_decode.c, e.g.
+ *   stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 > telemetry.bin
+ * and prints each 'T' 'G' frame (controller/src/log.h) as its sequence
+ * number and the text controller/src/log_ids.h gives its ID, with the
+ * argument filled in. Telemetry records and temperature log frames in
+ * between are skipped.
+ *
+ * A summary goes to stderr: messages decoded, messages the controller
+ * dropped to a full ring (gaps in the 8-bit sequence number) and frames
+ * with a bad CRC.
+ *
+ * Build against the log_ids.h of the firmware that sent the capture, and
+ * run from the repository root:
+ *   gcc -Icontroller/src tools/log_decode.c -o log_decode && ./log_decode telemetry.bin
+ */
+#include <stdio.h>
+#include "log_ids.h"
+
+#define FRAME_BODY  4                   // seq, id, arg: LOG_FRAME_SIZE - 3
+
+#define LOG_FORMAT(id, format)  format,
+static const char *const formats[] = { LOG_MESSAGES(LOG_FORMAT) };
+#define LOG_COUNT   (sizeof(formats) / sizeof(formats[0]))
+
+static unsigned char crc8_update(unsigned char crc, unsigned char byte)
+{
+    int i;
+
+    crc ^= byte;
+    for (i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ 0x07) : (unsigned char)(crc << 1);
+    }
+    return crc;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *f;
+    unsigned char body[FRAME_BODY], crc, expect = 0;
+    unsigned long messages = 0, dropped = 0, bad = 0;
+    unsigned int arg;
+    int c, have_last = 0;
+    size_t i;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <capture file>\n", argv[0]);
+        return 2;
+    }
+    f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    // Scan for "TG"; anything else on the UART is skipped
+    while ((c = fgetc(f)) != EOF) {
+        if (c != 'T') {
+            continue;
+        }
+        if ((c = fgetc(f)) != 'G') {
+            if (c == 'T') {
+                ungetc(c, f);
+            }
+            continue;
+        }
+        if (fread(body, 1, FRAME_BODY, f) != FRAME_BODY || (c = fgetc(f)) == EOF) {
+            break;
+        }
+        crc = 0;
+        for (i = 0; i < FRAME_BODY; i++) {
+            crc = crc8_update(crc, body[i]);
+        }
+        if (crc != c) {
+            bad++;                      // Its gap shows up in the next sequence number
+            continue;
+        }
+
+        if (have_last) {
+            dropped += (unsigned char)(body[0] - expect);
+        }
+        expect = body[0] + 1;
+        have_last = 1;
+        messages++;
+
+        arg = (unsigned int)(body[2] | body[3] << 8);
+        printf("%3u ", body[0]);
+        if (body[1] < LOG_COUNT) {
+            printf(formats[body[1]], arg);
+            printf("\n");
+        } else {
+            printf("unknown message %u, argument %u\n", body[1], arg);
+        }
+    }
+    fclose(f);
+
+    fprintf(stderr, "%lu messages, %lu missing (%lu with a bad CRC)\n", messages, dropped, bad);
+    return messages == 0;
+}
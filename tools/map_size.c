@@ -0,0 +1,115 @@
+/**
+ * @file
+ * @brief Prints FRAM and RAM use from TI linker map files, and the change
+ *        between two builds.
+ *
+ * CCS writes a map next to each image, e.g. i2c-lcd/Debug/i2c-lcd.map.
+ * Its MEMORY CONFIGURATION table gives, per region of the linker command
+ * file (lnk_msp430fr2310.cmd, lnk_msp430fr2355.cmd), the length and the
+ * bytes used. With one map this prints that table for every region in
+ * use; with two it prints before, after and the difference, e.g. to size
+ * a change: build, copy the maps aside, apply the change, build again.
+ *
+ * Build and run from the repository root:
+ *   gcc tools/map_size.c -o map_size && ./map_size before/i2c-lcd.map i2c-lcd/Debug/i2c-lcd.map
+ */
+#include <stdio.h>
+#include <string.h>
+
+#define REGIONS_MAX 32
+
+typedef struct
+{
+    char name[32];
+    unsigned long length;
+    unsigned long used;
+} region_t;
+
+// Read the MEMORY CONFIGURATION table. Returns the number of regions, or
+// -1 if the file cannot be read or has no such table.
+static int read_map(const char *path, region_t *regions)
+{
+    FILE *f = fopen(path, "r");
+    char line[256];
+    unsigned long origin, length, used, unused;
+    int count = 0, in_table = 0;
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (strstr(line, "MEMORY CONFIGURATION")) {
+            in_table = 1;
+            continue;
+        }
+        if (!in_table || strncmp(line, "----", 4) == 0 || strstr(line, "origin")) {
+            continue;
+        }
+        if (line[0] != ' ' && line[0] != '\n' && line[0] != '\r') {
+            break;                      // Next section of the map
+        }
+        if (count < REGIONS_MAX && sscanf(line, " %31s %lx %lx %lx %lx", regions[count].name, &origin, &length,
+                                          &used, &unused) == 5) {
+            regions[count].length = length;
+            regions[count].used = used;
+            count++;
+        }
+    }
+    fclose(f);
+    if (!in_table) {
+        fprintf(stderr, "%s: no MEMORY CONFIGURATION table\n", path);
+        return -1;
+    }
+    return count;
+}
+
+static const region_t *find(const region_t *regions, int count, const char *name)
+{
+    int i;
+
+    for (i = 0; i < count; i++) {
+        if (strcmp(regions[i].name, name) == 0) {
+            return &regions[i];
+        }
+    }
+    return 0;
+}
+
+int main(int argc, char **argv)
+{
+    region_t before[REGIONS_MAX], after[REGIONS_MAX];
+    const region_t *old;
+    int n_before, n_after, i;
+
+    if (argc != 2 && argc != 3) {
+        fprintf(stderr, "usage: %s <map> | %s <before map> <after map>\n", argv[0], argv[0]);
+        return 2;
+    }
+    if ((n_after = read_map(argv[argc - 1], after)) < 0) {
+        return 2;
+    }
+    if (argc == 2) {
+        printf("%-16s %8s %8s %6s\n", "region", "used", "length", "use");
+        for (i = 0; i < n_after; i++) {
+            if (after[i].used != 0) {
+                printf("%-16s %8lu %8lu %5.1f%%\n", after[i].name, after[i].used, after[i].length,
+                       100.0 * after[i].used / after[i].length);
+            }
+        }
+        return 0;
+    }
+
+    if ((n_before = read_map(argv[1], before)) < 0) {
+        return 2;
+    }
+    printf("%-16s %8s %8s %8s %8s\n", "region", "before", "after", "change", "length");
+    for (i = 0; i < n_after; i++) {
+        old = find(before, n_before, after[i].name);
+        if (after[i].used != 0 || (old && old->used != 0)) {
+            printf("%-16s %8lu %8lu %+8ld %8lu\n", after[i].name, old ? old->used : 0UL, after[i].used,
+                   (long)after[i].used - (long)(old ? old->used : 0UL), after[i].length);
+        }
+    }
+    return 0;
+}
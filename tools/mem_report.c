@@ -0,0 +1,676 @@
+/**
+ * @file
+ * @brief Reports FRAM and RAM use per module and per symbol from a TI
+ *        linker map, and the worst-case stack depth from the compiler's
+ *        assembly output, and fails when a budget is exceeded.
+ *
+ * Memory: the map's MEMORY CONFIGURATION table gives each region's use
+ * (regions as in lnk_msp430fr2310.cmd, lnk_msp430fr2355.cmd); its SECTION
+ * ALLOCATION MAP lists every input section, e.g. "lcd.obj (.text:lcd_flush)",
+ * which is charged to its module (object file or library) and its symbol
+ * (the name after the section's last ':'), in the region holding its address.
+ *
+ * Stack: the compiler, run with --keep_asm, heads every function with
+ * "FUNCTION NAME" and "Local Frame Size" (arguments, locals and saved
+ * registers) comments. A function's depth is its frame plus the deepest
+ * of its calls, each with its return address: 2 bytes for CALL, 4 for
+ * CALLA. A call through a pointer may go to any function whose address is
+ * taken in the code ("#name" outside a call) unless the budget narrows it.
+ * A function ending in RETI is an ISR, entered with 4 bytes of PC and SR.
+ * ISRs do not nest unless they, or something they call, set GIE with EINT
+ * or an immediate BIS to SR; restoring a saved SR (timer.c's
+ * __bis_SR_register(sr & GIE)) is taken to restore the state on entry.
+ * The worst case is main, plus every ISR that nests, plus the deepest ISR
+ * that does not. Recursion cannot be bounded and fails the check.
+ *
+ * Budget file, one entry per line, '#' starts a comment:
+ *   <region> <bytes>            most of the region the map may show used
+ *   STACK <bytes>               most the worst-case depth may be
+ *   frame <function> <bytes>    frame of a function with no assembly, e.g.
+ *                               from the run-time library (else 0, warned)
+ *   calls <function> <targets>  the only targets of its pointer calls
+ * The depth is also checked against the .stack section the map reserves.
+ *
+ * Build and run from the repository root (tools/mem_report.sh does this
+ * for each firmware):
+ *   gcc tools/mem_report.c -o mem_report && ./mem_report -b i2c-lcd/mem_budget.txt \
+ *       i2c-lcd/Debug/i2c-lcd.map $(find i2c-lcd/Debug -name '*.asm')
+ */
+#include <ctype.h>
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+
+#define NAME_MAX        48
+#define REGIONS_MAX     64
+#define ITEMS_MAX       1024
+#define FUNCS_MAX       512
+#define EDGES_MAX       2048
+#define BUDGETS_MAX     16
+#define TOP_SYMBOLS     12
+#define ISR_ENTRY       4               // PC and SR pushed on interrupt
+#define UNVISITED       -1
+#define VISITING        -2
+
+typedef struct
+{
+    char name[NAME_MAX];
+    unsigned long origin;
+    unsigned long length;
+    unsigned long used;
+} region_t;
+
+typedef struct
+{
+    char module[NAME_MAX];
+    char symbol[NAME_MAX];
+    int region;
+    unsigned long size;
+} item_t;
+
+typedef struct
+{
+    char name[NAME_MAX];
+    int frame;                  // Bytes, -1 if unknown
+    int isr;                    // Ends in RETI
+    int enables;                // Sets GIE
+    int address_taken;          // "#name" outside a call
+    int indirect;               // Return bytes of a pointer call, 0 if none
+    int narrowed;               // Pointer call targets come from the budget
+    int depth;                  // Bytes, UNVISITED or VISITING while computing
+    int nests;                  // It or a callee sets GIE
+    int next;                   // Callee on the deepest path, -1 at a leaf
+} func_t;
+
+typedef struct
+{
+    int from;
+    int to;
+    int call;                   // Return address bytes
+} edge_t;
+
+typedef struct
+{
+    char name[NAME_MAX];
+    unsigned long bytes;
+} budget_t;
+
+static region_t regions[REGIONS_MAX];
+static int region_count;
+static item_t items[ITEMS_MAX];
+static int item_count;
+static unsigned long stack_reserved;
+
+static func_t funcs[FUNCS_MAX];
+static int func_count;
+static edge_t edges[EDGES_MAX];
+static int edge_count;
+static int recursive;
+
+static budget_t budgets[BUDGETS_MAX];
+static int budget_count;
+
+static void copy_name(char *out, const char *in, size_t length)
+{
+    if (length >= NAME_MAX) {
+        length = NAME_MAX - 1;
+    }
+    memcpy(out, in, length);
+    out[length] = '\0';
+}
+
+//----------------------------------------------------------------------
+// Begin Map
+//----------------------------------------------------------------------
+static int region_of(unsigned long address)
+{
+    int i;
+
+    for (i = 0; i < region_count; i++) {
+        if (address >= regions[i].origin && address - regions[i].origin < regions[i].length) {
+            return i;
+        }
+    }
+    return -1;
+}
+
+// Charge one input section, the text after its origin and length, e.g.
+// "event.obj (.bss:queue)", "rts430x_lc_rd_eabi.lib : boot.c.obj (.text:_c_int00)"
+// or "(.common:queue)" for a tentative definition, which has no module
+static void add_item(unsigned long origin, unsigned long size, const char *text)
+{
+    const char *open = strchr(text, '('), *close, *colon, *end;
+    item_t *item;
+    int i, region = region_of(origin);
+
+    if (size == 0 || region < 0 || !open || strstr(text, "--HOLE--")) {
+        return;
+    }
+    close = strchr(open, ')');
+    if (!close) {
+        return;
+    }
+    item = &items[item_count];
+    end = strchr(text, ':');
+    if (!end || end > open) {
+        end = open;
+    }
+    while (end > text && isspace((unsigned char)end[-1])) {
+        end--;
+    }
+    if (end == text) {
+        strcpy(item->module, "(common)");
+    } else {
+        copy_name(item->module, text, end - text);
+    }
+    for (colon = close; colon > open && *colon != ':'; colon--) {
+    }
+    if (colon > open) {
+        copy_name(item->symbol, colon + 1, close - colon - 1);
+    } else {
+        copy_name(item->symbol, open + 1, close - open - 1);
+    }
+    item->region = region;
+    item->size = size;
+
+    // A module's pieces of one symbol, e.g. .text:x and .text:_isr:x, are one
+    for (i = 0; i < item_count; i++) {
+        if (items[i].region == region && strcmp(items[i].module, item->module) == 0 &&
+            strcmp(items[i].symbol, item->symbol) == 0) {
+            items[i].size += size;
+            return;
+        }
+    }
+    if (item_count < ITEMS_MAX - 1) {
+        item_count++;
+    }
+}
+
+// Read the MEMORY CONFIGURATION table and the SECTION ALLOCATION MAP.
+// Returns 0, or -1 if the file cannot be read or has no memory table.
+static int read_map(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[512], section[NAME_MAX] = "";
+    unsigned long origin, length, used, unused;
+    int table = 0, header = 0, n;
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if (strstr(line, "MEMORY CONFIGURATION")) {
+            table = 1;
+            continue;
+        }
+        if (strstr(line, "SECTION ALLOCATION MAP")) {
+            table = 2;
+            continue;
+        }
+        if (table == 0 || strncmp(line, "----", 4) == 0 || strstr(line, "origin")) {
+            continue;
+        }
+        if (table == 1) {
+            if (line[0] != ' ' && line[0] != '\n' && line[0] != '\r') {
+                table = 0;              // Next section of the map
+            } else if (region_count < REGIONS_MAX &&
+                       sscanf(line, " %47s %lx %lx %lx %lx", regions[region_count].name, &origin, &length, &used,
+                              &unused) == 5) {
+                regions[region_count].origin = origin;
+                regions[region_count].length = length;
+                regions[region_count].used = used;
+                region_count++;
+            }
+            continue;
+        }
+
+        // An output section starts in column 0 and its input sections are
+        // indented; a long output section name has its figures on the next line
+        if (strncmp(line, "GLOBAL SYMBOLS", 14) == 0 || strncmp(line, "LINKER GENERATED", 16) == 0) {
+            table = 0;
+        } else if (!isspace((unsigned char)line[0])) {
+            n = sscanf(line, "%47s %*s %lx %lx", section, &origin, &length);
+            header = (n == 1);
+            if (n == 3 && strcmp(section, ".stack") == 0) {
+                stack_reserved = length;
+            }
+        } else if (header) {
+            header = 0;
+            if (sscanf(line, " %*s %lx %lx", &origin, &length) == 2 && strcmp(section, ".stack") == 0) {
+                stack_reserved = length;
+            }
+        } else if (sscanf(line, " %lx %lx %n", &origin, &length, &n) == 2) {
+            add_item(origin, length, line + n);
+        }
+    }
+    fclose(f);
+    if (region_count == 0) {
+        fprintf(stderr, "%s: no MEMORY CONFIGURATION table\n", path);
+        return -1;
+    }
+    return 0;
+}
+
+static int by_size(const void *a, const void *b)
+{
+    const item_t *x = a, *y = b;
+
+    return (x->size < y->size) - (x->size > y->size);
+}
+
+// Per region: the modules, largest first, and the largest symbols
+static void print_memory(void)
+{
+    item_t modules[ITEMS_MAX];
+    int r, i, j, count, shown;
+
+    qsort(items, item_count, sizeof(items[0]), by_size);
+    for (r = 0; r < region_count; r++) {
+        if (regions[r].used == 0) {
+            continue;
+        }
+        printf("%s: %lu of %lu bytes (%.1f%%)\n", regions[r].name, regions[r].used, regions[r].length,
+               100.0 * regions[r].used / regions[r].length);
+        if (regions[r].length <= 4) {
+            continue;                   // A vector or signature
+        }
+
+        count = 0;
+        for (i = 0; i < item_count; i++) {
+            if (items[i].region != r) {
+                continue;
+            }
+            for (j = 0; j < count && strcmp(modules[j].module, items[i].module) != 0; j++) {
+            }
+            if (j == count) {
+                modules[count] = items[i];
+                modules[count++].size = 0;
+            }
+            modules[j].size += items[i].size;
+        }
+        qsort(modules, count, sizeof(modules[0]), by_size);
+        for (i = 0; i < count; i++) {
+            printf("  %-40s %6lu\n", modules[i].module, modules[i].size);
+        }
+
+        printf("  largest symbols:\n");
+        for (i = 0, shown = 0; i < item_count && shown < TOP_SYMBOLS; i++) {
+            if (items[i].region == r) {
+                printf("    %-30s %-24s %6lu\n", items[i].symbol, items[i].module, items[i].size);
+                shown++;
+            }
+        }
+    }
+}
+//--End Map-------------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Call Graph
+//----------------------------------------------------------------------
+static int find_func(const char *name, int add)
+{
+    int i;
+
+    for (i = 0; i < func_count; i++) {
+        if (strcmp(funcs[i].name, name) == 0) {
+            return i;
+        }
+    }
+    if (!add) {
+        return -1;
+    }
+    if (func_count == FUNCS_MAX) {
+        fprintf(stderr, "more than %d functions\n", FUNCS_MAX);
+        exit(2);
+    }
+    memset(&funcs[func_count], 0, sizeof(funcs[0]));
+    copy_name(funcs[func_count].name, name, strlen(name));
+    funcs[func_count].frame = -1;
+    funcs[func_count].depth = UNVISITED;
+    funcs[func_count].next = -1;
+    return func_count++;
+}
+
+static void add_edge(int from, int to, int call)
+{
+    int i;
+
+    for (i = 0; i < edge_count; i++) {
+        if (edges[i].from == from && edges[i].to == to) {
+            if (edges[i].call < call) {
+                edges[i].call = call;
+            }
+            return;
+        }
+    }
+    if (edge_count < EDGES_MAX) {
+        edges[edge_count].from = from;
+        edges[edge_count].to = to;
+        edges[edge_count].call = call;
+        edge_count++;
+    }
+}
+
+// The identifier after '#' in an operand, e.g. "#persist_tick,r12"
+static int operand_name(const char *hash, char *name)
+{
+    size_t length = 0;
+
+    hash++;
+    while (isalnum((unsigned char)hash[length]) || hash[length] == '_' || hash[length] == '$') {
+        length++;
+    }
+    if (length == 0 || isdigit((unsigned char)hash[0])) {
+        return 0;
+    }
+    copy_name(name, hash, length);
+    return 1;
+}
+
+// Read one assembly file. Names found only as operands are added too:
+// address-taken functions and calls into files not given, e.g. the run-
+// time library; the latter keep an unknown frame.
+static int read_asm(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[512], mnemonic[16], name[NAME_MAX], *p, *operands;
+    int current = -1, args, autos, save, i, call, value;
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        if ((p = strstr(line, "FUNCTION NAME:")) != 0) {
+            if (sscanf(p + 14, "%47s", name) == 1) {
+                current = find_func(name, 1);
+            }
+            continue;
+        }
+        if (current < 0) {
+            continue;
+        }
+        if ((p = strstr(line, "Local Frame Size")) != 0) {
+            if (sscanf(strchr(p, ':') + 1, "%d Args + %d Auto + %d Save", &args, &autos, &save) == 3) {
+                funcs[current].frame = args + autos + save;
+            }
+            continue;
+        }
+        if (line[0] == ';' || !isspace((unsigned char)line[0]) ||
+            sscanf(line, " %15s", mnemonic) != 1 || mnemonic[0] == ';' || mnemonic[0] == '.') {
+            continue;
+        }
+        operands = line + strspn(line, " \t") + strlen(mnemonic);
+        if ((p = strchr(operands, ';')) != 0) {
+            *p = '\0';
+        }
+        for (i = 0; mnemonic[i]; i++) {
+            mnemonic[i] = (char)toupper((unsigned char)mnemonic[i]);
+        }
+
+        call = strcmp(mnemonic, "CALL") == 0 ? 2 : strcmp(mnemonic, "CALLA") == 0 ? 4 : 0;
+        p = strchr(operands, '#');
+        if (call != 0) {
+            if (p && operand_name(p, name)) {
+                add_edge(current, find_func(name, 1), call);
+            } else if (funcs[current].indirect < call) {
+                funcs[current].indirect = call;
+            }
+        } else if (strcmp(mnemonic, "RETI") == 0) {
+            funcs[current].isr = 1;
+        } else if (strcmp(mnemonic, "EINT") == 0) {
+            funcs[current].enables = 1;
+        } else if (strncmp(mnemonic, "BIS", 3) == 0 && p && strstr(operands, "SR")) {
+            if (sscanf(p + 1, "%i", &value) == 1 && (value & 0x08)) {
+                funcs[current].enables = 1;
+            }
+        } else if (p && operand_name(p, name)) {
+            // May be a function defined further on, or a variable
+            funcs[find_func(name, 1)].address_taken = 1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static int called(int f)
+{
+    int i;
+
+    for (i = 0; i < edge_count; i++) {
+        if (edges[i].to == f) {
+            return 1;
+        }
+    }
+    return 0;
+}
+
+// Drop names that were only ever operands, not functions: variables whose
+// address was taken. A function called but never defined stays, unknown.
+static void prune(void)
+{
+    int i;
+
+    for (i = 0; i < func_count; i++) {
+        if (funcs[i].frame < 0 && !called(i)) {
+            funcs[i].address_taken = 0;
+        }
+    }
+}
+
+// Deepest stack below and including `f`, in bytes
+static int depth(int f)
+{
+    func_t *func = &funcs[f];
+    int i, d, best = 0;
+
+    if (func->depth == VISITING) {
+        if (!recursive) {
+            fprintf(stderr, "recursion through %s: stack depth is unbounded\n", func->name);
+        }
+        recursive = 1;
+        return 0;
+    }
+    if (func->depth != UNVISITED) {
+        return func->depth;
+    }
+    func->depth = VISITING;
+    func->nests = func->enables;
+    for (i = 0; i < edge_count; i++) {
+        if (edges[i].from == f) {
+            d = edges[i].call + depth(edges[i].to);
+            funcs[f].nests |= funcs[edges[i].to].nests;
+            if (d > best) {
+                best = d;
+                funcs[f].next = edges[i].to;
+            }
+        }
+    }
+    if (func->indirect != 0 && !func->narrowed) {
+        for (i = 0; i < func_count; i++) {
+            if (funcs[i].address_taken) {
+                d = func->indirect + depth(i);
+                funcs[f].nests |= funcs[i].nests;
+                if (d > best) {
+                    best = d;
+                    funcs[f].next = i;
+                }
+            }
+        }
+    }
+    func->depth = (func->frame > 0 ? func->frame : 0) + best;
+    return func->depth;
+}
+
+static void print_path(int f)
+{
+    printf("    ");
+    for (; f >= 0; f = funcs[f].next) {
+        printf("%s(%d)%s", funcs[f].name, funcs[f].frame > 0 ? funcs[f].frame : 0, funcs[f].next >= 0 ? " > " : "\n");
+    }
+}
+
+// Returns the worst-case depth, or -1 if it cannot be bounded
+static int print_stack(void)
+{
+    int main_func = find_func("main", 0), deepest = -1, total, i, call = 2;
+
+    for (i = 0; i < edge_count; i++) {
+        if (edges[i].call > call) {
+            call = edges[i].call;   // The start-up code calls main the same way
+        }
+    }
+    for (i = 0; i < func_count; i++) {
+        if (funcs[i].frame < 0 && called(i)) {
+            fprintf(stderr, "warning: no frame for %s, taken as 0 (add a frame line)\n", funcs[i].name);
+        }
+    }
+    if (main_func < 0) {
+        fprintf(stderr, "no assembly for main: build with --keep_asm and pass the .asm files\n");
+        return -1;
+    }
+
+    total = call + depth(main_func);
+    printf("stack: main %d bytes\n", total);
+    print_path(main_func);
+    for (i = 0; i < func_count; i++) {
+        if (funcs[i].isr) {
+            depth(i);
+        }
+    }
+    for (i = 0; i < func_count; i++) {
+        if (!funcs[i].isr) {
+            continue;
+        }
+        printf("  ISR %s %d bytes%s\n", funcs[i].name, ISR_ENTRY + funcs[i].depth,
+               funcs[i].nests ? ", sets GIE: others may nest on it" : "");
+        if (funcs[i].nests) {
+            total += ISR_ENTRY + funcs[i].depth;
+        } else if (deepest < 0 || funcs[i].depth > funcs[deepest].depth) {
+            deepest = i;
+        }
+    }
+    if (deepest >= 0) {
+        total += ISR_ENTRY + funcs[deepest].depth;
+        printf("  deepest ISR %s:\n", funcs[deepest].name);
+        print_path(deepest);
+    }
+    printf("stack: worst case %d bytes with interrupts", total);
+    if (stack_reserved != 0) {
+        printf(", %lu reserved by the linker", stack_reserved);
+    }
+    printf("\n");
+    return recursive ? -1 : total;
+}
+//--End Call Graph------------------------------------------------------
+
+//----------------------------------------------------------------------
+// Begin Budget
+//----------------------------------------------------------------------
+// Read the budget file, applying its frame and calls lines to the call
+// graph. Returns 0, or -1 on an unreadable file or a bad line.
+static int read_budget(const char *path)
+{
+    FILE *f = fopen(path, "r");
+    char line[256], key[NAME_MAX], name[NAME_MAX], *p;
+    unsigned long bytes;
+    int number = 0, from, to, n;
+
+    if (!f) {
+        perror(path);
+        return -1;
+    }
+    while (fgets(line, sizeof(line), f)) {
+        number++;
+        if ((p = strchr(line, '#')) != 0) {
+            *p = '\0';
+        }
+        if (sscanf(line, "%47s", key) != 1) {
+            continue;
+        }
+        if (strcmp(key, "frame") == 0 && sscanf(line, "%*s %47s %lu", name, &bytes) == 2) {
+            funcs[find_func(name, 1)].frame = (int)bytes;
+        } else if (strcmp(key, "calls") == 0 && sscanf(line, "%*s %47s %n", name, &n) == 1) {
+            from = find_func(name, 1);
+            funcs[from].narrowed = 1;
+            for (p = line + n; sscanf(p, "%47s %n", name, &n) == 1; p += n) {
+                to = find_func(name, 1);
+                add_edge(from, to, funcs[from].indirect ? funcs[from].indirect : 4);
+            }
+        } else if (budget_count < BUDGETS_MAX && sscanf(line, "%*s %lu", &bytes) == 1) {
+            strcpy(budgets[budget_count].name, key);
+            budgets[budget_count++].bytes = bytes;
+        } else {
+            fprintf(stderr, "%s:%d: not understood\n", path, number);
+            fclose(f);
+            return -1;
+        }
+    }
+    fclose(f);
+    return 0;
+}
+
+static int check(const char *name, unsigned long used, unsigned long limit)
+{
+    printf("%-16s %8lu of %8lu %s\n", name, used, limit, used > limit ? "OVER BUDGET" : "ok");
+    return used <= limit;
+}
+//--End Budget----------------------------------------------------------
+
+int main(int argc, char **argv)
+{
+    const char *budget = 0;
+    int i, j, stack = 0, ok = 1, have_asm;
+
+    if (argc >= 3 && strcmp(argv[1], "-b") == 0) {
+        budget = argv[2];
+        argv += 2;
+        argc -= 2;
+    }
+    if (argc < 2) {
+        fprintf(stderr, "usage: %s [-b <budget>] <map> [<asm files>...]\n", argv[0]);
+        return 2;
+    }
+    if (read_map(argv[1]) < 0) {
+        return 2;
+    }
+    for (i = 2; i < argc; i++) {
+        if (read_asm(argv[i]) < 0) {
+            return 2;
+        }
+    }
+    have_asm = argc > 2;
+    prune();
+    if (budget && read_budget(budget) < 0) {
+        return 2;
+    }
+
+    print_memory();
+    if (have_asm) {
+        stack = print_stack();
+        ok = stack >= 0;
+        if (ok && stack_reserved != 0) {
+            ok = check(".stack reserved", (unsigned long)stack, stack_reserved);
+        }
+    }
+    for (i = 0; i < budget_count; i++) {
+        if (strcmp(budgets[i].name, "STACK") == 0) {
+            if (!have_asm) {
+                fprintf(stderr, "STACK budget not checked: no .asm files\n");
+            } else if (stack >= 0) {
+                ok &= check("STACK", (unsigned long)stack, budgets[i].bytes);
+            }
+            continue;
+        }
+        for (j = 0; j < region_count && strcmp(regions[j].name, budgets[i].name) != 0; j++) {
+        }
+        if (j == region_count) {
+            fprintf(stderr, "budget for %s: no such region in the map\n", budgets[i].name);
+            ok = 0;
+        } else {
+            ok &= check(regions[j].name, regions[j].used, budgets[i].bytes);
+        }
+    }
+    return ok ? 0 : 1;
+}
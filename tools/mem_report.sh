@@ -0,0 +1,40 @@
+#!/bin/sh
+# Report FRAM, RAM and worst-case stack use of each firmware against its
+# mem_budget.txt, from the map and assembly files CCS left in the build
+# directory (see tools/mem_report.c).
+#
+# Usage, from anywhere, after building the projects in CCS:
+#   tools/mem_report.sh                     every firmware, Debug build
+#   tools/mem_report.sh Release i2c-lcd     one firmware, another build
+#
+# Exits 1 if any firmware is over a budget, 2 if one could not be read.
+# The Debug configurations keep their assembly (--keep_asm), which the
+# stack depth needs; without it only the memory is reported.
+TOOLS=$(cd "$(dirname "$0")" && pwd)
+ROOT=$(cd "$TOOLS/.." && pwd)
+OUT=${MEM_REPORT_OUT:-$ROOT/_mem_report}
+CONFIG=${1:-Debug}
+[ $# -gt 0 ] && shift
+PROJECTS=${*:-controller i2c-lcd i2c-led-bar}
+
+mkdir -p "$OUT"
+gcc -O2 "$TOOLS/mem_report.c" -o "$OUT/mem_report" || exit 2
+
+status=0
+for project in $PROJECTS; do
+    build=$ROOT/$project/$CONFIG
+    echo "== $project ($CONFIG)"
+    if [ ! -f "$build/$project.map" ]; then
+        echo "no $build/$project.map: build the project first"
+        status=2
+        continue
+    fi
+    "$OUT/mem_report" -b "$ROOT/$project/mem_budget.txt" "$build/$project.map" \
+        $(find "$build" -name '*.asm' | sort)
+    result=$?
+    if [ $result -gt $status ]; then
+        status=$result
+    fi
+    echo
+done
+exit $status
@@ -0,0 +1,247 @@
+/**
+ * @file
+ * @brief Decodes the controller's temperature telemetry into CSV.
+ *
+ * Reads the raw bytes the controller streams from telemetry_send()
+ * (controller/src/telemetry.h), captured from the UART, e.g.
+ *   stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 > telemetry.bin
+ * and writes one CSV line per good record to stdout:
+ *   seq,time_s,raw,average_q4,celsius
+ * with average_q4 and celsius empty while the controller's window fills.
+ *
+ * A summary goes to stderr: records decoded, records the controller
+ * dropped (gaps in the sequence number), records lost to line errors (bad
+ * CRC, counted with the gap they leave) and controller restarts (the
+ * sequence back at 0 with time gone backwards), which are not gaps.
+ *
+ * With -l it decodes the temperature log export instead ('0' on the
+ * keypad, see controller/src/temp_log.h), one line per entry:
+ *   block,time_s,age_s,celsius,restart
+ * where age_s is how long before the export the entry was taken and
+ * restart is 1 on the first entry after a controller reset.
+ *
+ * Build and run from the repository root:
+ *   gcc tools/telemetry_decode.c -o telemetry_decode && ./telemetry_decode telemetry.bin > telemetry.csv
+ *   ./telemetry_decode -l telemetry.bin > log.csv
+ */
+#include <stdio.h>
+#include <string.h>
+
+#define RECORD_SIZE 15                  // TELEMETRY_RECORD_SIZE
+#define BODY_SIZE   (RECORD_SIZE - 3)   // seq to centi
+#define NO_AVERAGE  0xFFFF              // TELEMETRY_NO_AVERAGE
+#define ACLK_HZ     32768.0
+#define LOG_ENTRY_S 60                  // TEMP_LOG_ENTRY_S
+#define LOG_HEADER  11                  // seq to length
+#define LOG_MAX     8192                // Entries held until the 'T' 'E' frame
+
+static unsigned char crc8_update(unsigned char crc, unsigned char byte)
+{
+    int i;
+
+    crc ^= byte;
+    for (i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ 0x07) : (unsigned char)(crc << 1);
+    }
+    return crc;
+}
+
+static unsigned int get16(const unsigned char *p)
+{
+    return (unsigned int)(p[0] | p[1] << 8);
+}
+
+typedef struct
+{
+    unsigned int block;
+    unsigned long time;
+    int centi;
+    int restart;
+} log_entry_t;
+
+static log_entry_t log_entries[LOG_MAX];
+static unsigned long log_count;
+
+// Read `n` bytes into `out`, adding them to `crc`. Returns 0 at EOF.
+static int read_frame(FILE *f, unsigned char *out, size_t n, unsigned char *crc)
+{
+    size_t i;
+
+    if (fread(out, 1, n, f) != n) {
+        return 0;
+    }
+    for (i = 0; i < n; i++) {
+        *crc = crc8_update(*crc, out[i]);
+    }
+    return 1;
+}
+
+// One 'T' 'L' block: its entries are held until the export's end frame
+static int log_block(FILE *f, unsigned long *bad)
+{
+    unsigned char header[LOG_HEADER], data[256], crc = 0;
+    unsigned long zigzag, time;
+    unsigned int count, n, at = 0, shift;
+    int c, value;
+
+    if (!read_frame(f, header, LOG_HEADER, &crc) || !read_frame(f, data, header[LOG_HEADER - 1], &crc) ||
+        (c = fgetc(f)) == EOF) {
+        return 0;
+    }
+    if (crc != c) {
+        (*bad)++;
+        return 1;
+    }
+    time = get16(&header[2]) | (unsigned long)get16(&header[4]) << 16;
+    value = (short)get16(&header[6]);
+    count = header[8];
+    for (n = 0; n < count; n++) {
+        if (n > 0) {
+            zigzag = 0;
+            shift = 0;
+            do {
+                zigzag |= (unsigned long)(data[at] & 0x7F) << shift;
+                shift += 7;
+            } while ((data[at++] & 0x80) && at < header[LOG_HEADER - 1]);
+            value += (zigzag & 1) ? -(int)((zigzag + 1) >> 1) : (int)(zigzag >> 1);
+        }
+        if (log_count < LOG_MAX) {
+            log_entries[log_count].block = get16(&header[0]);
+            log_entries[log_count].time = time + n * LOG_ENTRY_S;
+            log_entries[log_count].centi = value;
+            log_entries[log_count].restart = n == 0 && (header[9] & 0x01);
+            log_count++;
+        }
+    }
+    return 1;
+}
+
+// The 'T' 'E' frame: print the export now the log clock is known
+static int log_end(FILE *f, unsigned long *bad, unsigned long *entries)
+{
+    unsigned char body[4], crc = 0;
+    unsigned long now, i;
+    int c;
+
+    if (!read_frame(f, body, sizeof(body), &crc) || (c = fgetc(f)) == EOF) {
+        return 0;
+    }
+    if (crc != c) {
+        (*bad)++;
+        log_count = 0;
+        return 1;
+    }
+    now = get16(&body[0]) | (unsigned long)get16(&body[2]) << 16;
+    for (i = 0; i < log_count; i++) {
+        printf("%u,%lu,%ld,%.2f,%d\n", log_entries[i].block, log_entries[i].time,
+               (long)(now - log_entries[i].time), log_entries[i].centi / 100.0, log_entries[i].restart);
+    }
+    *entries += log_count;
+    log_count = 0;
+    return 1;
+}
+
+static int decode_log(FILE *f)
+{
+    unsigned long bad = 0, entries = 0;
+    int c, ok = 1;
+
+    printf("block,time_s,age_s,celsius,restart\n");
+    while (ok && (c = fgetc(f)) != EOF) {
+        if (c != 'T') {
+            continue;
+        }
+        c = fgetc(f);
+        if (c == 'L') {
+            ok = log_block(f, &bad);
+        } else if (c == 'E') {
+            ok = log_end(f, &bad, &entries);
+        } else if (c == 'T') {
+            ungetc(c, f);
+        }
+    }
+    fprintf(stderr, "%lu log entries, %lu frames with a bad CRC%s\n", entries, bad,
+            log_count ? ", export incomplete" : "");
+    return entries == 0;
+}
+
+int main(int argc, char **argv)
+{
+    FILE *f;
+    unsigned char body[BODY_SIZE];
+    unsigned long records = 0, dropped = 0, bad = 0, restarts = 0;
+    unsigned long time, last_time = 0;
+    unsigned int seq, expect = 0, raw, average;
+    int c, have_last = 0, centi;
+    unsigned char crc;
+    size_t i;
+
+    int log = argc == 3 && strcmp(argv[1], "-l") == 0;
+
+    if (argc != 2 && !log) {
+        fprintf(stderr, "usage: %s [-l] <capture file>\n", argv[0]);
+        return 2;
+    }
+    f = fopen(argv[argc - 1], "rb");
+    if (!f) {
+        perror(argv[argc - 1]);
+        return 2;
+    }
+    if (log) {
+        c = decode_log(f);
+        fclose(f);
+        return c;
+    }
+
+    printf("seq,time_s,raw,average_q4,celsius\n");
+    // Scan for "TM" so line noise, or a trace dump on the same UART, is skipped
+    while ((c = fgetc(f)) != EOF) {
+        if (c != 'T') {
+            continue;
+        }
+        if ((c = fgetc(f)) != 'M') {
+            if (c == 'T') {
+                ungetc(c, f);
+            }
+            continue;
+        }
+        if (fread(body, 1, BODY_SIZE, f) != BODY_SIZE || (c = fgetc(f)) == EOF) {
+            break;
+        }
+        crc = 0;
+        for (i = 0; i < BODY_SIZE; i++) {
+            crc = crc8_update(crc, body[i]);
+        }
+        if (crc != c) {
+            bad++;                      // Its gap shows up in the next sequence number
+            continue;
+        }
+
+        seq = get16(&body[0]);
+        time = get16(&body[2]) | (unsigned long)get16(&body[4]) << 16;
+        raw = get16(&body[6]);
+        average = get16(&body[8]);
+        centi = (short)get16(&body[10]);
+        if (have_last && seq == 0 && time < last_time) {
+            restarts++;
+        } else if (have_last) {
+            dropped += (seq - expect) & 0xFFFF;
+        }
+        expect = (seq + 1) & 0xFFFF;
+        last_time = time;
+        have_last = 1;
+        records++;
+
+        printf("%u,%.4f,%u,", seq, time / ACLK_HZ, raw);
+        if (average == NO_AVERAGE) {
+            printf(",\n");
+        } else {
+            printf("%u,%.2f\n", average, centi / 100.0);
+        }
+    }
+    fclose(f);
+
+    fprintf(stderr, "%lu records, %lu missing (%lu with a bad CRC), %lu restarts\n", records, dropped, bad,
+            restarts);
+    return records == 0;
+}
@@ -0,0 +1,203 @@
+/**
+ * @file
+ * @brief Decodes an ISR trace dump (common/trace.h) into per-ISR timing.
+ *
+ * Reads the raw bytes a TRACE_ENABLE firmware sends from trace_dump(),
+ * captured from the UART, e.g.
+ *   stty -F /dev/ttyUSB0 115200 raw && cat /dev/ttyUSB0 > trace.bin
+ * The file may hold several dumps back to back (one per board).
+ *
+ * For each ISR it prints how many times it ran and the min/avg/max time
+ * from its entry to its exit trace point, with a histogram in powers of
+ * two microseconds, converted from stamp ticks with the ticks-per-us
+ * byte in the dump header. It also counts entries that arrived while
+ * another ISR was still open (nesting, or a missing exit) and entries
+ * within GAP_US of the previous ISR's exit, i.e. interrupts that were
+ * already pending and were delayed by the one before.
+ *
+ * Stamps are 12 bits of an SMCLK-rate counter, so the time between two
+ * neighbouring trace points must be under 4096 ticks (1.4 ms at 3 MHz)
+ * for them to be unwrapped correctly; ISR durations always are.
+ *
+ * Build and run from the repository root:
+ *   gcc tools/trace_decode.c -o trace_decode && ./trace_decode trace.bin
+ */
+#include <stdio.h>
+#include <stdlib.h>
+
+#define IDS         8
+#define MARK        7                   // TRACE_MARK
+#define EMPTY       0xFFFF              // TRACE_EMPTY
+#define BUCKETS     13                  // 1 us .. 4096 us
+#define GAP_US      10                  // "Back to back" threshold
+
+// By trace ID (common/trace.h); the controller, source 'C', reuses the
+// IDs of the slave-only vectors
+static const char *const slave_names[IDS] = {
+    "EUSCI_B1 (I2C master)", "USCI_B0 (I2C slave)", "TIMER0_B0", "TIMER1_B0 (BCM)",
+    "TIMER2_B0 (timers)", "ADC", "TIMER3_B1 (RGB)", "mark"
+};
+static const char *const controller_names[IDS] = {
+    "EUSCI_B1 (I2C master)", "EUSCI_A1 (telemetry)", "TIMER2_B1 (overflow)", "unused",
+    "TIMER2_B0 (timers)", "ADC", "TIMER3_B1 (RGB)", "mark"
+};
+
+typedef struct
+{
+    unsigned long runs;
+    unsigned long total;
+    unsigned int min, max;
+    unsigned long hist[BUCKETS];
+} isr_stats_t;
+
+static unsigned char crc8_update(unsigned char crc, unsigned char byte)
+{
+    int i;
+
+    crc ^= byte;
+    for (i = 0; i < 8; i++) {
+        crc = (crc & 0x80) ? (unsigned char)((crc << 1) ^ 0x07) : (unsigned char)(crc << 1);
+    }
+    return crc;
+}
+
+static int bucket(unsigned int us)
+{
+    int b = 0;
+
+    while (b < BUCKETS - 1 && us >= (2u << b)) {
+        b++;
+    }
+    return b;
+}
+
+static void decode(const unsigned int *entry, unsigned int count, unsigned int mhz, const char *const *names)
+{
+    isr_stats_t stats[IDS] = { { 0 } };
+    int open = -1;                      // ISR between enter and exit
+    unsigned int open_at = 0, last_exit = 0, now = 0, prev = 0;
+    unsigned long nested = 0, back_to_back = 0, boots = 0;
+    int have_prev = 0, have_exit = 0;
+    unsigned int i;
+    int id, b;
+
+    for (i = 0; i < IDS; i++) {
+        stats[i].min = 0xFFFF;
+    }
+    for (i = 0; i < count; i++) {
+        unsigned int e = entry[i];
+        unsigned int stamp = e & 0x0FFF;
+        int exit = (e >> 12) & 1;
+
+        if (e == EMPTY) {
+            continue;
+        }
+        id = e >> 13;
+        now += have_prev ? ((stamp - prev) & 0x0FFF) : 0;  // Ticks
+        prev = stamp;
+        have_prev = 1;
+        if (id == MARK) {               // Reset: nothing carries over
+            boots++;
+            open = -1;
+            have_exit = 0;
+            continue;
+        }
+        if (!exit) {
+            if (open >= 0) {
+                nested++;
+            } else if (have_exit && now - last_exit < GAP_US * mhz) {
+                back_to_back++;
+            }
+            open = id;
+            open_at = now;
+        } else if (open == id) {
+            unsigned int us = (now - open_at + mhz / 2) / mhz;
+            isr_stats_t *s = &stats[id];
+
+            s->runs++;
+            s->total += us;
+            s->min = us < s->min ? us : s->min;
+            s->max = us > s->max ? us : s->max;
+            s->hist[bucket(us)]++;
+            open = -1;
+            last_exit = now;
+            have_exit = 1;
+        }
+    }
+
+    printf("  %lu boot marks, %lu nested entries, %lu entries within %d us of an exit\n",
+           boots, nested, back_to_back, GAP_US);
+    printf("  %-22s %6s %6s %6s %6s   us: <2 <4 <8 <16 ...\n", "isr", "runs", "min", "avg", "max");
+    for (id = 0; id < MARK; id++) {
+        isr_stats_t *s = &stats[id];
+
+        if (s->runs == 0) {
+            continue;
+        }
+        printf("  %-22s %6lu %6u %6lu %6u  ", names[id], s->runs, s->min, s->total / s->runs, s->max);
+        for (b = 0; b <= bucket(s->max); b++) {
+            printf(" %lu", s->hist[b]);
+        }
+        printf("\n");
+    }
+}
+
+int main(int argc, char **argv)
+{
+    FILE *f;
+    int c, dumps = 0;
+
+    if (argc != 2) {
+        fprintf(stderr, "usage: %s <dump file>\n", argv[0]);
+        return 2;
+    }
+    f = fopen(argv[1], "rb");
+    if (!f) {
+        perror(argv[1]);
+        return 2;
+    }
+
+    // Scan for "TR" so line noise before or between dumps is skipped
+    while ((c = fgetc(f)) != EOF) {
+        int source, mhz, lo, hi;
+        unsigned int count, i;
+        unsigned int *entry;
+        unsigned char crc = 0;
+
+        if (c != 'T' || fgetc(f) != 'R') {
+            continue;
+        }
+        source = fgetc(f);
+        mhz = fgetc(f);
+        lo = fgetc(f);
+        hi = fgetc(f);
+        if (hi == EOF) {
+            break;
+        }
+        if (mhz <= 0) {
+            continue;
+        }
+        count = (unsigned int)(lo | hi << 8);
+        entry = malloc(count * sizeof(*entry));
+        for (i = 0; i < count; i++) {
+            lo = fgetc(f);
+            hi = fgetc(f);
+            if (hi == EOF) {
+                break;
+            }
+            entry[i] = (unsigned int)(lo | hi << 8);
+            crc = crc8_update(crc8_update(crc, (unsigned char)lo), (unsigned char)hi);
+        }
+        if (i < count || fgetc(f) != crc) {
+            fprintf(stderr, "dump from '%c': truncated or bad CRC, skipped\n", source);
+            free(entry);
+            continue;
+        }
+        printf("dump from '%c', %u entries, %d MHz stamps\n", source, count, mhz);
+        decode(entry, count, (unsigned int)mhz, source == 'C' ? controller_names : slave_names);
+        free(entry);
+        dumps++;
+    }
+    fclose(f);
+    return dumps == 0;
+}